@@ -4,6 +4,8 @@
 #include "interpret.hpp"
 #include "miniz/miniz.h"
 #include "sprite.hpp"
+#include "trace.hpp"
+#include "unzip.hpp"
 #include <string>
 #include <unordered_map>
 #ifdef __3DS__
@@ -67,6 +69,7 @@ SDL_Audio::~SDL_Audio() {
 }
 
 void SoundPlayer::startSoundLoaderThread(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed, const bool &fromProject) {
+    TRACE_SPAN("SoundPlayer::startSoundLoaderThread");
 #ifdef ENABLE_AUDIO
     if (!init()) return;
 
@@ -102,26 +105,12 @@ bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const st
         return false;
     }
 
-    int file_count = (int)mz_zip_reader_get_num_files(zip);
-    if (file_count <= 0) {
-        Log::logWarning("Error: No files found in zip archive");
-        return false;
-    }
-
-    for (int i = 0; i < file_count; i++) {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(zip, i, &file_stat)) {
-            continue;
-        }
-
-        std::string zipFileName = file_stat.m_filename;
-
-        if (zipFileName != soundId) {
-            continue;
-        }
+    const int file_index = Unzip::findFile(zip, soundId);
+    if (file_index >= 0) {
+        const std::string &zipFileName = soundId;
 
         size_t file_size;
-        void *file_data = mz_zip_reader_extract_to_heap(zip, i, &file_size, 0);
+        void *file_data = mz_zip_reader_extract_to_heap(zip, file_index, &file_size, 0);
         if (!file_data || file_size == 0) {
             Log::logWarning("Failed to extract: " + zipFileName);
             return false;
@@ -368,6 +357,7 @@ void SoundPlayer::freeAudio(const std::string &soundId) {
 }
 
 void SoundPlayer::flushAudio() {
+    TRACE_SPAN("SoundPlayer::flushAudio");
 #ifdef ENABLE_AUDIO
     if (SDL_Sounds.empty()) return;
     for (auto &[id, audio] : SDL_Sounds) {
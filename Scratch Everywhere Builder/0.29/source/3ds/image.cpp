@@ -1,6 +1,7 @@
 #include "image.hpp"
 #include "../scratch/math.hpp"
 #include "os.hpp"
+#include "trace.hpp"
 #include <algorithm>
 #include <string>
 #include <vector>
@@ -215,6 +216,9 @@ bool Image::loadImageFromFile(std::string filePath, Sprite *sprite, bool fromScr
     }
 
     bool success = get_C2D_Image(newRGBA);
+    if (success && fromScratchProject) {
+        images[path2].collisionMask = CollisionMask(newRGBA.data, newRGBA.width, newRGBA.height, newRGBA.width * 4, isSVG ? 1 : 2);
+    }
     stbi_image_free(newRGBA.data);
 
     return success;
@@ -231,7 +235,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
     if (images.find(imageId) != images.end()) return;
 
     // Find the file in the zip
-    int file_index = mz_zip_reader_locate_file(zip, costumeId.c_str(), nullptr, 0);
+    int file_index = Unzip::findFile(zip, costumeId);
     if (file_index < 0) {
         Log::logWarning("Image file not found in zip: " + costumeId);
         return;
@@ -312,11 +316,19 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
         sprite->spriteHeight = newRGBA.height / 2;
     }
 
-    get_C2D_Image(newRGBA);
+    if (get_C2D_Image(newRGBA)) {
+        images[imageId].collisionMask = CollisionMask(newRGBA.data, newRGBA.width, newRGBA.height, newRGBA.width * 4, isSVG ? 1 : 2);
+    }
     stbi_image_free(newRGBA.data);
     mz_free(file_data);
 }
 
+const CollisionMask *Image::getCollisionMask(const std::string &costumeId) {
+    auto it = images.find(costumeId);
+    if (it == images.end() || !it->second.collisionMask.isLoaded()) return nullptr;
+    return &it->second.collisionMask;
+}
+
 /**
  * Loads SVG data and converts it to RGBA pixel data
  */
@@ -571,6 +583,7 @@ void Image::queueFreeImage(const std::string &costumeId) {
  * or if a `C2D_Image` goes unused for 120 frames.
  */
 void Image::FlushImages() {
+    TRACE_SPAN("Image::FlushImages");
     std::vector<std::string> keysToDelete;
 
     // timer based freeing
@@ -1,4 +1,5 @@
 #pragma once
+#include "../scratch/collisionMask.hpp"
 #include "../scratch/image.hpp"
 #include <3ds.h>
 #include <citro2d.h>
@@ -16,6 +17,7 @@ struct ImageData {
     uint16_t width;
     uint16_t height;
     bool isSVG = false;
+    CollisionMask collisionMask;
 };
 
 struct imageRGBA {
@@ -151,7 +151,7 @@ void Input::getInput() {
             }
         }
         if (keyHeldFrames == 1 || keyHeldFrames > 13)
-            BlockExecutor::runAllBlocksByOpcode("event_whenkeypressed");
+            BlockExecutor::runKeyHats(inputButtons);
 
     } else {
         keyHeldFrames = 0;
@@ -313,7 +313,7 @@ void Render::renderSprites() {
             if (!currentSprite->visible) continue;
 
             int costumeIndex = 0;
-            for (const auto &costume : currentSprite->costumes) {
+            for (const auto &costume : currentSprite->data->costumes) {
                 if (costumeIndex == currentSprite->currentCostume) {
                     currentSprite->rotationCenterX = costume.rotationCenterX;
                     currentSprite->rotationCenterY = costume.rotationCenterY;
@@ -372,7 +372,7 @@ void Render::renderSprites() {
             if (!currentSprite->visible) continue;
 
             int costumeIndex = 0;
-            for (const auto &costume : currentSprite->costumes) {
+            for (const auto &costume : currentSprite->data->costumes) {
                 if (costumeIndex == currentSprite->currentCostume) {
                     currentSprite->rotationCenterX = costume.rotationCenterX;
                     currentSprite->rotationCenterY = costume.rotationCenterY;
@@ -427,7 +427,7 @@ void Render::renderSprites() {
             if (!currentSprite->visible) continue;
 
             int costumeIndex = 0;
-            for (const auto &costume : currentSprite->costumes) {
+            for (const auto &costume : currentSprite->data->costumes) {
                 if (costumeIndex == currentSprite->currentCostume) {
                     currentSprite->rotationCenterX = costume.rotationCenterX;
                     currentSprite->rotationCenterY = costume.rotationCenterY;
@@ -0,0 +1,171 @@
+// Headless benchmark runner. Runs a project for a fixed number of frames with turbo mode on,
+// then prints how much work the interpreter did as JSON on the last line of stdout.
+// Build with `-DSE_HEADLESS=ON -DSE_BENCHMARKS=ON` and run `se-bench <project.sb3> [frames] [checksum] [turbo budget] [warp time limit]`.
+// If a checksum from `se-workloads` is given, the exit code is 2 when the project ends in a different state.
+// Frames run one tick each, unless a turbo budget (a share of the frame, like 0.75) is given.
+// Scripts without screen refresh always finish in one frame, so the state after a given frame doesn't depend on timing,
+// unless a warp time limit (in milliseconds) is given to make them yield partway through.
+#include "../headless/render.hpp"
+#include "../scratch/blockExecutor.hpp"
+#include "../scratch/interpret.hpp"
+#include "../scratch/os.hpp"
+#include "../scratch/render.hpp"
+#include "../scratch/unzip.hpp"
+#include "checksum.hpp"
+#ifdef ENABLE_PROFILER
+#include "../scratch/profiler.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchStats {
+    size_t framesToRun = 0;
+    std::vector<double> frameTimes; // in milliseconds
+    size_t totalBlocksRun = 0;
+    size_t totalTicks = 0;
+    size_t maxTicksPerFrame = 0;
+    size_t clones = 0;
+    size_t peakClones = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point frameStart;
+    std::string checksum;
+};
+
+BenchStats stats;
+
+size_t countClones() {
+    size_t count = 0;
+    for (Sprite *sprite : sprites) {
+        if (sprite->isClone) count++;
+    }
+    return count;
+}
+
+void endFrame(bool countSprites) {
+    const auto now = std::chrono::steady_clock::now();
+    stats.frameTimes.push_back(std::chrono::duration<double, std::milli>(now - stats.frameStart).count());
+    stats.totalBlocksRun += blocksRun;
+    stats.totalTicks += Scratch::ticksPerFrame;
+    stats.maxTicksPerFrame = std::max(stats.maxTicksPerFrame, static_cast<size_t>(Scratch::ticksPerFrame));
+    if (countSprites) {
+        stats.clones = countClones();
+        stats.peakClones = std::max(stats.peakClones, stats.clones);
+    }
+}
+
+// `StateChecksum` of the Stage's variables and lists, which is where workloads leave their results
+std::string stageChecksum() {
+    StateChecksum checksum;
+    if (stageSprite == nullptr) return "";
+    for (const Variable &variable : stageSprite->variables) {
+        checksum.addVariable(variable.name, variable.value.asString());
+    }
+    for (const List &list : stageSprite->lists) {
+        std::vector<std::string> items;
+        items.reserve(list.items.size());
+        for (const Value &item : list.items) {
+            items.push_back(item.asString());
+        }
+        checksum.addList(list.name, items);
+    }
+    return checksum.hex();
+}
+
+// called before every frame, so everything here is about the frame that just finished
+bool onFrame() {
+    if (stats.started) endFrame(true);
+    if (stats.frameTimes.size() >= stats.framesToRun) {
+        // the project gets cleaned up as soon as the loop ends
+        stats.checksum = stageChecksum();
+        stats.started = false;
+        return false;
+    }
+    stats.started = true;
+    stats.frameStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <project.sb3> [frames] [checksum] [turbo budget] [warp time limit]\n", argv[0]);
+        return 1;
+    }
+    stats.framesToRun = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 600;
+    const std::string expectedChecksum = argc > 3 ? argv[3] : "";
+    const float turboFrameBudget = argc > 4 ? std::strtof(argv[4], nullptr) : 0.0f;
+    const int warpTimeLimit = argc > 5 ? std::max(0, std::atoi(argv[5])) : 0;
+
+    if (!Render::Init()) return 1;
+    srand(time(NULL));
+
+    Unzip::filePath = argv[1];
+    // a build that skips opening the project would otherwise benchmark nothing and still exit 0
+    if (!Unzip::load() || Unzip::projectOpened != 1) {
+        Log::logError("Failed to load project: " + Unzip::filePath);
+        Render::deInit();
+        return 1;
+    }
+    // the project's own config can turn turbo mode off, so set it after loading
+    Scratch::turbo = true;
+    Scratch::turboFrameBudget = turboFrameBudget;
+    Scratch::warpTimeLimit = warpTimeLimit;
+
+    headlessFrameCallback = onFrame;
+    const auto start = std::chrono::steady_clock::now();
+    // green flag scripts start running before the project loop does, so count that as the first frame
+    stats.started = true;
+    stats.frameStart = start;
+    Scratch::startScratchProject();
+    // the project stopped itself partway through a frame. Its sprites may already be cleaned up, so keep the last clone count
+    if (stats.started) {
+        endFrame(false);
+        stats.checksum = stageChecksum();
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    headlessFrameCallback = nullptr;
+
+    std::vector<double> sorted = stats.frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double frameSum = 0;
+    for (double frameTime : sorted) {
+        frameSum += frameTime;
+    }
+    const double meanMs = sorted.empty() ? 0 : frameSum / sorted.size();
+
+    nlohmann::json result = {
+        {"project", Unzip::filePath},
+        {"frames", sorted.size()},
+        {"totalMs", totalMs},
+        {"blocksRun", stats.totalBlocksRun},
+        {"ticks", stats.totalTicks},
+        {"ticksPerFrame", {{"mean", sorted.empty() ? 0 : static_cast<double>(stats.totalTicks) / sorted.size()}, {"max", stats.maxTicksPerFrame}}},
+        {"frameMs", {{"mean", meanMs}, {"p50", percentile(sorted, 0.5)}, {"p90", percentile(sorted, 0.9)}, {"p99", percentile(sorted, 0.99)}, {"max", sorted.empty() ? 0 : sorted.back()}}},
+        {"clones", stats.clones},
+        {"peakClones", stats.peakClones},
+        {"peakMemoryBytes", MemoryTracker::getPeakUsage()},
+        {"checksum", stats.checksum}};
+    if (!expectedChecksum.empty()) result["checksumMatches"] = stats.checksum == expectedChecksum;
+#ifdef ENABLE_PROFILER
+    result["profile"] = Profiler::toJson();
+#endif
+    std::printf("%s\n", result.dump().c_str());
+
+    Render::deInit();
+    return !expectedChecksum.empty() && stats.checksum != expectedChecksum ? 2 : 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Checksum of every variable and list on the Stage at the end of a benchmark workload.
+ * The workload generator builds one from the values a workload should end with, and `se-bench` builds one
+ * from the values the project actually ended with, so every benchmark run doubles as a correctness check.
+ * Values are compared in their Scratch string form, so `5` and `5.0` are the same but `5` and `"05"` aren't.
+ */
+class StateChecksum {
+  public:
+    void addVariable(const std::string &name, const std::string &value) {
+        entries["variable " + name] = value;
+    }
+
+    void addList(const std::string &name, const std::vector<std::string> &items) {
+        std::string joined;
+        for (const std::string &item : items) {
+            joined += item;
+            joined += '\x1f';
+        }
+        entries["list " + name] = std::move(joined);
+    }
+
+    /**
+     * 64 bit FNV-1a of every entry, in name order.
+     * @return The checksum as 16 hex digits.
+     */
+    std::string hex() const {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        auto feed = [&hash](const std::string &text) {
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 0x100000001b3ULL;
+            }
+            hash ^= 0xff; // separator, so "ab" + "c" and "a" + "bc" differ
+            hash *= 0x100000001b3ULL;
+        };
+        for (const auto &[name, value] : entries) {
+            feed(name);
+            feed(value);
+        }
+
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+        return buffer;
+    }
+
+  private:
+    std::map<std::string, std::string> entries;
+};
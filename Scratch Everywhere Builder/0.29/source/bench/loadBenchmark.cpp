@@ -0,0 +1,160 @@
+// Load-time benchmark for project.json. Loads a project's sprites with both `loadSprites()` (parsing the whole
+// file into json first) and `streamSprites()` (SAX), and prints how long each took and how much heap it peaked at as JSON.
+// Build with `-DSE_HEADLESS=ON -DSE_BENCHMARKS=ON` and run `se-load-bench <project.sb3 | project.json> [runs]`.
+#include "../headless/render.hpp"
+#include "../scratch/interpret.hpp"
+#include "../scratch/render.hpp"
+#include "../scratch/unzip.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace {
+
+// heap in use through `operator new`, and the most it's been since `resetPeak()`
+size_t heapInUse = 0;
+size_t heapPeak = 0;
+
+// every allocation is prefixed with its size, padded so the block stays aligned
+constexpr size_t headerSize = alignof(std::max_align_t);
+
+void *allocate(size_t size) {
+    void *block = std::malloc(size + headerSize);
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<size_t *>(block) = size;
+    heapInUse += size;
+    heapPeak = std::max(heapPeak, heapInUse);
+    return static_cast<char *>(block) + headerSize;
+}
+
+void deallocate(void *ptr) {
+    if (ptr == nullptr) return;
+    void *block = static_cast<char *>(ptr) - headerSize;
+    heapInUse -= *static_cast<size_t *>(block);
+    std::free(block);
+}
+
+void resetPeak() {
+    heapPeak = heapInUse;
+}
+
+struct LoadStats {
+    double bestMs = 0;
+    size_t peakHeapBytes = 0;
+    size_t sprites = 0;
+    size_t blocks = 0;
+};
+
+bool readFile(const std::string &path, std::string &contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool readProjectJson(const std::string &path, std::string &json) {
+    if (path.size() < 4 || path.substr(path.size() - 4) != ".sb3") return readFile(path, json);
+
+    mz_zip_archive zip;
+    memset(&zip, 0, sizeof(zip));
+    if (!mz_zip_reader_init_file(&zip, path.c_str(), 0)) return false;
+    size_t size = 0;
+    void *data = mz_zip_reader_extract_file_to_heap(&zip, "project.json", &size, 0);
+    mz_zip_reader_end(&zip);
+    if (data == nullptr) return false;
+    json.assign(static_cast<const char *>(data), size);
+    mz_free(data);
+    return true;
+}
+
+// loads the project with `load`, then records how it went and cleans it up for the next run
+template <typename Load>
+bool measure(LoadStats &stats, Load load) {
+    resetPeak();
+    const size_t heapBefore = heapInUse;
+    const auto start = std::chrono::steady_clock::now();
+    if (!load()) return false;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    stats.bestMs = stats.bestMs == 0 ? ms : std::min(stats.bestMs, ms);
+    stats.peakHeapBytes = std::max(stats.peakHeapBytes, heapPeak - heapBefore);
+    stats.sprites = sprites.size();
+    stats.blocks = 0;
+    for (Sprite *sprite : sprites) {
+        stats.blocks += sprite->data->blocks.size();
+    }
+    Scratch::cleanupScratchProject();
+    return true;
+}
+
+nlohmann::json toJson(const LoadStats &stats) {
+    return {{"ms", stats.bestMs}, {"peakHeapBytes", stats.peakHeapBytes}, {"sprites", stats.sprites}, {"blocks", stats.blocks}};
+}
+
+} // namespace
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { deallocate(ptr); }
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <project.sb3 | project.json> [runs]\n", argv[0]);
+        return 1;
+    }
+    const int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::string json;
+    if (!readProjectJson(argv[1], json)) {
+        std::fprintf(stderr, "Failed to read project.json from %s\n", argv[1]);
+        return 1;
+    }
+    if (!Render::Init()) return 1;
+    // the text is already in memory, so there's no zip for cleanup to close
+    projectType = UNZIPPED;
+
+    LoadStats dom;
+    LoadStats sax;
+    for (int run = 0; run < runs; run++) {
+        const bool loaded = measure(dom, [&] {
+            try {
+                loadSprites(nlohmann::json::parse(json));
+            } catch (const std::exception &e) {
+                Log::logError(std::string("Failed to load project.json: ") + e.what());
+                return false;
+            }
+            return true;
+        }) && measure(sax, [&] {
+            // set like `Unzip::openScratchProject()` does, since this loads project.json without it
+            Unzip::projectOpened = streamSprites(json) ? 1 : -2;
+            return Unzip::projectOpened == 1;
+        });
+        if (!loaded || Unzip::projectOpened != 1) {
+            std::fprintf(stderr, "Failed to load %s\n", argv[1]);
+            Render::deInit();
+            return 1;
+        }
+    }
+
+    nlohmann::json result = {
+        {"project", argv[1]},
+        {"jsonBytes", json.size()},
+        {"runs", runs},
+        {"dom", toJson(dom)},
+        {"sax", toJson(sax)}};
+    std::printf("%s\n", result.dump().c_str());
+
+    Render::deInit();
+    return 0;
+}
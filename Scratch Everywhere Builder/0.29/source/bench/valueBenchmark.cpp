@@ -0,0 +1,61 @@
+// Micro-benchmark for converting list contents to numbers with `Value::asDouble()`.
+// Build with `-DSE_BENCHMARKS=ON` and run `se-value-bench [items] [passes]`.
+#include "value.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+namespace {
+
+// what lists in projects usually hold: numbers saved as strings, with the odd bit of text
+const char *const listContents[] = {"1", "2.5", "-3", "100", "0.125", "hello", "42", "1e3", " 7 ", "3.14159265358979", "-0.5", "item", "12345.67", "-123.456"};
+
+double runPasses(const std::vector<Value> &items, int passes, double &sum) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (const Value &item : items) {
+            // `item of list` hands out a copy, so measure that too
+            Value copy = item;
+            sum += copy.asDouble();
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    return totalNs / (static_cast<double>(items.size()) * passes);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const size_t itemCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const int passes = argc > 2 ? std::atoi(argv[2]) : 50;
+    const size_t contentCount = sizeof(listContents) / sizeof(listContents[0]);
+
+    // loaded from project.json
+    nlohmann::json jsonList = nlohmann::json::array();
+    for (size_t i = 0; i < itemCount; i++) {
+        jsonList.push_back(listContents[i % contentCount]);
+    }
+    std::vector<Value> loaded;
+    loaded.reserve(itemCount);
+    for (const auto &item : jsonList) {
+        loaded.push_back(Value::fromJson(item));
+    }
+
+    // added while the project is running (e.g. with `add (join ...) to list`)
+    std::vector<Value> added;
+    added.reserve(itemCount);
+    for (size_t i = 0; i < itemCount; i++) {
+        added.push_back(Value(std::string(listContents[i % contentCount])));
+    }
+
+    double sum = 0;
+    const double loadedNs = runPasses(loaded, passes, sum);
+    const double addedNs = runPasses(added, passes, sum);
+
+    std::printf("{\"items\": %zu, \"passes\": %d, \"loadedNsPerItem\": %.2f, \"addedNsPerItem\": %.2f, \"checksum\": %.1f}\n",
+                itemCount, passes, loadedNs, addedNs, sum);
+    return 0;
+}
@@ -0,0 +1,28 @@
+// Writes every benchmark workload as an .sb3, plus a workloads.json listing each one's expected checksum.
+// Build with `-DSE_BENCHMARKS=ON` and run `se-workloads [outputDir]`, then run each one with
+// `se-bench <outputDir>/<name>.sb3 <frames> <checksum> 0 <warpTimeLimit>`.
+#include "workloads.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+int main(int argc, char **argv) {
+    const std::filesystem::path outputDir = argc > 1 ? argv[1] : "workloads";
+    std::error_code error;
+    std::filesystem::create_directories(outputDir, error);
+
+    nlohmann::json manifest = nlohmann::json::array();
+    for (const Workload &workload : Workloads::generate()) {
+        const std::filesystem::path path = outputDir / (workload.name + ".sb3");
+        if (!Workloads::writeSb3(workload, path.string())) {
+            std::fprintf(stderr, "Failed to write %s\n", path.string().c_str());
+            return 1;
+        }
+        manifest.push_back({{"name", workload.name}, {"description", workload.description}, {"file", path.filename().string()}, {"frames", workload.frames}, {"checksum", workload.checksum}, {"warpTimeLimit", workload.warpTimeLimit}});
+        std::printf("%s: %s\n", workload.name.c_str(), workload.checksum.c_str());
+    }
+
+    std::ofstream manifestFile(outputDir / "workloads.json");
+    manifestFile << manifest.dump(4) << std::endl;
+    return manifestFile ? 0 : 1;
+}
@@ -0,0 +1,538 @@
+#include "workloads.hpp"
+#include "checksum.hpp"
+#include <algorithm>
+#include <cstring>
+#include <miniz.h>
+
+using nlohmann::json;
+
+namespace {
+
+// a filled square, so collision masks have pixels in them
+const char *const costumeSvg = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"6\" height=\"6\"><rect width=\"6\" height=\"6\" fill=\"#000\"/></svg>";
+const char *const costumeMd5 = "89ffef6596b7adc28718b97261511973";
+
+std::string variableId(const std::string &name) {
+    return "var_" + name;
+}
+
+std::string listId(const std::string &name) {
+    return "list_" + name;
+}
+
+std::string broadcastId(const std::string &name) {
+    return "broadcast_" + name;
+}
+
+// Builds the `blocks` of one target, the same way the Scratch editor lays them out in project.json
+class ScriptBuilder {
+  public:
+    explicit ScriptBuilder(std::string prefix) : prefix(std::move(prefix)) {}
+
+    json blocks = json::object();
+
+    std::string add(const std::string &opcode, json inputs = json::object(), json fields = json::object(), bool shadow = false) {
+        const std::string id = prefix + std::to_string(nextId++);
+        for (auto &[name, input] : inputs.items()) {
+            // [1, "blockId"], [2, "blockId"] or [3, "blockId", shadow]
+            if (input.is_array() && input.size() >= 2 && input[1].is_string()) {
+                const std::string child = input[1].get<std::string>();
+                if (blocks.contains(child)) blocks[child]["parent"] = id;
+            }
+        }
+        blocks[id] = {{"opcode", opcode}, {"next", nullptr}, {"parent", nullptr}, {"inputs", inputs}, {"fields", fields}, {"shadow", shadow}, {"topLevel", false}};
+        return id;
+    }
+
+    // links `ids` with `next`, returning the first one
+    std::string chain(const std::vector<std::string> &ids) {
+        for (size_t i = 0; i + 1 < ids.size(); i++) {
+            blocks[ids[i]]["next"] = ids[i + 1];
+            blocks[ids[i + 1]]["parent"] = ids[i];
+        }
+        return ids.empty() ? "" : ids[0];
+    }
+
+    std::string hat(const std::string &opcode, const std::vector<std::string> &body, json fields = json::object()) {
+        const std::string id = add(opcode, json::object(), fields);
+        blocks[id]["topLevel"] = true;
+        blocks[id]["x"] = 0;
+        blocks[id]["y"] = 0;
+        std::vector<std::string> script = {id};
+        script.insert(script.end(), body.begin(), body.end());
+        chain(script);
+        return id;
+    }
+
+    std::string whenReceived(const std::string &broadcast, const std::vector<std::string> &body) {
+        return hat("event_whenbroadcastreceived", body, {{"BROADCAST_OPTION", {broadcast, broadcastId(broadcast)}}});
+    }
+
+    // C blocks like `repeat` and `if else`
+    std::string cBlock(const std::string &opcode, json inputs, const std::vector<std::string> &substack, const std::vector<std::string> &substack2 = {}) {
+        if (!substack.empty()) inputs["SUBSTACK"] = {2, chain(substack)};
+        if (!substack2.empty()) inputs["SUBSTACK2"] = {2, chain(substack2)};
+        return add(opcode, inputs);
+    }
+
+    // inputs
+    static json number(long long val) {
+        return {1, {4, std::to_string(val)}};
+    }
+    static json text(const std::string &val) {
+        return {1, {10, val}};
+    }
+    static json reporter(const std::string &blockId) {
+        return {3, blockId, {4, ""}};
+    }
+    static json condition(const std::string &blockId) {
+        return {2, blockId};
+    }
+    static json variable(const std::string &name) {
+        return {3, {12, name, variableId(name)}, {4, ""}};
+    }
+    static json broadcast(const std::string &name) {
+        return {1, {11, name, broadcastId(name)}};
+    }
+    static json variableField(const std::string &name) {
+        return {{"VARIABLE", {name, variableId(name)}}};
+    }
+    static json listField(const std::string &name) {
+        return {{"LIST", {name, listId(name)}}};
+    }
+
+    // common blocks
+    std::string setVariable(const std::string &name, json value) {
+        return add("data_setvariableto", {{"VALUE", value}}, variableField(name));
+    }
+    std::string changeVariable(const std::string &name, json value) {
+        return add("data_changevariableby", {{"VALUE", value}}, variableField(name));
+    }
+    json op(const std::string &opcode, json inputs, json fields = json::object()) {
+        return reporter(add(opcode, inputs, fields));
+    }
+    json binary(const std::string &opcode, json left, json right) {
+        return op(opcode, {{"NUM1", left}, {"NUM2", right}});
+    }
+    json compare(const std::string &opcode, json left, json right) {
+        return condition(add(opcode, {{"OPERAND1", left}, {"OPERAND2", right}}));
+    }
+    json itemOf(const std::string &list, json index) {
+        return op("data_itemoflist", {{"INDEX", index}}, listField(list));
+    }
+    std::string stopAll() {
+        return add("control_stop", json::object(), {{"STOP_OPTION", {"all", nullptr}}});
+    }
+    json touching(const std::string &object) {
+        const std::string menu = add("sensing_touchingobjectmenu", json::object(), {{"TOUCHINGOBJECTMENU", {object, nullptr}}}, true);
+        return condition(add("sensing_touchingobject", {{"TOUCHINGOBJECTMENU", {1, menu}}}));
+    }
+    std::string createCloneOfMyself() {
+        const std::string menu = add("control_create_clone_of_menu", json::object(), {{"CLONE_OPTION", {"_myself_", nullptr}}}, true);
+        return add("control_create_clone_of", {{"CLONE_OPTION", {1, menu}}});
+    }
+
+    // custom blocks, with one `%s` per argument in `proccode`
+    std::string define(const std::string &proccode, const std::vector<std::string> &arguments, bool warp, const std::vector<std::string> &body) {
+        std::vector<std::string> ids;
+        for (const std::string &argument : arguments) {
+            ids.push_back("arg_" + argument);
+        }
+        const std::string prototype = add("procedures_prototype", json::object(), json::object(), true);
+        blocks[prototype]["mutation"] = {{"tagName", "mutation"}, {"children", json::array()}, {"proccode", proccode}, {"argumentids", json(ids).dump()}, {"argumentnames", json(arguments).dump()}, {"argumentdefaults", json(std::vector<std::string>(arguments.size(), "")).dump()}, {"warp", warp ? "true" : "false"}};
+        const std::string definition = add("procedures_definition", {{"custom_block", {1, prototype}}});
+        blocks[definition]["topLevel"] = true;
+        blocks[definition]["x"] = 0;
+        blocks[definition]["y"] = 0;
+        std::vector<std::string> script = {definition};
+        script.insert(script.end(), body.begin(), body.end());
+        chain(script);
+        return definition;
+    }
+    std::string call(const std::string &proccode, const std::vector<std::pair<std::string, json>> &arguments = {}) {
+        json inputs = json::object();
+        std::vector<std::string> ids;
+        for (const auto &[name, value] : arguments) {
+            inputs["arg_" + name] = value;
+            ids.push_back("arg_" + name);
+        }
+        const std::string id = add("procedures_call", inputs);
+        blocks[id]["mutation"] = {{"tagName", "mutation"}, {"children", json::array()}, {"proccode", proccode}, {"argumentids", json(ids).dump()}, {"warp", "false"}};
+        return id;
+    }
+    json argument(const std::string &name) {
+        return reporter(add("argument_reporter_string_number", json::object(), {{"VALUE", {name, nullptr}}}));
+    }
+
+  private:
+    std::string prefix;
+    int nextId = 0;
+};
+
+json costumes() {
+    return json::array({{{"name", "costume1"}, {"bitmapResolution", 1}, {"dataFormat", "svg"}, {"assetId", costumeMd5}, {"md5ext", std::string(costumeMd5) + ".svg"}, {"rotationCenterX", 3}, {"rotationCenterY", 3}}});
+}
+
+json declareVariables(const std::vector<std::string> &names) {
+    json variables = json::object();
+    for (const std::string &name : names) {
+        variables[variableId(name)] = {name, 0};
+    }
+    return variables;
+}
+
+json declareLists(const std::vector<std::string> &names) {
+    json lists = json::object();
+    for (const std::string &name : names) {
+        lists[listId(name)] = {name, json::array()};
+    }
+    return lists;
+}
+
+struct ProjectSpec {
+    ScriptBuilder stage{"stage_"};
+    ScriptBuilder sprite{"sprite_"};
+    std::vector<std::string> stageVariables;
+    std::vector<std::string> stageLists;
+    std::vector<std::string> spriteVariables;
+    std::vector<std::string> broadcasts;
+    std::vector<std::string> extensions;
+    json config; // TurboWarp's advanced settings, if any
+};
+
+json buildProject(const ProjectSpec &spec) {
+    json broadcasts = json::object();
+    for (const std::string &name : spec.broadcasts) {
+        broadcasts[broadcastId(name)] = name;
+    }
+
+    json comments = json::object();
+    if (!spec.config.is_null()) {
+        // the same comment TurboWarp leaves on the Stage, which `loadSprites()` reads the settings out of
+        std::string settings = spec.config.dump();
+        const std::string infinityMarker = "\"Infinity\"";
+        for (size_t pos = settings.find(infinityMarker); pos != std::string::npos; pos = settings.find(infinityMarker))
+            settings.replace(pos, infinityMarker.size(), "Infinity");
+        comments["config"] = {{"blockId", nullptr}, {"x", 0}, {"y", 0}, {"width", 200}, {"height", 200}, {"minimized", false},
+                              {"text", "Configuration for https://turbowarp.org/\nYou can move, resize, and minimize this comment, but don't edit it by hand. This comment can be deleted to remove the stored settings.\n" + settings + " // _twconfig_"}};
+    }
+
+    json stage = {{"isStage", true}, {"name", "Stage"}, {"variables", declareVariables(spec.stageVariables)}, {"lists", declareLists(spec.stageLists)}, {"broadcasts", broadcasts}, {"blocks", spec.stage.blocks}, {"comments", comments}, {"currentCostume", 0}, {"costumes", costumes()}, {"sounds", json::array()}, {"volume", 100}, {"layerOrder", 0}};
+    json sprite = {{"isStage", false}, {"name", "Worker"}, {"variables", declareVariables(spec.spriteVariables)}, {"lists", json::object()}, {"broadcasts", json::object()}, {"blocks", spec.sprite.blocks}, {"comments", json::object()}, {"currentCostume", 0}, {"costumes", costumes()}, {"sounds", json::array()}, {"volume", 100}, {"layerOrder", 1}, {"visible", true}, {"x", 0}, {"y", 0}, {"size", 100}, {"direction", 90}, {"draggable", false}, {"rotationStyle", "all around"}};
+    return {{"targets", {stage, sprite}}, {"monitors", json::array()}, {"extensions", spec.extensions}, {"meta", {{"semver", "3.0.0"}, {"vm", "0.2.0"}, {"agent", "se-workloads"}}}};
+}
+
+} // namespace
+
+std::vector<Workload> Workloads::generate() {
+    return {
+        cloneChurn(20, 1000),
+        nestedCalls(64, 500),
+        listSort(200000),
+        broadcastPingPong(5000),
+        penDrawing(20000, 200),
+        stringBuilding(20000),
+        touchingClones(1000, 100, 100),
+        warpYields(20, 20, 500)};
+}
+
+Workload Workloads::cloneChurn(int rounds, int clonesPerRound) {
+    ProjectSpec spec;
+    spec.stageVariables = {"spawned", "alive", "target"};
+    spec.config = {{"framerate", 30}, {"runtimeOptions", {{"maxClones", "Infinity"}, {"miscLimits", true}, {"fencing", true}}}};
+    ScriptBuilder &s = spec.sprite;
+
+    // every clone lives for one frame
+    s.hat("control_start_as_clone", {s.changeVariable("spawned", s.number(1)), s.changeVariable("alive", s.number(1)),
+                                     s.add("control_wait", {{"DURATION", s.number(0)}}),
+                                     s.changeVariable("alive", s.number(-1)), s.add("control_delete_this_clone")});
+
+    const json finished = s.condition(s.add("operator_and", {{"OPERAND1", s.compare("operator_equals", s.variable("spawned"), s.variable("target"))},
+                                                             {"OPERAND2", s.compare("operator_equals", s.variable("alive"), s.number(0))}}));
+    // in warp, so every clone of a round is created in the same frame
+    s.define("spawn clones", {}, true, {s.cBlock("control_repeat", {{"TIMES", s.number(clonesPerRound)}}, {s.createCloneOfMyself()})});
+    s.hat("event_whenflagclicked", {s.cBlock("control_repeat", {{"TIMES", s.number(rounds)}}, {s.changeVariable("target", s.number(clonesPerRound)), s.call("spawn clones"), s.add("control_wait_until", {{"CONDITION", finished}})}),
+                                    s.stopAll()});
+
+    StateChecksum expected;
+    expected.addVariable("spawned", std::to_string(rounds * clonesPerRound));
+    expected.addVariable("alive", "0");
+    expected.addVariable("target", std::to_string(rounds * clonesPerRound));
+    return {"cloneChurn", "Spawns " + std::to_string(clonesPerRound) + " clones at once that delete themselves a frame later, " + std::to_string(rounds) + " times.",
+            buildProject(spec), expected.hex(), static_cast<size_t>(rounds) * 10};
+}
+
+Workload Workloads::nestedCalls(int depth, int calls) {
+    ProjectSpec spec;
+    spec.stageVariables = {"total", "entered"};
+    spec.spriteVariables = {"i"};
+    ScriptBuilder &s = spec.sprite;
+
+    // Custom blocks can't call themselves yet (their arguments are stored per sprite, not per call),
+    // so the chain is made of `depth` different blocks, each calling the next one
+    auto level = [](int index) {
+        return "level " + std::to_string(index) + " %s";
+    };
+    for (int index = 0; index < depth; index++) {
+        std::vector<std::string> body = {s.changeVariable("total", s.argument("n")), s.changeVariable("entered", s.number(1))};
+        if (index + 1 < depth) body.push_back(s.call(level(index + 1), {{"n", s.binary("operator_add", s.argument("n"), s.number(index))}}));
+        s.define(level(index), {"n"}, true, body);
+    }
+    s.hat("event_whenflagclicked", {s.setVariable("i", s.number(0)),
+                                    s.cBlock("control_repeat", {{"TIMES", s.number(calls)}}, {s.call(level(0), {{"n", s.variable("i")}}), s.changeVariable("i", s.number(1))}),
+                                    s.stopAll()});
+
+    long long total = 0;
+    for (int call = 0; call < calls; call++) {
+        long long n = call;
+        for (int index = 0; index < depth; index++) {
+            total += n;
+            n += index;
+        }
+    }
+
+    StateChecksum expected;
+    expected.addVariable("total", std::to_string(total));
+    expected.addVariable("entered", std::to_string(static_cast<long long>(depth) * calls));
+    return {"nestedCalls", "Calls a chain of " + std::to_string(depth) + " warp custom blocks " + std::to_string(calls) + " times, each passing an argument to the next.",
+            buildProject(spec), expected.hex(), static_cast<size_t>(calls) * 2 + 10};
+}
+
+Workload Workloads::listSort(int items) {
+    ProjectSpec spec;
+    spec.stageLists = {"numbers", "merged"};
+    spec.spriteVariables = {"seed", "width", "lo", "mid", "hi", "i", "j", "k"};
+    ScriptBuilder &s = spec.sprite;
+
+    // Park-Miller, so every step stays exact in a double
+    s.define("fill", {}, true,
+             {s.add("data_deletealloflist", json::object(), s.listField("numbers")), s.setVariable("seed", s.number(12345)),
+              s.cBlock("control_repeat", {{"TIMES", s.number(items)}},
+                       {s.setVariable("seed", s.binary("operator_mod", s.binary("operator_multiply", s.variable("seed"), s.number(16807)), s.number(2147483647))),
+                        s.add("data_addtolist", {{"ITEM", s.variable("seed")}}, s.listField("numbers"))})});
+
+    // bottom up merge sort, merging runs of `width` from `numbers` into `merged` then copying them back
+    auto endOfRun = [&](const std::string &variable, long long runs) {
+        // set variable to min(lo + runs * width, length + 1)
+        const json end = s.binary("operator_add", s.variable("lo"), s.binary("operator_multiply", s.variable("width"), s.number(runs)));
+        const json length = s.binary("operator_add", s.op("data_lengthoflist", json::object(), s.listField("numbers")), s.number(1));
+        return std::vector<std::string>{s.setVariable(variable, end),
+                                        s.cBlock("control_if", {{"CONDITION", s.compare("operator_gt", s.variable(variable), length)}}, {s.setVariable(variable, s.binary("operator_add", s.op("data_lengthoflist", json::object(), s.listField("numbers")), s.number(1)))})};
+    };
+    std::vector<std::string> mergeRuns = endOfRun("mid", 1);
+    for (const std::string &block : endOfRun("hi", 2))
+        mergeRuns.push_back(block);
+
+    const json takeLeft = s.condition(s.add("operator_or", {{"OPERAND1", s.compare("operator_equals", s.variable("j"), s.variable("hi"))},
+                                                            {"OPERAND2", s.condition(s.add("operator_and", {{"OPERAND1", s.compare("operator_lt", s.variable("i"), s.variable("mid"))},
+                                                                                                            {"OPERAND2", s.condition(s.add("operator_not", {{"OPERAND", s.compare("operator_lt", s.itemOf("numbers", s.variable("j")), s.itemOf("numbers", s.variable("i")))}}))}}))}}));
+    mergeRuns.push_back(s.setVariable("i", s.variable("lo")));
+    mergeRuns.push_back(s.setVariable("j", s.variable("mid")));
+    mergeRuns.push_back(s.cBlock("control_repeat", {{"TIMES", s.binary("operator_subtract", s.variable("hi"), s.variable("lo"))}},
+                                 {s.cBlock("control_if_else", {{"CONDITION", takeLeft}},
+                                           {s.add("data_addtolist", {{"ITEM", s.itemOf("numbers", s.variable("i"))}}, s.listField("merged")), s.changeVariable("i", s.number(1))},
+                                           {s.add("data_addtolist", {{"ITEM", s.itemOf("numbers", s.variable("j"))}}, s.listField("merged")), s.changeVariable("j", s.number(1))})}));
+    mergeRuns.push_back(s.setVariable("lo", s.variable("hi")));
+
+    const json sortedAll = s.compare("operator_gt", s.variable("width"), s.op("data_lengthoflist", json::object(), s.listField("numbers")));
+    const json mergedAll = s.compare("operator_gt", s.variable("lo"), s.op("data_lengthoflist", json::object(), s.listField("numbers")));
+    s.define("sort", {}, true,
+             {s.setVariable("width", s.number(1)),
+              s.cBlock("control_repeat_until", {{"CONDITION", sortedAll}},
+                       {s.add("data_deletealloflist", json::object(), s.listField("merged")), s.setVariable("lo", s.number(1)),
+                        s.cBlock("control_repeat_until", {{"CONDITION", mergedAll}}, mergeRuns),
+                        s.setVariable("k", s.number(1)),
+                        s.cBlock("control_repeat", {{"TIMES", s.op("data_lengthoflist", json::object(), s.listField("merged"))}},
+                                 {s.add("data_replaceitemoflist", {{"INDEX", s.variable("k")}, {"ITEM", s.itemOf("merged", s.variable("k"))}}, s.listField("numbers")), s.changeVariable("k", s.number(1))}),
+                        s.setVariable("width", s.binary("operator_multiply", s.variable("width"), s.number(2)))}),
+              s.add("data_deletealloflist", json::object(), s.listField("merged"))});
+    s.hat("event_whenflagclicked", {s.call("fill"), s.call("sort"), s.stopAll()});
+
+    std::vector<long long> numbers;
+    numbers.reserve(items);
+    long long seed = 12345;
+    for (int i = 0; i < items; i++) {
+        seed = seed * 16807 % 2147483647;
+        numbers.push_back(seed);
+    }
+    std::sort(numbers.begin(), numbers.end());
+    std::vector<std::string> sorted;
+    sorted.reserve(items);
+    for (long long number : numbers) {
+        sorted.push_back(std::to_string(number));
+    }
+
+    StateChecksum expected;
+    expected.addList("numbers", sorted);
+    expected.addList("merged", {});
+    return {"listSort", "Fills a list with " + std::to_string(items) + " pseudo random numbers and merge sorts it in a warp custom block.",
+            buildProject(spec), expected.hex(), 10};
+}
+
+Workload Workloads::broadcastPingPong(int rounds) {
+    ProjectSpec spec;
+    spec.stageVariables = {"pings", "pongs"};
+    spec.broadcasts = {"ping", "pong"};
+
+    ScriptBuilder &stage = spec.stage;
+    stage.whenReceived("ping", {stage.changeVariable("pings", stage.number(1)), stage.add("event_broadcastandwait", {{"BROADCAST_INPUT", stage.broadcast("pong")}})});
+
+    ScriptBuilder &s = spec.sprite;
+    s.whenReceived("pong", {s.changeVariable("pongs", s.number(1))});
+    s.hat("event_whenflagclicked", {s.cBlock("control_repeat", {{"TIMES", s.number(rounds)}}, {s.add("event_broadcastandwait", {{"BROADCAST_INPUT", s.broadcast("ping")}})}), s.stopAll()});
+
+    StateChecksum expected;
+    expected.addVariable("pings", std::to_string(rounds));
+    expected.addVariable("pongs", std::to_string(rounds));
+    return {"broadcastPingPong", "The Stage and a sprite broadcast and wait for each other " + std::to_string(rounds) + " times.",
+            buildProject(spec), expected.hex(), static_cast<size_t>(rounds) * 4 + 10};
+}
+
+Workload Workloads::penDrawing(int lines, int linesPerFrame) {
+    ProjectSpec spec;
+    spec.stageVariables = {"drawn", "xSum", "ySum"};
+    spec.extensions = {"pen"};
+    ScriptBuilder &s = spec.sprite;
+
+    const json x = s.binary("operator_subtract", s.binary("operator_mod", s.binary("operator_multiply", s.variable("drawn"), s.number(37)), s.number(400)), s.number(200));
+    const json y = s.binary("operator_subtract", s.binary("operator_mod", s.binary("operator_multiply", s.variable("drawn"), s.number(91)), s.number(300)), s.number(150));
+    s.define("draw lines", {}, true,
+             {s.cBlock("control_repeat", {{"TIMES", s.number(linesPerFrame)}},
+                       {s.add("motion_gotoxy", {{"X", x}, {"Y", y}}),
+                        s.changeVariable("xSum", s.op("motion_xposition", json::object())),
+                        s.changeVariable("ySum", s.op("motion_yposition", json::object())),
+                        s.changeVariable("drawn", s.number(1))})});
+    s.hat("event_whenflagclicked", {s.add("pen_clear"), s.add("pen_setPenSizeTo", {{"SIZE", s.number(2)}}), s.add("pen_penDown"),
+                                    s.cBlock("control_repeat", {{"TIMES", s.number(lines / linesPerFrame)}}, {s.call("draw lines")}),
+                                    s.add("pen_penUp"), s.stopAll()});
+
+    const int drawn = lines / linesPerFrame * linesPerFrame;
+    long long xSum = 0;
+    long long ySum = 0;
+    for (int i = 0; i < drawn; i++) {
+        xSum += static_cast<long long>(i) * 37 % 400 - 200;
+        ySum += static_cast<long long>(i) * 91 % 300 - 150;
+    }
+
+    StateChecksum expected;
+    expected.addVariable("drawn", std::to_string(drawn));
+    expected.addVariable("xSum", std::to_string(xSum));
+    expected.addVariable("ySum", std::to_string(ySum));
+    return {"penDrawing", "Draws " + std::to_string(lines) + " pen lines, " + std::to_string(linesPerFrame) + " per frame.",
+            buildProject(spec), expected.hex(), static_cast<size_t>(lines / linesPerFrame) * 2 + 10};
+}
+
+Workload Workloads::stringBuilding(int length) {
+    ProjectSpec spec;
+    spec.stageVariables = {"text", "textLength"};
+    spec.spriteVariables = {"i"};
+    ScriptBuilder &s = spec.sprite;
+
+    const std::string alphabet = "abcdefghijklmnopqrstuvwxyz";
+    const json letter = s.op("operator_letter_of", {{"LETTER", s.binary("operator_add", s.binary("operator_mod", s.variable("i"), s.number(26)), s.number(1))}, {"STRING", s.text(alphabet)}});
+    s.define("build text", {}, true,
+             {s.setVariable("text", s.text("")), s.setVariable("i", s.number(0)),
+              s.cBlock("control_repeat", {{"TIMES", s.number(length)}},
+                       {s.setVariable("text", s.op("operator_join", {{"STRING1", s.variable("text")}, {"STRING2", letter}})), s.changeVariable("i", s.number(1))}),
+              s.setVariable("textLength", s.op("operator_length", {{"STRING", s.variable("text")}}))});
+    s.hat("event_whenflagclicked", {s.call("build text"), s.stopAll()});
+
+    std::string text;
+    for (int i = 0; i < length; i++) {
+        text += alphabet[i % 26];
+    }
+
+    StateChecksum expected;
+    expected.addVariable("text", text);
+    expected.addVariable("textLength", std::to_string(length));
+    return {"stringBuilding", "Builds a " + std::to_string(length) + " character string one letter at a time with join.",
+            buildProject(spec), expected.hex(), 10};
+}
+
+Workload Workloads::touchingClones(int clones, int frames, int overlappingPairs) {
+    ProjectSpec spec;
+    spec.stageVariables = {"checks", "touches"};
+    spec.spriteVariables = {"index", "cell", "step"};
+    spec.broadcasts = {"move"};
+    spec.config = {{"framerate", 30}, {"runtimeOptions", {{"maxClones", "Infinity"}, {"miscLimits", true}, {"fencing", true}}}};
+    ScriptBuilder &s = spec.sprite;
+
+    // Every clone gets a spot on a 40 wide grid, 12 units apart, and wobbles 2 units around it every frame.
+    // That keeps the 6 unit costumes close enough to land in each other's cells, but never touching,
+    // except for the first `overlappingPairs` pairs of indexes, which share a spot and so always touch each other.
+    const int columns = 40;
+    const json floorOf = s.binary("operator_divide", s.variable("index"), s.number(2));
+    const std::string pickCell = s.cBlock("control_if_else", {{"CONDITION", s.compare("operator_lt", s.variable("index"), s.number(overlappingPairs * 2))}},
+                                          {s.setVariable("cell", s.op("operator_mathop", {{"NUM", floorOf}}, {{"OPERATOR", {"floor", nullptr}}}))},
+                                          {s.setVariable("cell", s.binary("operator_subtract", s.variable("index"), s.number(overlappingPairs)))});
+    const json column = s.binary("operator_mod", s.variable("cell"), s.number(columns));
+    const json row = s.op("operator_mathop", {{"NUM", s.binary("operator_divide", s.variable("cell"), s.number(columns))}}, {{"OPERATOR", {"floor", nullptr}}});
+    const json wobble = s.binary("operator_multiply", s.binary("operator_subtract", s.binary("operator_mod", s.binary("operator_add", s.variable("step"), s.variable("index")), s.number(3)), s.number(1)), s.number(2));
+    const json x = s.binary("operator_add", s.binary("operator_subtract", s.binary("operator_multiply", column, s.number(12)), s.number(234)), wobble);
+    const json y = s.binary("operator_subtract", s.binary("operator_multiply", row, s.number(12)), s.number(170));
+    s.whenReceived("move", {s.setVariable("step", s.number(0)), pickCell,
+                            s.cBlock("control_repeat", {{"TIMES", s.number(frames)}},
+                                     {s.add("motion_gotoxy", {{"X", x}, {"Y", y}}),
+                                      s.cBlock("control_if", {{"CONDITION", s.touching("Worker")}}, {s.changeVariable("touches", s.number(1))}),
+                                      s.changeVariable("checks", s.number(1)), s.changeVariable("step", s.number(1))})});
+
+    // The original takes index 0, and each clone keeps the index it was created with.
+    // They're all created above the grid, so clones that haven't moved yet can't be touched from it.
+    s.define("spawn clones", {}, true,
+             {s.add("motion_gotoxy", {{"X", s.number(0)}, {"Y", s.number(170)}}), s.setVariable("index", s.number(0)),
+              s.cBlock("control_repeat", {{"TIMES", s.number(clones - 1)}}, {s.changeVariable("index", s.number(1)), s.createCloneOfMyself()}),
+              s.setVariable("index", s.number(0))});
+    s.hat("event_whenflagclicked", {s.call("spawn clones"), s.add("event_broadcast", {{"BROADCAST_INPUT", s.broadcast("move")}}),
+                                    s.add("control_wait_until", {{"CONDITION", s.compare("operator_equals", s.variable("checks"), s.number(static_cast<long long>(clones) * frames))}}),
+                                    s.stopAll()});
+
+    // both clones of a pair see each other every frame, except the first, when whichever moves first finds the other still above the grid
+    StateChecksum expected;
+    expected.addVariable("checks", std::to_string(static_cast<long long>(clones) * frames));
+    expected.addVariable("touches", std::to_string(static_cast<long long>(overlappingPairs) * (frames * 2 - 1)));
+    return {"touchingClones", std::to_string(clones) + " clones move every frame and check whether they're touching any other clone, " + std::to_string(frames) + " times. " +
+                                  std::to_string(overlappingPairs) + " pairs of them share a spot and always touch.",
+            buildProject(spec), expected.hex(), static_cast<size_t>(frames) + 20};
+}
+
+Workload Workloads::warpYields(int outerLoops, int middleLoops, int innerLoops) {
+    ProjectSpec spec;
+    spec.stageVariables = {"total", "innerCalls"};
+    spec.spriteVariables = {"i"};
+    ScriptBuilder &s = spec.sprite;
+
+    // three warp custom blocks, each calling the next from inside a loop, with far more work than fits in the time limit,
+    // so they run out of time at every depth and have to pick up where they left off through the blocks that called them
+    s.define("inner %s", {"n"}, true,
+             {s.cBlock("control_repeat", {{"TIMES", s.number(innerLoops)}}, {s.changeVariable("total", s.argument("n"))}),
+              s.changeVariable("innerCalls", s.number(1))});
+    s.define("middle %s", {"n"}, true,
+             {s.cBlock("control_repeat", {{"TIMES", s.number(middleLoops)}}, {s.call("inner %s", {{"n", s.binary("operator_add", s.argument("n"), s.number(1))}})})});
+    s.define("outer", {}, true,
+             {s.setVariable("i", s.number(0)),
+              s.cBlock("control_repeat", {{"TIMES", s.number(outerLoops)}}, {s.call("middle %s", {{"n", s.variable("i")}}), s.changeVariable("i", s.number(1))})});
+    s.hat("event_whenflagclicked", {s.call("outer"), s.stopAll()});
+
+    const long long calls = static_cast<long long>(outerLoops) * middleLoops;
+    StateChecksum expected;
+    expected.addVariable("total", std::to_string(static_cast<long long>(middleLoops) * innerLoops * outerLoops * (outerLoops + 1) / 2));
+    expected.addVariable("innerCalls", std::to_string(calls));
+    Workload workload = {"warpYields", "Runs " + std::to_string(calls * innerLoops) + " loops in three nested warp custom blocks, with a 1 ms time limit so they yield partway through.",
+                         buildProject(spec), expected.hex(), 5000};
+    workload.warpTimeLimit = 1;
+    return workload;
+}
+
+bool Workloads::writeSb3(const Workload &workload, const std::string &path) {
+    mz_zip_archive zip;
+    memset(&zip, 0, sizeof(zip));
+    if (!mz_zip_writer_init_file(&zip, path.c_str(), 0)) return false;
+
+    const std::string projectJson = workload.project.dump();
+    const std::string costumeName = std::string(costumeMd5) + ".svg";
+    bool written = mz_zip_writer_add_mem(&zip, "project.json", projectJson.data(), projectJson.size(), MZ_DEFAULT_COMPRESSION) &&
+                   mz_zip_writer_add_mem(&zip, costumeName.c_str(), costumeSvg, strlen(costumeSvg), MZ_DEFAULT_COMPRESSION) &&
+                   mz_zip_writer_finalize_archive(&zip);
+    mz_zip_writer_end(&zip);
+    return written;
+}
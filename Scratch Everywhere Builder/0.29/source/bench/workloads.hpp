@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * A synthetic project that stresses one part of the interpreter.
+ */
+struct Workload {
+    std::string name;
+    std::string description;
+    nlohmann::json project;
+    // `StateChecksum::hex()` of the Stage's variables and lists once the project has stopped itself
+    std::string checksum;
+    // enough frames for the project to finish in turbo mode
+    size_t frames;
+    // milliseconds scripts without screen refresh get each frame before they have to wait for the next one (0 for no limit).
+    // The project has to end in the same state with or without it
+    int warpTimeLimit = 0;
+};
+
+class Workloads {
+  public:
+    /**
+     * Builds every benchmark workload.
+     * Each project leaves its results in Stage variables and lists, and ends with `stop all` once it's done.
+     * @return Every workload, along with the checksum its final state should have.
+     */
+    static std::vector<Workload> generate();
+
+    /**
+     * Zips a workload's project.json and its costume into an .sb3 file.
+     * @param workload The workload to write
+     * @param path Where to write the .sb3
+     * @return `true` if the file was written.
+     */
+    static bool writeSb3(const Workload &workload, const std::string &path);
+
+  private:
+    static Workload cloneChurn(int rounds, int clonesPerRound);
+    static Workload nestedCalls(int depth, int calls);
+    static Workload listSort(int items);
+    static Workload broadcastPingPong(int rounds);
+    static Workload penDrawing(int lines, int linesPerFrame);
+    static Workload stringBuilding(int length);
+    static Workload touchingClones(int clones, int frames, int overlappingPairs);
+    static Workload warpYields(int outerLoops, int middleLoops, int innerLoops);
+};
@@ -1,4 +1,110 @@
+#include "image.hpp"
 #include "../scratch/image.hpp"
+#include "os.hpp"
+#include "unzip.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#define STBI_NO_GIF
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#define NANOSVGRAST_IMPLEMENTATION
+#include "nanosvgrast.h"
+
+std::unordered_map<std::string, HeadlessImage> images;
+
+#if defined(__PC__) || defined(__PSP__)
+#include <cmrc/cmrc.hpp>
+
+CMRC_DECLARE(romfs);
+#endif
+
+namespace {
+
+/**
+ * Rasterizes an SVG, at no more than `CollisionMask::maxSize` on either side since nothing but the mask needs it.
+ * @param width Set to the SVG's own width
+ * @param height Set to the SVG's own height
+ * @param rasterWidth Set to the width of the returned pixels
+ * @param rasterHeight Set to the height of the returned pixels
+ * @return RGBA pixels, to be freed with `free()`, or `nullptr` if the SVG couldn't be parsed.
+ */
+unsigned char *SVGToRGBA(const void *svgData, size_t svgSize, int &width, int &height, int &rasterWidth, int &rasterHeight) {
+    char *svgString = static_cast<char *>(malloc(svgSize + 1));
+    if (!svgString) return nullptr;
+    memcpy(svgString, svgData, svgSize);
+    svgString[svgSize] = '\0';
+
+    NSVGimage *image = nsvgParse(svgString, "px", 96.0f);
+    free(svgString);
+    if (!image) return nullptr;
+
+    width = image->width > 0 ? static_cast<int>(image->width) : 32;
+    height = image->height > 0 ? static_cast<int>(image->height) : 32;
+    const float scale = std::min(1.0f, static_cast<float>(CollisionMask::maxSize) / std::max(width, height));
+    rasterWidth = std::max(1, static_cast<int>(width * scale));
+    rasterHeight = std::max(1, static_cast<int>(height * scale));
+
+    NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+    unsigned char *pixels = static_cast<unsigned char *>(malloc(static_cast<size_t>(rasterWidth) * rasterHeight * 4));
+    if (!rasterizer || !pixels) {
+        if (rasterizer) nsvgDeleteRasterizer(rasterizer);
+        free(pixels);
+        nsvgDelete(image);
+        return nullptr;
+    }
+    nsvgRasterize(rasterizer, image, 0, 0, scale, pixels, rasterWidth, rasterHeight, rasterWidth * 4);
+    nsvgDeleteRasterizer(rasterizer);
+    nsvgDelete(image);
+    return pixels;
+}
+
+// sets what the other renderers set on every Sprite before drawing it, if the image is the Sprite's current costume
+void applyCostume(Sprite *sprite, const std::string &imageId, const HeadlessImage &image) {
+    const Costume &costume = sprite->data->costumes[sprite->currentCostume];
+    if (costume.id != imageId) return;
+    sprite->rotationCenterX = costume.rotationCenterX;
+    sprite->rotationCenterY = costume.rotationCenterY;
+    sprite->spriteWidth = image.width >> 1;
+    sprite->spriteHeight = image.height >> 1;
+}
+
+/**
+ * Decodes a costume's file, so its size and collision mask are known.
+ * @param image Filled with the costume's size and mask
+ * @return `false` if the file couldn't be decoded.
+ */
+bool decodeImage(const void *fileData, size_t fileSize, bool isSVG, HeadlessImage &image) {
+    if (isSVG) {
+        int rasterWidth, rasterHeight;
+        unsigned char *pixels = SVGToRGBA(fileData, fileSize, image.width, image.height, rasterWidth, rasterHeight);
+        if (pixels) {
+            image.collisionMask = CollisionMask(pixels, rasterWidth, rasterHeight, rasterWidth * 4, 1);
+            free(pixels);
+        }
+    } else {
+        int channels;
+        unsigned char *pixels = stbi_load_from_memory(static_cast<const unsigned char *>(fileData), fileSize, &image.width, &image.height, &channels, 4);
+        if (pixels) {
+            image.collisionMask = CollisionMask(pixels, image.width, image.height, image.width * 4, 2);
+            stbi_image_free(pixels);
+        }
+    }
+    return image.collisionMask.isLoaded();
+}
+
+bool isSVGFile(const std::string &fileName) {
+    return fileName.size() >= 4 && (fileName.substr(fileName.size() - 4) == ".svg" || fileName.substr(fileName.size() - 4) == ".SVG");
+}
+
+} // namespace
 
 Image::Image(std::string filePath) : width(0), height(0), scale(1.0), opacity(1.0), rotation(0.0) {
 }
@@ -12,22 +118,106 @@ void Image::render(double xPos, double yPos, bool centered) {
 void Image::renderNineslice(double xPos, double yPos, double width, double height, double padding, bool centered) {
 }
 
+/**
+ * Decodes a single costume from an unzipped project, so its size and collision mask are known.
+ * @param filePath
+ */
 bool Image::loadImageFromFile(std::string filePath, Sprite *sprite, bool fromScratchProject) {
+    const std::string imageId = filePath.substr(0, filePath.find_last_of('.'));
+    auto imgFind = images.find(imageId);
+    if (imgFind != images.end()) {
+        if (sprite != nullptr) applyCostume(sprite, imageId, imgFind->second);
+        return true;
+    }
+
+    std::string finalPath = OS::getRomFSLocation();
+    if (fromScratchProject) finalPath = finalPath + "project/";
+    finalPath = finalPath + filePath;
+    if (Unzip::UnpackedInSD) finalPath = Unzip::filePath + filePath;
+
+    HeadlessImage image;
+    bool decoded = false;
+#if defined(__PC__) || defined(__PSP__)
+    const auto &fs = cmrc::romfs::get_filesystem();
+    if (!Unzip::UnpackedInSD && fs.exists(finalPath)) {
+        const auto &file = fs.open(finalPath);
+        decoded = decodeImage(file.begin(), file.size(), isSVGFile(filePath), image);
+    } else
+#endif
+    {
+        std::ifstream file(finalPath, std::ios::binary);
+        if (file) {
+            const std::string fileData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            decoded = decodeImage(fileData.data(), fileData.size(), isSVGFile(filePath), image);
+        }
+    }
 
-    return false;
+    if (!decoded) {
+        Log::logWarning("Failed to decode image: " + finalPath);
+        return false;
+    }
+
+    if (sprite != nullptr) applyCostume(sprite, imageId, image);
+    images[imageId] = std::move(image);
+    return true;
 }
 
+/**
+ * Decodes a single costume from a Scratch sb3 zip file, so its size and collision mask are known.
+ * @param zip Pointer to the zip archive
+ * @param costumeId The filename of the image to load (e.g., "sprite1.png")
+ */
 void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId, Sprite *sprite) {
+    const std::string imageId = costumeId.substr(0, costumeId.find_last_of('.'));
+    auto imgFind = images.find(imageId);
+    if (imgFind != images.end()) {
+        // there's no renderer to catch the Sprite up with its new costume, so do it here
+        if (sprite != nullptr) applyCostume(sprite, imageId, imgFind->second);
+        return;
+    }
+
+    const int fileIndex = Unzip::findFile(zip, costumeId);
+    if (fileIndex < 0) {
+        Log::logWarning("Image file not found in zip: " + costumeId);
+        return;
+    }
+
+    size_t fileSize;
+    void *fileData = mz_zip_reader_extract_to_heap(zip, fileIndex, &fileSize, 0);
+    if (!fileData) {
+        Log::logWarning("Failed to extract: " + costumeId);
+        return;
+    }
+
+    HeadlessImage image;
+    const bool decoded = decodeImage(fileData, fileSize, isSVGFile(costumeId), image);
+    mz_free(fileData);
+
+    if (!decoded) {
+        Log::logWarning("Failed to decode image: " + costumeId);
+        return;
+    }
+
+    if (sprite != nullptr) applyCostume(sprite, imageId, image);
+    images[imageId] = std::move(image);
+}
+
+const CollisionMask *Image::getCollisionMask(const std::string &costumeId) {
+    auto it = images.find(costumeId);
+    if (it == images.end()) return nullptr;
+    return &it->second.collisionMask;
 }
 
 void Image::freeImage(const std::string &costumeId) {
+    images.erase(costumeId);
 }
 
 void Image::cleanupImages() {
+    images.clear();
 }
 
 void Image::queueFreeImage(const std::string &costumeId) {
 }
 
 void Image::FlushImages() {
-}
\ No newline at end of file
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "../scratch/collisionMask.hpp"
+#include <string>
+#include <unordered_map>
+
+/**
+ * A costume decoded by the headless backend. There's nothing to draw it to,
+ * so only what collision checks need is kept.
+ */
+struct HeadlessImage {
+    int width;
+    int height;
+    CollisionMask collisionMask;
+};
+
+extern std::unordered_map<std::string, HeadlessImage> images;
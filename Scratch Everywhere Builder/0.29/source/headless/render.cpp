@@ -1,4 +1,5 @@
 #include "../scratch/render.hpp"
+#include "render.hpp"
 
 // Static member initialization
 std::chrono::_V2::system_clock::time_point Render::startTime;
@@ -10,6 +11,8 @@ std::unordered_map<std::string, TextObject *> Render::monitorTexts;
 std::vector<Monitor> Render::visibleVariables;
 float Render::renderScale;
 
+std::function<bool()> headlessFrameCallback;
+
 bool Render::Init() {
     return true;
 }
@@ -49,5 +52,5 @@ void Render::drawBox(int w, int h, int x, int y, uint8_t colorR, uint8_t colorG,
 }
 
 bool Render::appShouldRun() {
-    return true;
+    return !headlessFrameCallback || headlessFrameCallback();
 }
\ No newline at end of file
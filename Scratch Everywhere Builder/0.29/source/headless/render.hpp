@@ -0,0 +1,9 @@
+#pragma once
+#include <functional>
+
+/**
+ * Called by `Render::appShouldRun()`, so once before every frame of the project loop.
+ * Lets tools like `se-bench` run a project for a fixed number of frames.
+ * Return `false` to stop the project. Empty by default, so projects run until they stop themselves.
+ */
+extern std::function<bool()> headlessFrameCallback;
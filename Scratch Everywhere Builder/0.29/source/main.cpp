@@ -17,7 +17,21 @@
 #include <emscripten_browser_file.h>
 #endif
 
+#ifdef ENABLE_PROFILER
+#include "scratch/profiler.hpp"
+#endif
+
+#ifdef ENABLE_TRACE
+#include "scratch/trace.hpp"
+#endif
+
 static void exitApp() {
+#ifdef ENABLE_PROFILER
+    Profiler::dumpJson(OS::getScratchFolderLocation() + "profile.json");
+#endif
+#ifdef ENABLE_TRACE
+    Trace::dumpJson(OS::getScratchFolderLocation() + "trace.json");
+#endif
     Render::deInit();
 }
 
@@ -78,6 +92,9 @@ void mainLoop() {
 }
 
 int main(int argc, char **argv) {
+#ifdef ENABLE_TRACE
+    Trace::setThreadName("Main");
+#endif
     if (!initApp()) {
         exitApp();
         return 1;
@@ -3,6 +3,8 @@
 #include "audio.hpp"
 #include "interpret.hpp"
 #include "miniz/miniz.h"
+#include "trace.hpp"
+#include "unzip.hpp"
 #include <sys/stat.h>
 
 std::unordered_map<std::string, Sound> SoundPlayer::soundsPlaying;
@@ -150,6 +152,7 @@ mm_stream_formats NDS_Audio::getMMStreamType(uint16_t numChannels, uint16_t bits
 #endif
 
 void SoundPlayer::startSoundLoaderThread(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed, const bool &fromProject) {
+    TRACE_SPAN("SoundPlayer::startSoundLoaderThread");
 #ifdef ENABLE_AUDIO
 
     if (projectType != UNZIPPED && zip != nullptr)
@@ -171,23 +174,8 @@ bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const st
         return false;
     }
 
-    int file_count = (int)mz_zip_reader_get_num_files(zip);
-    if (file_count <= 0) {
-        Log::logWarning("Error: No files found in zip archive");
-        return false;
-    }
-
-    for (int i = 0; i < file_count; i++) {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(zip, i, &file_stat)) {
-            continue;
-        }
-
-        std::string zipFileName = file_stat.m_filename;
-
-        if (zipFileName.find(soundId) == std::string::npos) {
-            continue;
-        }
+    const int file_index = Unzip::findFile(zip, soundId);
+    if (file_index >= 0) {
 
         // Create temporary file
         std::string tempDir = OS::getScratchFolderLocation() + "cache/";
@@ -202,7 +190,7 @@ bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const st
         }
 
         // Extract file in chunks to avoid large allocation
-        mz_zip_reader_extract_iter_state *pState = mz_zip_reader_extract_iter_new(zip, i, 0);
+        mz_zip_reader_extract_iter_state *pState = mz_zip_reader_extract_iter_new(zip, file_index, 0);
         if (!pState) {
             Log::logWarning("Failed to create extraction iterator");
             fclose(tempFile);
@@ -410,6 +398,7 @@ void SoundPlayer::freeAudio(const std::string &soundId) {
 }
 
 void SoundPlayer::flushAudio() {
+    TRACE_SPAN("SoundPlayer::flushAudio");
 #ifdef ENABLE_AUDIO
     if (NDS_Sounds.empty()) return;
     std::vector<std::string> toDelete;
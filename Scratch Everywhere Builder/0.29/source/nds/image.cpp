@@ -6,6 +6,7 @@
 #include "nanosvg.h"
 #define NANOSVGRAST_IMPLEMENTATION
 #include "nanosvgrast.h"
+#include "trace.hpp"
 #include "unzip.hpp"
 // This image stuff is going to be tough; the DS uses memory "banks" of fixed sizes that might not be the best use of space when it comes to images.
 // The vram banks add up to 656 KB.
@@ -165,6 +166,7 @@ bool Image::loadImageFromFile(std::string filePath, Sprite *sprite, bool fromScr
 
     imagePAL8 image = RGBAToPAL8(newRGBA);
     if (uploadPAL8ToVRAM(image, &image.image)) {
+        if (fromScratchProject) image.collisionMask = CollisionMask(newRGBA.data, newRGBA.width, newRGBA.height, newRGBA.width * 4, 1);
         images[costumeName] = image;
     }
     stbi_image_free(newRGBA.data);
@@ -178,7 +180,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
     if (images.find(costumeName) != images.end()) return;
 
     // Find the file in the zip
-    int file_index = mz_zip_reader_locate_file(zip, costumeId.c_str(), nullptr, 0);
+    int file_index = Unzip::findFile(zip, costumeId);
     if (file_index < 0) {
         Log::logWarning("Image file not found in zip: " + costumeId);
         return;
@@ -253,11 +255,18 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
 
     imagePAL8 image = RGBAToPAL8(newRGBA);
     if (uploadPAL8ToVRAM(image, &image.image)) {
+        image.collisionMask = CollisionMask(newRGBA.data, newRGBA.width, newRGBA.height, newRGBA.width * 4, 1);
         images[costumeName] = image;
     }
     stbi_image_free(newRGBA.data);
 }
 
+const CollisionMask *Image::getCollisionMask(const std::string &costumeId) {
+    auto it = images.find(costumeId);
+    if (it == images.end() || !it->second.collisionMask.isLoaded()) return nullptr;
+    return &it->second.collisionMask;
+}
+
 bool resizeRGBAImage(uint16_t newWidth, uint16_t newHeight, imageRGBA &rgba) {
     unsigned char *resizedData = new unsigned char[newWidth * newHeight * 4];
 
@@ -543,6 +552,7 @@ void Image::queueFreeImage(const std::string &costumeId) {
 }
 
 void Image::FlushImages() {
+    TRACE_SPAN("Image::FlushImages");
     std::vector<std::string> toDelete;
     for (auto &[id, data] : images) {
         data.freeTimer--;
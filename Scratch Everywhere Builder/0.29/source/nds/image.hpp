@@ -1,4 +1,5 @@
 #pragma once
+#include "../scratch/collisionMask.hpp"
 #include "../scratch/image.hpp"
 #include <gl2d.h>
 #include <nds.h>
@@ -37,6 +38,7 @@ struct imagePAL8 {
     int textureID;
     int paletteID;
     glImage image;
+    CollisionMask collisionMask;
     uint8_t freeTimer = 150;
     uint8_t maxFreeTimer = 150;
 };
@@ -111,7 +111,7 @@ void Render::renderSprites() {
         Sprite *sprite = *it;
         if (!sprite->visible) continue;
 
-        auto imgFind = images.find(sprite->costumes[sprite->currentCostume].id);
+        auto imgFind = images.find(sprite->data->costumes[sprite->currentCostume].id);
         if (imgFind != images.end()) {
             imagePAL8 &data = imgFind->second;
             glImage *image = &data.image;
@@ -122,8 +122,8 @@ void Render::renderSprites() {
             sprite->spriteWidth = data.originalWidth >> 1;
             sprite->spriteHeight = data.originalHeight >> 1;
             // TODO: put this in calculateRenderPosition() for all platforms since they all do this anyway
-            sprite->rotationCenterX = sprite->costumes[sprite->currentCostume].rotationCenterX;
-            sprite->rotationCenterY = sprite->costumes[sprite->currentCostume].rotationCenterY;
+            sprite->rotationCenterX = sprite->data->costumes[sprite->currentCostume].rotationCenterX;
+            sprite->rotationCenterY = sprite->data->costumes[sprite->currentCostume].rotationCenterY;
             if (sprite->ghostEffect > 75) continue;
 
             calculateRenderPosition(sprite, false);
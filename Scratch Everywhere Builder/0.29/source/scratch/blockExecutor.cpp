@@ -10,18 +10,26 @@
 #include "blocks/sensing.hpp"
 #include "blocks/sound.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "os.hpp"
+#include "spatialHash.hpp"
 #include "sprite.hpp"
 #include "unzip.hpp"
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <iterator>
+#include <optional>
 #include <ratio>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#ifdef ENABLE_PROFILER
+#include "profiler.hpp"
+#endif
+
 #ifdef ENABLE_CLOUDVARS
 #include <mist/mist.hpp>
 
@@ -31,171 +39,252 @@ extern std::unique_ptr<MistConnection> cloudConnection;
 size_t blocksRun = 0;
 Timer BlockExecutor::timer;
 
+namespace {
+
+// how many `runRepeatsWithoutRefresh()` calls are on the stack, and how long since the outermost one started
+int warpDepth = 0;
+Timer warpTimer;
+
+// handed out for blocks that aren't in a compiled script, or whose indices are out of range (a malformed project),
+// so they get a state that's thrown away instead of reading past the end of a Sprite's threads
+ScriptThread detachedThread;
+BlockState detachedState;
+
+// Scratch starts hats front to back, then the Stage's, so they run in the order `sprites` lists their Sprites in.
+// Each index list is kept sorted by layer, and only sorted again after Sprites are added or moved
+void sortByLayer(std::vector<std::pair<Block *, Sprite *>> &hats) {
+    std::stable_sort(hats.begin(), hats.end(), [](const std::pair<Block *, Sprite *> &a, const std::pair<Block *, Sprite *> &b) {
+        if (a.second->isStage != b.second->isStage) return b.second->isStage;
+        return a.second->layer > b.second->layer;
+    });
+}
+
+} // namespace
+OpcodeTable<std::unordered_map<std::string, BlockExecutor::HatList>> BlockExecutor::hatIndex;
+
 BlockExecutor::BlockExecutor() {
     registerHandlers();
+
+    // opcodes without a handler do nothing
+    for (auto &handler : handlers.entries) {
+        if (!handler) handler = [](Block &, Sprite *, bool *, bool) { return BlockResult::CONTINUE; };
+    }
+    for (auto &valueHandler : valueHandlers.entries) {
+        if (!valueHandler) valueHandler = [](Block &, Sprite *) { return Value(); };
+    }
 }
 
 void BlockExecutor::registerHandlers() {
 
     // motion
-    handlers["motion_movesteps"] = MotionBlocks::moveSteps;
-    handlers["motion_gotoxy"] = MotionBlocks::goToXY;
-    handlers["motion_goto"] = MotionBlocks::goTo;
-    handlers["motion_changexby"] = MotionBlocks::changeXBy;
-    handlers["motion_changeyby"] = MotionBlocks::changeYBy;
-    handlers["motion_setx"] = MotionBlocks::setX;
-    handlers["motion_sety"] = MotionBlocks::setY;
-    handlers["motion_glidesecstoxy"] = MotionBlocks::glideSecsToXY;
-    handlers["motion_glideto"] = MotionBlocks::glideTo;
-    handlers["motion_turnright"] = MotionBlocks::turnRight;
-    handlers["motion_turnleft"] = MotionBlocks::turnLeft;
-    handlers["motion_pointindirection"] = MotionBlocks::pointInDirection;
-    handlers["motion_pointtowards"] = MotionBlocks::pointToward;
-    handlers["motion_setrotationstyle"] = MotionBlocks::setRotationStyle;
-    handlers["motion_ifonedgebounce"] = MotionBlocks::ifOnEdgeBounce;
-    valueHandlers["motion_xposition"] = MotionBlocks::xPosition;
-    valueHandlers["motion_yposition"] = MotionBlocks::yPosition;
-    valueHandlers["motion_direction"] = MotionBlocks::direction;
+    handlers[Opcode::MOTION_MOVESTEPS] = MotionBlocks::moveSteps;
+    handlers[Opcode::MOTION_GOTOXY] = MotionBlocks::goToXY;
+    handlers[Opcode::MOTION_GOTO] = MotionBlocks::goTo;
+    handlers[Opcode::MOTION_CHANGEXBY] = MotionBlocks::changeXBy;
+    handlers[Opcode::MOTION_CHANGEYBY] = MotionBlocks::changeYBy;
+    handlers[Opcode::MOTION_SETX] = MotionBlocks::setX;
+    handlers[Opcode::MOTION_SETY] = MotionBlocks::setY;
+    handlers[Opcode::MOTION_GLIDESECSTOXY] = MotionBlocks::glideSecsToXY;
+    handlers[Opcode::MOTION_GLIDETO] = MotionBlocks::glideTo;
+    handlers[Opcode::MOTION_TURNRIGHT] = MotionBlocks::turnRight;
+    handlers[Opcode::MOTION_TURNLEFT] = MotionBlocks::turnLeft;
+    handlers[Opcode::MOTION_POINTINDIRECTION] = MotionBlocks::pointInDirection;
+    handlers[Opcode::MOTION_POINTTOWARDS] = MotionBlocks::pointToward;
+    handlers[Opcode::MOTION_SETROTATIONSTYLE] = MotionBlocks::setRotationStyle;
+    handlers[Opcode::MOTION_IFONEDGEBOUNCE] = MotionBlocks::ifOnEdgeBounce;
+    valueHandlers[Opcode::MOTION_XPOSITION] = MotionBlocks::xPosition;
+    valueHandlers[Opcode::MOTION_YPOSITION] = MotionBlocks::yPosition;
+    valueHandlers[Opcode::MOTION_DIRECTION] = MotionBlocks::direction;
 
     // looks
-    handlers["looks_show"] = LooksBlocks::show;
-    handlers["looks_hide"] = LooksBlocks::hide;
-    handlers["looks_switchcostumeto"] = LooksBlocks::switchCostumeTo;
-    handlers["looks_nextcostume"] = LooksBlocks::nextCostume;
-    handlers["looks_switchbackdropto"] = LooksBlocks::switchBackdropTo;
-    handlers["looks_nextbackdrop"] = LooksBlocks::nextBackdrop;
-    handlers["looks_goforwardbackwardlayers"] = LooksBlocks::goForwardBackwardLayers;
-    handlers["looks_gotofrontback"] = LooksBlocks::goToFrontBack;
-    handlers["looks_setsizeto"] = LooksBlocks::setSizeTo;
-    handlers["looks_changesizeby"] = LooksBlocks::changeSizeBy;
-    handlers["looks_seteffectto"] = LooksBlocks::setEffectTo;
-    handlers["looks_changeeffectby"] = LooksBlocks::changeEffectBy;
-    handlers["looks_cleargraphiceffects"] = LooksBlocks::clearGraphicEffects;
-    valueHandlers["looks_size"] = LooksBlocks::size;
-    valueHandlers["looks_costume"] = LooksBlocks::costume;
-    valueHandlers["looks_backdrops"] = LooksBlocks::backdrops;
-    valueHandlers["looks_costumenumbername"] = LooksBlocks::costumeNumberName;
-    valueHandlers["looks_backdropnumbername"] = LooksBlocks::backdropNumberName;
+    handlers[Opcode::LOOKS_SHOW] = LooksBlocks::show;
+    handlers[Opcode::LOOKS_HIDE] = LooksBlocks::hide;
+    handlers[Opcode::LOOKS_SWITCHCOSTUMETO] = LooksBlocks::switchCostumeTo;
+    handlers[Opcode::LOOKS_NEXTCOSTUME] = LooksBlocks::nextCostume;
+    handlers[Opcode::LOOKS_SWITCHBACKDROPTO] = LooksBlocks::switchBackdropTo;
+    handlers[Opcode::LOOKS_NEXTBACKDROP] = LooksBlocks::nextBackdrop;
+    handlers[Opcode::LOOKS_GOFORWARDBACKWARDLAYERS] = LooksBlocks::goForwardBackwardLayers;
+    handlers[Opcode::LOOKS_GOTOFRONTBACK] = LooksBlocks::goToFrontBack;
+    handlers[Opcode::LOOKS_SETSIZETO] = LooksBlocks::setSizeTo;
+    handlers[Opcode::LOOKS_CHANGESIZEBY] = LooksBlocks::changeSizeBy;
+    handlers[Opcode::LOOKS_SETEFFECTTO] = LooksBlocks::setEffectTo;
+    handlers[Opcode::LOOKS_CHANGEEFFECTBY] = LooksBlocks::changeEffectBy;
+    handlers[Opcode::LOOKS_CLEARGRAPHICEFFECTS] = LooksBlocks::clearGraphicEffects;
+    valueHandlers[Opcode::LOOKS_SIZE] = LooksBlocks::size;
+    valueHandlers[Opcode::LOOKS_COSTUME] = LooksBlocks::costume;
+    valueHandlers[Opcode::LOOKS_BACKDROPS] = LooksBlocks::backdrops;
+    valueHandlers[Opcode::LOOKS_COSTUMENUMBERNAME] = LooksBlocks::costumeNumberName;
+    valueHandlers[Opcode::LOOKS_BACKDROPNUMBERNAME] = LooksBlocks::backdropNumberName;
 
     // sound
-    handlers["sound_play"] = SoundBlocks::playSound;
-    handlers["sound_playuntildone"] = SoundBlocks::playSoundUntilDone;
-    handlers["sound_stopallsounds"] = SoundBlocks::stopAllSounds;
-    handlers["sound_changeeffectby"] = SoundBlocks::changeEffectBy;
-    handlers["sound_seteffectto"] = SoundBlocks::setEffectTo;
-    handlers["sound_cleareffects"] = SoundBlocks::clearSoundEffects;
-    handlers["sound_changevolumeby"] = SoundBlocks::changeVolumeBy;
-    handlers["sound_setvolumeto"] = SoundBlocks::setVolumeTo;
-    valueHandlers["sound_volume"] = SoundBlocks::volume;
+    handlers[Opcode::SOUND_PLAY] = SoundBlocks::playSound;
+    handlers[Opcode::SOUND_PLAYUNTILDONE] = SoundBlocks::playSoundUntilDone;
+    handlers[Opcode::SOUND_STOPALLSOUNDS] = SoundBlocks::stopAllSounds;
+    handlers[Opcode::SOUND_CHANGEEFFECTBY] = SoundBlocks::changeEffectBy;
+    handlers[Opcode::SOUND_SETEFFECTTO] = SoundBlocks::setEffectTo;
+    handlers[Opcode::SOUND_CLEAREFFECTS] = SoundBlocks::clearSoundEffects;
+    handlers[Opcode::SOUND_CHANGEVOLUMEBY] = SoundBlocks::changeVolumeBy;
+    handlers[Opcode::SOUND_SETVOLUMETO] = SoundBlocks::setVolumeTo;
+    valueHandlers[Opcode::SOUND_VOLUME] = SoundBlocks::volume;
 
     // events
-    handlers["event_whenflagclicked"] = EventBlocks::flagClicked;
-    handlers["event_broadcast"] = EventBlocks::broadcast;
-    handlers["event_broadcastandwait"] = EventBlocks::broadcastAndWait;
-    handlers["event_whenkeypressed"] = EventBlocks::whenKeyPressed;
-    handlers["event_whenbackdropswitchesto"] = EventBlocks::whenBackdropSwitchesTo;
+    handlers[Opcode::EVENT_WHENFLAGCLICKED] = EventBlocks::flagClicked;
+    handlers[Opcode::EVENT_BROADCAST] = EventBlocks::broadcast;
+    handlers[Opcode::EVENT_BROADCASTANDWAIT] = EventBlocks::broadcastAndWait;
+    handlers[Opcode::EVENT_WHENKEYPRESSED] = EventBlocks::whenKeyPressed;
+    handlers[Opcode::EVENT_WHENBACKDROPSWITCHESTO] = EventBlocks::whenBackdropSwitchesTo;
 
     // control
-    handlers["control_if"] = ControlBlocks::If;
-    handlers["control_if_else"] = ControlBlocks::ifElse;
-    handlers["control_create_clone_of"] = ControlBlocks::createCloneOf;
-    handlers["control_delete_this_clone"] = ControlBlocks::deleteThisClone;
-    handlers["control_stop"] = ControlBlocks::stop;
-    handlers["control_start_as_clone"] = ControlBlocks::startAsClone;
-    handlers["control_wait"] = ControlBlocks::wait;
-    handlers["control_wait_until"] = ControlBlocks::waitUntil;
-    handlers["control_repeat"] = ControlBlocks::repeat;
-    handlers["control_repeat_until"] = ControlBlocks::repeatUntil;
-    handlers["control_while"] = ControlBlocks::While;
-    handlers["control_forever"] = ControlBlocks::forever;
-    valueHandlers["control_get_counter"] = ControlBlocks::getCounter;
-    handlers["control_clear_counter"] = ControlBlocks::clearCounter;
-    handlers["control_incr_counter"] = ControlBlocks::incrementCounter;
-    handlers["control_for_each"] = ControlBlocks::forEach;
+    handlers[Opcode::CONTROL_IF] = ControlBlocks::If;
+    handlers[Opcode::CONTROL_IF_ELSE] = ControlBlocks::ifElse;
+    handlers[Opcode::CONTROL_CREATE_CLONE_OF] = ControlBlocks::createCloneOf;
+    handlers[Opcode::CONTROL_DELETE_THIS_CLONE] = ControlBlocks::deleteThisClone;
+    handlers[Opcode::CONTROL_STOP] = ControlBlocks::stop;
+    handlers[Opcode::CONTROL_START_AS_CLONE] = ControlBlocks::startAsClone;
+    handlers[Opcode::CONTROL_WAIT] = ControlBlocks::wait;
+    handlers[Opcode::CONTROL_WAIT_UNTIL] = ControlBlocks::waitUntil;
+    handlers[Opcode::CONTROL_REPEAT] = ControlBlocks::repeat;
+    handlers[Opcode::CONTROL_REPEAT_UNTIL] = ControlBlocks::repeatUntil;
+    handlers[Opcode::CONTROL_WHILE] = ControlBlocks::While;
+    handlers[Opcode::CONTROL_FOREVER] = ControlBlocks::forever;
+    valueHandlers[Opcode::CONTROL_GET_COUNTER] = ControlBlocks::getCounter;
+    handlers[Opcode::CONTROL_CLEAR_COUNTER] = ControlBlocks::clearCounter;
+    handlers[Opcode::CONTROL_INCR_COUNTER] = ControlBlocks::incrementCounter;
+    handlers[Opcode::CONTROL_FOR_EACH] = ControlBlocks::forEach;
 
     // operators
-    valueHandlers["operator_add"] = OperatorBlocks::add;
-    valueHandlers["operator_subtract"] = OperatorBlocks::subtract;
-    valueHandlers["operator_multiply"] = OperatorBlocks::multiply;
-    valueHandlers["operator_divide"] = OperatorBlocks::divide;
-    valueHandlers["operator_random"] = OperatorBlocks::random;
-    valueHandlers["operator_join"] = OperatorBlocks::join;
-    valueHandlers["operator_letter_of"] = OperatorBlocks::letterOf;
-    valueHandlers["operator_length"] = OperatorBlocks::length;
-    valueHandlers["operator_mod"] = OperatorBlocks::mod;
-    valueHandlers["operator_round"] = OperatorBlocks::round;
-    valueHandlers["operator_mathop"] = OperatorBlocks::mathOp;
-    valueHandlers["operator_equals"] = OperatorBlocks::equals;
-    valueHandlers["operator_gt"] = OperatorBlocks::greaterThan;
-    valueHandlers["operator_lt"] = OperatorBlocks::lessThan;
-    valueHandlers["operator_and"] = OperatorBlocks::and_;
-    valueHandlers["operator_or"] = OperatorBlocks::or_;
-    valueHandlers["operator_not"] = OperatorBlocks::not_;
-    valueHandlers["operator_contains"] = OperatorBlocks::contains;
+    valueHandlers[Opcode::OPERATOR_ADD] = OperatorBlocks::add;
+    valueHandlers[Opcode::OPERATOR_SUBTRACT] = OperatorBlocks::subtract;
+    valueHandlers[Opcode::OPERATOR_MULTIPLY] = OperatorBlocks::multiply;
+    valueHandlers[Opcode::OPERATOR_DIVIDE] = OperatorBlocks::divide;
+    valueHandlers[Opcode::OPERATOR_RANDOM] = OperatorBlocks::random;
+    valueHandlers[Opcode::OPERATOR_JOIN] = OperatorBlocks::join;
+    valueHandlers[Opcode::OPERATOR_LETTER_OF] = OperatorBlocks::letterOf;
+    valueHandlers[Opcode::OPERATOR_LENGTH] = OperatorBlocks::length;
+    valueHandlers[Opcode::OPERATOR_MOD] = OperatorBlocks::mod;
+    valueHandlers[Opcode::OPERATOR_ROUND] = OperatorBlocks::round;
+    valueHandlers[Opcode::OPERATOR_MATHOP] = OperatorBlocks::mathOp;
+    valueHandlers[Opcode::OPERATOR_EQUALS] = OperatorBlocks::equals;
+    valueHandlers[Opcode::OPERATOR_GT] = OperatorBlocks::greaterThan;
+    valueHandlers[Opcode::OPERATOR_LT] = OperatorBlocks::lessThan;
+    valueHandlers[Opcode::OPERATOR_AND] = OperatorBlocks::and_;
+    valueHandlers[Opcode::OPERATOR_OR] = OperatorBlocks::or_;
+    valueHandlers[Opcode::OPERATOR_NOT] = OperatorBlocks::not_;
+    valueHandlers[Opcode::OPERATOR_CONTAINS] = OperatorBlocks::contains;
 
     // data
-    handlers["data_setvariableto"] = DataBlocks::setVariable;
-    handlers["data_changevariableby"] = DataBlocks::changeVariable;
-    handlers["data_showvariable"] = DataBlocks::showVariable;
-    handlers["data_hidevariable"] = DataBlocks::hideVariable;
-    handlers["data_showlist"] = DataBlocks::showList;
-    handlers["data_hidelist"] = DataBlocks::hideList;
-    handlers["data_addtolist"] = DataBlocks::addToList;
-    handlers["data_deleteoflist"] = DataBlocks::deleteFromList;
-    handlers["data_deletealloflist"] = DataBlocks::deleteAllOfList;
-    handlers["data_insertatlist"] = DataBlocks::insertAtList;
-    handlers["data_replaceitemoflist"] = DataBlocks::replaceItemOfList;
-    valueHandlers["data_itemoflist"] = DataBlocks::itemOfList;
-    valueHandlers["data_itemnumoflist"] = DataBlocks::itemNumOfList;
-    valueHandlers["data_lengthoflist"] = DataBlocks::lengthOfList;
-    valueHandlers["data_listcontainsitem"] = DataBlocks::listContainsItem;
+    handlers[Opcode::DATA_SETVARIABLETO] = DataBlocks::setVariable;
+    handlers[Opcode::DATA_CHANGEVARIABLEBY] = DataBlocks::changeVariable;
+    handlers[Opcode::DATA_SHOWVARIABLE] = DataBlocks::showVariable;
+    handlers[Opcode::DATA_HIDEVARIABLE] = DataBlocks::hideVariable;
+    handlers[Opcode::DATA_SHOWLIST] = DataBlocks::showList;
+    handlers[Opcode::DATA_HIDELIST] = DataBlocks::hideList;
+    handlers[Opcode::DATA_ADDTOLIST] = DataBlocks::addToList;
+    handlers[Opcode::DATA_DELETEOFLIST] = DataBlocks::deleteFromList;
+    handlers[Opcode::DATA_DELETEALLOFLIST] = DataBlocks::deleteAllOfList;
+    handlers[Opcode::DATA_INSERTATLIST] = DataBlocks::insertAtList;
+    handlers[Opcode::DATA_REPLACEITEMOFLIST] = DataBlocks::replaceItemOfList;
+    valueHandlers[Opcode::DATA_ITEMOFLIST] = DataBlocks::itemOfList;
+    valueHandlers[Opcode::DATA_ITEMNUMOFLIST] = DataBlocks::itemNumOfList;
+    valueHandlers[Opcode::DATA_LENGTHOFLIST] = DataBlocks::lengthOfList;
+    valueHandlers[Opcode::DATA_LISTCONTAINSITEM] = DataBlocks::listContainsItem;
 
     // sensing
-    handlers["sensing_resettimer"] = SensingBlocks::resetTimer;
-    handlers["sensing_askandwait"] = SensingBlocks::askAndWait;
-    handlers["sensing_setdragmode"] = SensingBlocks::setDragMode;
-    valueHandlers["sensing_timer"] = SensingBlocks::sensingTimer;
-    valueHandlers["sensing_of"] = SensingBlocks::of;
-    valueHandlers["sensing_mousex"] = SensingBlocks::mouseX;
-    valueHandlers["sensing_mousey"] = SensingBlocks::mouseY;
-    valueHandlers["sensing_distanceto"] = SensingBlocks::distanceTo;
-    valueHandlers["sensing_distancetomenu"] = SensingBlocks::distanceTo; // Menu variant
-    valueHandlers["sensing_dayssince2000"] = SensingBlocks::daysSince2000;
-    valueHandlers["sensing_current"] = SensingBlocks::current;
-    valueHandlers["sensing_answer"] = SensingBlocks::sensingAnswer;
-    valueHandlers["sensing_keypressed"] = SensingBlocks::keyPressed;
-    valueHandlers["sensing_keyoptions"] = SensingBlocks::keyPressed; // Menu variant
-    valueHandlers["sensing_touchingobject"] = SensingBlocks::touchingObject;
-    valueHandlers["sensing_touchingobjectmenu"] = SensingBlocks::touchingObject; // Menu variant
-    valueHandlers["sensing_mousedown"] = SensingBlocks::mouseDown;
-    valueHandlers["sensing_username"] = SensingBlocks::username;
+    handlers[Opcode::SENSING_RESETTIMER] = SensingBlocks::resetTimer;
+    handlers[Opcode::SENSING_ASKANDWAIT] = SensingBlocks::askAndWait;
+    handlers[Opcode::SENSING_SETDRAGMODE] = SensingBlocks::setDragMode;
+    valueHandlers[Opcode::SENSING_TIMER] = SensingBlocks::sensingTimer;
+    valueHandlers[Opcode::SENSING_OF] = SensingBlocks::of;
+    valueHandlers[Opcode::SENSING_MOUSEX] = SensingBlocks::mouseX;
+    valueHandlers[Opcode::SENSING_MOUSEY] = SensingBlocks::mouseY;
+    valueHandlers[Opcode::SENSING_DISTANCETO] = SensingBlocks::distanceTo;
+    valueHandlers[Opcode::SENSING_DISTANCETOMENU] = SensingBlocks::distanceTo; // Menu variant
+    valueHandlers[Opcode::SENSING_DAYSSINCE2000] = SensingBlocks::daysSince2000;
+    valueHandlers[Opcode::SENSING_CURRENT] = SensingBlocks::current;
+    valueHandlers[Opcode::SENSING_ANSWER] = SensingBlocks::sensingAnswer;
+    valueHandlers[Opcode::SENSING_KEYPRESSED] = SensingBlocks::keyPressed;
+    valueHandlers[Opcode::SENSING_KEYOPTIONS] = SensingBlocks::keyPressed; // Menu variant
+    valueHandlers[Opcode::SENSING_TOUCHINGOBJECT] = SensingBlocks::touchingObject;
+    valueHandlers[Opcode::SENSING_TOUCHINGOBJECTMENU] = SensingBlocks::touchingObject; // Menu variant
+    valueHandlers[Opcode::SENSING_TOUCHINGCOLOR] = SensingBlocks::touchingColor;
+    valueHandlers[Opcode::SENSING_COLORISTOUCHINGCOLOR] = SensingBlocks::colorIsTouchingColor;
+    valueHandlers[Opcode::SENSING_MOUSEDOWN] = SensingBlocks::mouseDown;
+    valueHandlers[Opcode::SENSING_USERNAME] = SensingBlocks::username;
 
     // procedures / arguments
-    handlers["procedures_call"] = ProcedureBlocks::call;
-    handlers["procedures_definition"] = ProcedureBlocks::definition;
-    valueHandlers["argument_reporter_string_number"] = ProcedureBlocks::stringNumber;
-    valueHandlers["argument_reporter_boolean"] = ProcedureBlocks::booleanArgument;
+    handlers[Opcode::PROCEDURES_CALL] = ProcedureBlocks::call;
+    handlers[Opcode::PROCEDURES_DEFINITION] = ProcedureBlocks::definition;
+    valueHandlers[Opcode::ARGUMENT_REPORTER_STRING_NUMBER] = ProcedureBlocks::stringNumber;
+    valueHandlers[Opcode::ARGUMENT_REPORTER_BOOLEAN] = ProcedureBlocks::booleanArgument;
 
     // pen extension
-    handlers["pen_penDown"] = PenBlocks::PenDown;
-    handlers["pen_penUp"] = PenBlocks::PenUp;
-    handlers["pen_clear"] = PenBlocks::EraseAll;
-    handlers["pen_setPenColorParamTo"] = PenBlocks::SetPenOptionTo;
-    handlers["pen_changePenColorParamBy"] = PenBlocks::ChangePenOptionBy;
-    handlers["pen_stamp"] = PenBlocks::Stamp;
-    handlers["pen_setPenColorToColor"] = PenBlocks::SetPenColorTo;
-    handlers["pen_setPenSizeTo"] = PenBlocks::SetPenSizeTo;
-    handlers["pen_changePenSizeBy"] = PenBlocks::ChangePenSizeBy;
+    handlers[Opcode::PEN_PENDOWN] = PenBlocks::PenDown;
+    handlers[Opcode::PEN_PENUP] = PenBlocks::PenUp;
+    handlers[Opcode::PEN_CLEAR] = PenBlocks::EraseAll;
+    handlers[Opcode::PEN_SETPENCOLORPARAMTO] = PenBlocks::SetPenOptionTo;
+    handlers[Opcode::PEN_CHANGEPENCOLORPARAMBY] = PenBlocks::ChangePenOptionBy;
+    handlers[Opcode::PEN_STAMP] = PenBlocks::Stamp;
+    handlers[Opcode::PEN_SETPENCOLORTOCOLOR] = PenBlocks::SetPenColorTo;
+    handlers[Opcode::PEN_SETPENSIZETO] = PenBlocks::SetPenSizeTo;
+    handlers[Opcode::PEN_CHANGEPENSIZEBY] = PenBlocks::ChangePenSizeBy;
 
     // Other (Don't know where else to put these)
-    valueHandlers["matrix"] = [](Block &block, Sprite *sprite) {
+    valueHandlers[Opcode::MATRIX] = [](Block &block, Sprite *sprite) {
         return Value(Scratch::getFieldValue(block, "MATRIX"));
     };
 }
 
+Block *BlockExecutor::getSubstack(Block &block, Sprite *sprite, bool second) {
+    if (block.pc >= 0) {
+        const Instruction &instruction = sprite->data->bytecode[block.pc];
+        int32_t substack = second ? instruction.substack2 : instruction.substack;
+        return substack >= 0 ? sprite->data->bytecode[substack].block : nullptr;
+    }
+
+    // not compiled, find it the slow way
+    auto it = block.parsedInputs->find(second ? "SUBSTACK2" : "SUBSTACK");
+    if (it == block.parsedInputs->end() || it->second.blockId.empty()) return nullptr;
+    auto blockIt = sprite->data->blocks.find(it->second.blockId);
+    if (blockIt == sprite->data->blocks.end()) return nullptr;
+    return &blockIt->second;
+}
+
+ScriptThread &BlockExecutor::getThread(Sprite *sprite, int32_t scriptIndex) {
+    if (scriptIndex < 0 || static_cast<size_t>(scriptIndex) >= sprite->data->scriptStateCounts.size()) {
+        detachedThread = ScriptThread();
+        return detachedThread;
+    }
+
+    // threads (and their states) are only made once something needs them, so new clones stay cheap.
+    // Both are sized in one go so references to them stay valid while scripts run.
+    if (sprite->threads.size() < sprite->data->scriptStateCounts.size()) {
+        sprite->threads.resize(sprite->data->scriptStateCounts.size());
+    }
+    ScriptThread &thread = sprite->threads[scriptIndex];
+    if (thread.states.size() < sprite->data->scriptStateCounts[scriptIndex]) {
+        thread.states.resize(sprite->data->scriptStateCounts[scriptIndex]);
+    }
+    return thread;
+}
+
+BlockState &BlockExecutor::getBlockState(Sprite *sprite, const Block &block) {
+    ScriptThread &thread = getThread(sprite, block.scriptIndex);
+    if (block.stateIndex < 0 || static_cast<size_t>(block.stateIndex) >= thread.states.size()) {
+        detachedState = BlockState();
+        return detachedState;
+    }
+    return thread.states[block.stateIndex];
+}
+
+bool BlockExecutor::isRepeating(Sprite *sprite, const Block &block) {
+    if (block.stateIndex < 0 || static_cast<size_t>(block.scriptIndex) >= sprite->threads.size()) return false;
+    const ScriptThread &thread = sprite->threads[block.scriptIndex];
+    if (static_cast<size_t>(block.stateIndex) >= thread.states.size()) return false;
+    return thread.states[block.stateIndex].isRepeating;
+}
+
 std::vector<Block *> BlockExecutor::runBlock(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     std::vector<Block *> ranBlocks;
-    auto start = std::chrono::high_resolution_clock::now();
     Block *currentBlock = &block;
 
     bool localWithoutRefresh = false;
@@ -207,6 +296,36 @@ std::vector<Block *> BlockExecutor::runBlock(Block &block, Sprite *sprite, bool
         return ranBlocks;
     }
 
+    // Run the compiled bytecode if there is any
+    if (block.pc >= 0) {
+#ifdef ENABLE_PROFILER
+        // substacks run through here too, so only the outermost run of a script counts,
+        // and it's only a new call when it starts from the top instead of resuming a loop from `repeatStack`
+        std::optional<ProfileScope> scriptScope;
+        ProfileEntry &scriptEntry = Profiler::script(sprite, block.scriptIndex);
+        if (scriptEntry.active == 0) scriptScope.emplace(scriptEntry, Profiler::Category::SCRIPT, block.topLevel);
+#endif
+        int32_t pc = block.pc;
+        while (pc >= 0) {
+            const Instruction &instruction = sprite->data->bytecode[pc];
+            Block *instructionBlock = instruction.block;
+            const int32_t next = instruction.next;
+
+            blocksRun += 1;
+            ranBlocks.push_back(instructionBlock);
+#ifdef ENABLE_PROFILER
+            ProfileScope opcodeScope(Profiler::opcode(instruction.opcode), Profiler::Category::OPCODE);
+#endif
+            const BlockResult result = handlers[instruction.opcode](*instructionBlock, sprite, withoutScreenRefresh, fromRepeat);
+            if (SpatialHash::movesSprite(instruction.opcode)) SpatialHash::markMoved(sprite);
+            if (result == BlockResult::RETURN) {
+                return ranBlocks;
+            }
+            pc = next;
+        }
+        return ranBlocks;
+    }
+
     while (currentBlock && currentBlock->id != "null") {
         blocksRun += 1;
         ranBlocks.push_back(currentBlock);
@@ -220,95 +339,93 @@ std::vector<Block *> BlockExecutor::runBlock(Block &block, Sprite *sprite, bool
 
         // Move to next block
         if (!currentBlock->next.empty()) {
-            currentBlock = &sprite->blocks[currentBlock->next];
+            currentBlock = &sprite->data->blocks[currentBlock->next];
         } else {
             break;
         }
     }
-
-    // Timing measurement
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::milli> duration = end - start;
-    if (duration.count() > 0) {
-        // std::cout << " took " << duration.count() << " milliseconds!" << std::endl;
-    }
     return ranBlocks;
 }
 
 BlockResult BlockExecutor::executeBlock(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    auto iterator = handlers.find(block.opcode);
-    if (iterator != handlers.end()) {
-        return iterator->second(block, sprite, withoutScreenRefresh, fromRepeat);
-    }
-
-    return BlockResult::CONTINUE;
+    const BlockResult result = handlers[block.opcodeId](block, sprite, withoutScreenRefresh, fromRepeat);
+    if (SpatialHash::movesSprite(block.opcodeId)) SpatialHash::markMoved(sprite);
+    return result;
 }
 
 void BlockExecutor::runRepeatBlocks() {
-    blocksRun = 0;
     bool withoutRefresh = false;
+    // Sprites may have been dragged or re-rendered at a new size since the last tick
+    SpatialHash::invalidate();
+    Layers::updateSprites();
 
     // repeat ONLY the block most recently added to the repeat chain,,,
     std::vector<Sprite *> sprToRun = sprites;
     for (auto &sprite : sprToRun) {
-        for (auto &[id, blockChain] : sprite->blockChains) {
-            auto &repeatList = blockChain.blocksToRepeat;
-            if (!repeatList.empty()) {
-                std::string toRepeat = repeatList.back();
-                if (!toRepeat.empty()) {
-                    Block *toRun = &sprite->blocks[toRepeat];
-                    if (toRun != nullptr) {
-                        executor.runBlock(*toRun, sprite, &withoutRefresh, true);
-                    }
-                }
-            }
+        for (size_t i = 0; i < sprite->threads.size(); i++) {
+            const ScriptThread &thread = sprite->threads[i];
+            // custom blocks that ran out of time without screen refresh are picked up by the block that called them
+            if (thread.repeatStack.empty() || thread.warpYielded) continue;
+            executor.runBlock(*sprite->data->bytecode[thread.repeatStack.back()].block, sprite, &withoutRefresh, true);
         }
     }
     // delete sprites ready for deletion
 
+    std::vector<Sprite *> deletedSprites;
     for (auto &toDelete : sprites) {
         if (!toDelete->toDelete) continue;
-        for (auto &[id, block] : toDelete->blocks) {
-            for (std::string repeatID : toDelete->blockChains[block.blockChainID].blocksToRepeat) {
-                Block *repeatBlock = findBlock(repeatID);
-                if (repeatBlock) {
-                    repeatBlock->repeatTimes = -1;
-                }
-            }
-        }
-        toDelete->isDeleted = true;
+        toDelete->threads.clear();
+        Layers::remove(toDelete);
+        deletedSprites.push_back(toDelete);
     }
+    removeHats(deletedSprites);
     sprites.erase(std::remove_if(sprites.begin(), sprites.end(),
                                  [](Sprite *s) { return s->toDelete; }),
                   sprites.end());
+    for (Sprite *sprite : deletedSprites) {
+        releaseSprite(sprite);
+    }
+    if (!deletedSprites.empty()) SpatialHash::invalidate();
 }
 
-void BlockExecutor::runRepeatsWithoutRefresh(Sprite *sprite, std::string blockChainID) {
+void BlockExecutor::runRepeatsWithoutRefresh(Sprite *sprite, int32_t scriptIndex) {
     bool withoutRefresh = true;
-    if (sprite->blockChains.find(blockChainID) != sprite->blockChains.end()) {
-        while (!sprite->blockChains[blockChainID].blocksToRepeat.empty()) {
-            std::string toRepeat = sprite->blockChains[blockChainID].blocksToRepeat.back();
-            Block *toRun = findBlock(toRepeat);
-            if (toRun != nullptr)
-                executor.runBlock(*toRun, sprite, &withoutRefresh, true);
+    if (scriptIndex < 0) return;
+    ScriptThread &thread = getThread(sprite, scriptIndex);
+    thread.warpYielded = false;
+
+    // nested warp scripts (custom blocks calling custom blocks) share the outermost one's time
+    const bool outermost = warpDepth == 0;
+    if (outermost) warpTimer.start();
+    warpDepth++;
+    while (!thread.repeatStack.empty() && !sprite->toDelete) {
+        if (Scratch::warpTimeLimit > 0 && warpTimer.getTimeMs() >= Scratch::warpTimeLimit) {
+            thread.warpYielded = true;
+            break;
         }
+        executor.runBlock(*sprite->data->bytecode[thread.repeatStack.back()].block, sprite, &withoutRefresh, true);
     }
+    warpDepth--;
+
+#ifdef ENABLE_PROFILER
+    if (outermost && thread.warpYielded) Profiler::warpStall(warpTimer.getTimeMs());
+#endif
 }
 
 BlockResult BlockExecutor::runCustomBlock(Sprite *sprite, Block &block, Block *callerBlock, bool *withoutScreenRefresh) {
-    for (auto &[id, data] : sprite->customBlocks) {
+    for (auto &[id, data] : sprite->data->customBlocks) {
         if (id == block.customBlockId) {
             // Set up argument values
             for (std::string arg : data.argumentIds) {
-                data.argumentValues[arg] = block.parsedInputs->find(arg) == block.parsedInputs->end() ? Value(0) : Scratch::getInputValue(block, arg, sprite);
+                sprite->customBlockArguments[id][arg] = block.parsedInputs->find(arg) == block.parsedInputs->end() ? Value(0) : Scratch::getInputValue(block, arg, sprite);
             }
 
             // std::cout << "running custom block " << data.blockId << std::endl;
 
             // Get the parent of the prototype block (the definition containing all blocks)
-            Block *customBlockDefinition = &sprite->blocks[sprite->blocks[data.blockId].parent];
+            Block *customBlockDefinition = &sprite->data->blocks[sprite->data->blocks[data.blockId].parent];
 
-            callerBlock->customBlockPtr = customBlockDefinition;
+            getBlockState(sprite, *callerBlock).customBlockPtr = customBlockDefinition;
 
             bool localWithoutRefresh = data.runWithoutScreenRefresh;
 
@@ -319,11 +436,14 @@ BlockResult BlockExecutor::runCustomBlock(Sprite *sprite, Block &block, Block *c
 
             // std::cout << "RWSR = " << localWithoutRefresh << std::endl;
 
+#ifdef ENABLE_PROFILER
+            ProfileScope customBlockScope(Profiler::customBlock(sprite, data), Profiler::Category::CUSTOM_BLOCK);
+#endif
             // Execute the custom block definition
             executor.runBlock(*customBlockDefinition, sprite, &localWithoutRefresh);
 
             if (localWithoutRefresh) {
-                BlockExecutor::runRepeatsWithoutRefresh(sprite, customBlockDefinition->blockChainID);
+                BlockExecutor::runRepeatsWithoutRefresh(sprite, customBlockDefinition->scriptIndex);
             }
 
             break;
@@ -379,18 +499,8 @@ BlockResult BlockExecutor::runCustomBlock(Sprite *sprite, Block &block, Block *c
 }
 
 std::vector<std::pair<Block *, Sprite *>> BlockExecutor::runBroadcast(std::string broadcastToRun) {
-    std::vector<std::pair<Block *, Sprite *>> blocksToRun;
-
-    // find all matching "when I receive" blocks
-    std::vector<Sprite *> sprToRun = sprites;
-    for (auto *currentSprite : sprToRun) {
-        for (auto &[id, block] : currentSprite->blocks) {
-            if (block.opcode == "event_whenbroadcastreceived" &&
-                Scratch::getFieldValue(block, "BROADCAST_OPTION") == broadcastToRun) {
-                blocksToRun.push_back({&block, currentSprite});
-            }
-        }
-    }
+    // a copy of the matching "when I receive" blocks, since running them can create or delete Clones
+    std::vector<std::pair<Block *, Sprite *>> blocksToRun = getHats(Opcode::EVENT_WHENBROADCASTRECEIVED, broadcastToRun);
 
     // run each matching block
     for (auto &[blockPtr, spritePtr] : blocksToRun) {
@@ -421,52 +531,200 @@ std::vector<std::pair<Block *, Sprite *>> BlockExecutor::runBroadcasts() {
     return blocksToRun;
 }
 
-std::vector<Block *> BlockExecutor::runAllBlocksByOpcode(std::string opcodeToFind) {
-    // std::cout << "Running all " << opcodeToFind << " blocks." << "\n";
+std::vector<Block *> BlockExecutor::runAllBlocksByOpcode(Opcode opcodeToFind) {
     std::vector<Block *> blocksRun;
-    std::vector<Sprite *> sprToRun = sprites;
-    for (Sprite *currentSprite : sprToRun) {
-        for (auto &[id, data] : currentSprite->blocks) {
-            if (data.opcode == opcodeToFind) {
-                // runBlock(data,currentSprite);
-                blocksRun.push_back(&data);
-                executor.runBlock(data, currentSprite);
-            }
+    std::vector<std::pair<Block *, Sprite *>> blocksToRun;
+    auto &byKey = hatIndex[opcodeToFind];
+    if (byKey.size() == 1) {
+        blocksToRun = sortedHats(byKey.begin()->second);
+    } else {
+        for (auto &[key, list] : byKey) {
+            blocksToRun.insert(blocksToRun.end(), list.hats.begin(), list.hats.end());
         }
+        sortByLayer(blocksToRun);
+    }
+    for (auto &[block, currentSprite] : blocksToRun) {
+        blocksRun.push_back(block);
+        executor.runBlock(*block, currentSprite);
     }
     return blocksRun;
 }
 
-Value BlockExecutor::getBlockValue(Block &block, Sprite *sprite) {
-    auto iterator = valueHandlers.find(block.opcode);
-    if (iterator != valueHandlers.end()) {
-        return iterator->second(block, sprite);
+std::vector<Block *> BlockExecutor::runKeyHats(const std::vector<std::string> &keys) {
+    std::vector<Block *> blocksRun;
+    auto &byKey = hatIndex[Opcode::EVENT_WHENKEYPRESSED];
+    if (byKey.empty()) return blocksRun;
+
+    // a key can be pressed more than once (a keyboard key and a button mapped to it), but its hats only run once
+    std::vector<HatList *> lists;
+    for (const std::string &key : keys) {
+        auto it = byKey.find(key);
+        if (it != byKey.end() && std::find(lists.begin(), lists.end(), &it->second) == lists.end()) lists.push_back(&it->second);
     }
+    if (lists.empty()) return blocksRun;
 
-    return Value();
+    std::vector<std::pair<Block *, Sprite *>> blocksToRun;
+    if (lists.size() == 1) {
+        blocksToRun = sortedHats(*lists.front());
+    } else {
+        for (HatList *list : lists) {
+            blocksToRun.insert(blocksToRun.end(), list->hats.begin(), list->hats.end());
+        }
+        sortByLayer(blocksToRun);
+    }
+    for (auto &[block, currentSprite] : blocksToRun) {
+        blocksRun.push_back(block);
+        executor.runBlock(*block, currentSprite);
+    }
+    return blocksRun;
 }
 
-void BlockExecutor::setVariableValue(const std::string &variableId, const Value &newValue, Sprite *sprite) {
-    // Set sprite variable
-    auto it = sprite->variables.find(variableId);
-    if (it != sprite->variables.end()) {
-        it->second.value = newValue;
-        return;
-    }
-
-    // Set global variable
-    for (auto &currentSprite : sprites) {
-        if (currentSprite->isStage) {
-            auto globalIt = currentSprite->variables.find(variableId);
-            if (globalIt != currentSprite->variables.end()) {
-                globalIt->second.value = newValue;
-#ifdef ENABLE_CLOUDVARS
-                if (globalIt->second.cloud) cloudConnection->set(globalIt->second.name, globalIt->second.value.asString());
+std::string BlockExecutor::getHatKey(Block &hat) {
+    switch (hat.opcodeId) {
+    case Opcode::EVENT_WHENBROADCASTRECEIVED:
+        return Scratch::getFieldValue(hat, "BROADCAST_OPTION");
+    case Opcode::EVENT_WHENBACKDROPSWITCHESTO:
+        return Scratch::getFieldValue(hat, "BACKDROP");
+    case Opcode::EVENT_WHENKEYPRESSED:
+        return Scratch::getFieldValue(hat, "KEY_OPTION");
+    default:
+        return "";
+    }
+}
+
+void BlockExecutor::addHats(Sprite *sprite) {
+    for (Block *hat : sprite->data->hats) {
+        HatList &list = hatIndex[hat->opcodeId][getHatKey(*hat)];
+        list.hats.push_back({hat, sprite});
+        list.sorted = false;
+    }
+}
+
+void BlockExecutor::removeHats(const std::vector<Sprite *> &deletedSprites) {
+    if (deletedSprites.empty()) return;
+    std::unordered_set<Sprite *> deleted(deletedSprites.begin(), deletedSprites.end());
+
+    // only the lists the deleted Sprites were in need to be filtered, and each of them only once
+    // (removing hats keeps the rest in order, so a sorted list stays sorted)
+    std::unordered_set<HatList *> lists;
+    for (Sprite *sprite : deletedSprites) {
+        for (Block *hat : sprite->data->hats) {
+            auto &byKey = hatIndex[hat->opcodeId];
+            auto it = byKey.find(getHatKey(*hat));
+            if (it != byKey.end()) lists.insert(&it->second);
+        }
+    }
+    for (HatList *list : lists) {
+        list->hats.erase(std::remove_if(list->hats.begin(), list->hats.end(),
+                                        [&deleted](const std::pair<Block *, Sprite *> &hat) { return deleted.count(hat.second) != 0; }),
+                         list->hats.end());
+    }
+}
+
+void BlockExecutor::clearHats() {
+    for (auto &byKey : hatIndex.entries) {
+        byKey.clear();
+    }
+}
+
+std::vector<std::pair<Block *, Sprite *>> BlockExecutor::getHats(Opcode opcode, const std::string &fieldValue) {
+    auto &byKey = hatIndex[opcode];
+    auto it = byKey.find(fieldValue);
+    if (it == byKey.end()) return {};
+    return sortedHats(it->second);
+}
+
+const std::vector<std::pair<Block *, Sprite *>> &BlockExecutor::sortedHats(HatList &list) {
+    if (!list.sorted || list.sortedAt != Layers::version()) {
+        sortByLayer(list.hats);
+        list.sorted = true;
+        list.sortedAt = Layers::version();
+    }
+    return list.hats;
+}
+
+Value BlockExecutor::getBlockValue(Block &block, Sprite *sprite) {
+#ifdef ENABLE_PROFILER
+    ProfileScope scope(Profiler::opcode(block.opcodeId), Profiler::Category::OPCODE);
 #endif
-                return;
+    return valueHandlers[block.opcodeId](block, sprite);
+}
+
+VariableRef BlockExecutor::resolveVariable(const std::string &id, Sprite *sprite, bool list) {
+    VariableRef ref;
+    for (Sprite *target : {sprite, stageSprite}) {
+        if (!target) continue;
+        if (!list) {
+            auto it = target->data->variableSlots.find(id);
+            if (it != target->data->variableSlots.end()) {
+                ref.scope = target == sprite ? VariableRef::SPRITE : VariableRef::STAGE;
+                ref.slot = it->second;
+                return ref;
             }
         }
+        auto listIt = target->data->listSlots.find(id);
+        if (listIt != target->data->listSlots.end()) {
+            ref.scope = target == sprite ? VariableRef::SPRITE : VariableRef::STAGE;
+            ref.isList = true;
+            ref.slot = listIt->second;
+            return ref;
+        }
+    }
+    return ref;
+}
+
+Variable *BlockExecutor::getVariable(const VariableRef &ref, Sprite *sprite) {
+    if (ref.isList) return nullptr;
+    switch (ref.scope) {
+    case VariableRef::SPRITE:
+        return ref.slot < sprite->variables.size() ? &sprite->variables[ref.slot] : nullptr;
+    case VariableRef::STAGE:
+        return stageSprite && ref.slot < stageSprite->variables.size() ? &stageSprite->variables[ref.slot] : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+List *BlockExecutor::getList(const VariableRef &ref, Sprite *sprite) {
+    if (!ref.isList) return nullptr;
+    switch (ref.scope) {
+    case VariableRef::SPRITE:
+        return ref.slot < sprite->lists.size() ? &sprite->lists[ref.slot] : nullptr;
+    case VariableRef::STAGE:
+        return stageSprite && ref.slot < stageSprite->lists.size() ? &stageSprite->lists[ref.slot] : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+std::string BlockExecutor::joinList(const List &list, const std::string &separator) {
+    std::string result;
+    std::string itemSeparator = "";
+    for (const auto &item : list.items) {
+        if (item.asString().size() > 1) {
+            itemSeparator = separator;
+            break;
+        }
     }
+    for (const auto &item : list.items) {
+        result += item.asString() + itemSeparator;
+    }
+    if (!result.empty() && !itemSeparator.empty()) result.pop_back();
+    return result;
+}
+
+void BlockExecutor::setVariableValue(const std::string &variableId, const Value &newValue, Sprite *sprite) {
+    setVariableValue(resolveVariable(variableId, sprite), newValue, sprite);
+}
+
+void BlockExecutor::setVariableValue(const VariableRef &ref, const Value &newValue, Sprite *sprite) {
+    Variable *variable = getVariable(ref, sprite);
+    if (!variable) return;
+    variable->value = newValue;
+    variable->value.isNumeric(); // caches the number in the variable, so it isn't parsed every time the variable is read
+#ifdef ENABLE_CLOUDVARS
+    if (ref.scope == VariableRef::STAGE && variable->cloud) cloudConnection->set(variable->name, variable->value.asString());
+#endif
 }
 
 Value BlockExecutor::getMonitorValue(Monitor &var) {
@@ -483,61 +741,28 @@ Value BlockExecutor::getMonitorValue(Monitor &var) {
     }
 
     std::string monitorName = "";
-    if (var.opcode == "data_variable") {
+    switch (var.opcodeId) {
+    case Opcode::DATA_VARIABLE:
         var.value = BlockExecutor::getVariableValue(var.id, sprite);
         monitorName = Math::removeQuotations(var.parameters["VARIABLE"]);
-    } else if (var.opcode == "data_listcontents") {
+        break;
+    case Opcode::DATA_LISTCONTENTS: {
         monitorName = Math::removeQuotations(var.parameters["LIST"]);
-        // Check lists
-        auto listIt = sprite->lists.find(var.id);
-        if (listIt != sprite->lists.end()) {
-            std::string result;
-            std::string seperator = "";
-            for (const auto &item : listIt->second.items) {
-                if (item.asString().size() > 1) {
-                    seperator = "\n";
-                    break;
-                }
-            }
-            for (const auto &item : listIt->second.items) {
-                result += item.asString() + seperator;
-            }
-            if (!result.empty() && !seperator.empty()) result.pop_back();
-            Value val(result);
-            var.value = val;
-        }
-
-        // Check global lists
-        for (const auto &currentSprite : sprites) {
-            if (currentSprite->isStage) {
-                auto globalIt = currentSprite->lists.find(var.id);
-                if (globalIt != currentSprite->lists.end()) {
-                    std::string result;
-                    std::string seperator = "";
-                    for (const auto &item : globalIt->second.items) {
-                        if (item.asString().size() > 1) {
-                            seperator = "\n";
-                            break;
-                        }
-                    }
-                    for (const auto &item : globalIt->second.items) {
-                        result += item.asString() + seperator;
-                    }
-                    if (!result.empty() && !seperator.empty()) result.pop_back();
-                    Value val(result);
-                    var.value = val;
-                }
-            }
-        }
-    } else {
+        List *list = getList(resolveVariable(var.id, sprite, true), sprite);
+        if (list) var.value = Value(joinList(*list, "\n"));
+        break;
+    }
+    default:
         try {
             Block newBlock;
             newBlock.opcode = var.opcode;
+            newBlock.opcodeId = var.opcodeId;
             monitorName = var.opcode;
             var.value = executor.getBlockValue(newBlock, sprite);
         } catch (...) {
             var.value = Value("Unknown...");
         }
+        break;
     }
 
     std::string renderText;
@@ -552,77 +777,25 @@ Value BlockExecutor::getMonitorValue(Monitor &var) {
 }
 
 Value BlockExecutor::getVariableValue(std::string variableId, Sprite *sprite) {
-    // Check sprite variables
-    auto it = sprite->variables.find(variableId);
-    if (it != sprite->variables.end()) {
-        return it->second.value;
-    }
-
-    // Check lists
-    auto listIt = sprite->lists.find(variableId);
-    if (listIt != sprite->lists.end()) {
-        std::string result;
-        std::string seperator = "";
-        for (const auto &item : listIt->second.items) {
-            if (item.asString().size() > 1) {
-                seperator = " ";
-                break;
-            }
-        }
-        for (const auto &item : listIt->second.items) {
-            result += item.asString() + seperator;
-        }
-        if (!result.empty() && !seperator.empty()) result.pop_back();
-        Value val(result);
-        return val;
-    }
-
-    // Check global variables
-    for (const auto &currentSprite : sprites) {
-        if (currentSprite->isStage) {
-            auto globalIt = currentSprite->variables.find(variableId);
-            if (globalIt != currentSprite->variables.end()) {
-                return globalIt->second.value;
-            }
-        }
-    }
+    return getVariableValue(resolveVariable(variableId, sprite), sprite);
+}
 
-    // Check global lists
-    for (const auto &currentSprite : sprites) {
-        if (currentSprite->isStage) {
-            auto globalIt = currentSprite->lists.find(variableId);
-            if (globalIt != currentSprite->lists.end()) {
-                std::string result;
-                std::string seperator = "";
-                for (const auto &item : globalIt->second.items) {
-                    if (item.asString().size() > 1) {
-                        seperator = " ";
-                        break;
-                    }
-                }
-                for (const auto &item : globalIt->second.items) {
-                    result += item.asString() + seperator;
-                }
-                if (!result.empty() && !seperator.empty()) result.pop_back();
-                Value val(result);
-                return val;
-            }
-        }
+Value BlockExecutor::getVariableValue(const VariableRef &ref, Sprite *sprite) {
+    if (ref.isList) {
+        List *list = getList(ref, sprite);
+        return list ? Value(joinList(*list, " ")) : Value();
     }
-
-    return Value();
+    Variable *variable = getVariable(ref, sprite);
+    return variable ? variable->value : Value();
 }
 
 #ifdef ENABLE_CLOUDVARS
 void BlockExecutor::handleCloudVariableChange(const std::string &name, const std::string &value) {
-    for (const auto &currentSprite : sprites) {
-        if (currentSprite->isStage) {
-            for (auto it = currentSprite->variables.begin(); it != currentSprite->variables.end(); ++it) {
-                if (it->second.name == name) {
-                    it->second.value = Value(value);
-                    return;
-                }
-            }
+    if (!stageSprite) return;
+    for (Variable &variable : stageSprite->variables) {
+        if (variable.name == name) {
+            variable.value = Value(value);
+            return;
         }
     }
 }
@@ -634,7 +807,7 @@ Value BlockExecutor::getCustomBlockValue(std::string valueName, Sprite *sprite,
     Block *definitionBlock = getBlockParent(&block);
     Block *prototypeBlock = findBlock(Scratch::getInputValue(*definitionBlock, "custom_block", sprite).asString());
 
-    for (auto &[custId, custBlock] : sprite->customBlocks) {
+    for (auto &[custId, custBlock] : sprite->data->customBlocks) {
 
         // variable must be in the same custom block
         if (prototypeBlock != nullptr && custBlock.blockId != prototypeBlock->id) continue;
@@ -647,8 +820,9 @@ Value BlockExecutor::getCustomBlockValue(std::string valueName, Sprite *sprite,
             if (index < custBlock.argumentIds.size()) {
                 std::string argumentId = custBlock.argumentIds[index];
 
-                auto valueIt = custBlock.argumentValues.find(argumentId);
-                if (valueIt != custBlock.argumentValues.end()) {
+                auto &argumentValues = sprite->customBlockArguments[custId];
+                auto valueIt = argumentValues.find(argumentId);
+                if (valueIt != argumentValues.end()) {
                     return valueIt->second;
                 } else {
                     Log::logWarning("Argument ID found, but no value exists for it.");
@@ -662,29 +836,42 @@ Value BlockExecutor::getCustomBlockValue(std::string valueName, Sprite *sprite,
 }
 
 void BlockExecutor::addToRepeatQueue(Sprite *sprite, Block *block) {
-    auto &repeatList = sprite->blockChains[block->blockChainID].blocksToRepeat;
-    if (std::find(repeatList.begin(), repeatList.end(), block->id) == repeatList.end()) {
-        block->isRepeating = true;
-        repeatList.push_back(block->id);
+    // blocks that aren't compiled or have nowhere to keep their state can't be picked up again
+    if (block->pc < 0 || block->stateIndex < 0) return;
+    ScriptThread &thread = getThread(sprite, block->scriptIndex);
+    if (static_cast<size_t>(block->stateIndex) >= thread.states.size()) return;
+    auto &repeatStack = thread.repeatStack;
+    if (std::find(repeatStack.begin(), repeatStack.end(), block->pc) == repeatStack.end()) {
+        getBlockState(sprite, *block).isRepeating = true;
+        repeatStack.push_back(block->pc);
     }
 }
 
 void BlockExecutor::removeFromRepeatQueue(Sprite *sprite, Block *block) {
-    auto it = sprite->blockChains.find(block->blockChainID);
-    if (it != sprite->blockChains.end()) {
-        auto &blocksToRepeat = it->second.blocksToRepeat;
-        if (!blocksToRepeat.empty()) {
-            block->isRepeating = false;
-            block->repeatTimes = -1;
-            blocksToRepeat.pop_back();
-        }
+    ScriptThread &thread = getThread(sprite, block->scriptIndex);
+    if (!thread.repeatStack.empty()) {
+        BlockState &state = getBlockState(sprite, *block);
+        state.isRepeating = false;
+        state.repeatTimes = -1;
+        thread.repeatStack.pop_back();
     }
 }
 
-bool BlockExecutor::hasActiveRepeats(Sprite *sprite, std::string blockChainID) {
-    if (sprite->toDelete) return false;
-    if (sprite->blockChains.find(blockChainID) != sprite->blockChains.end()) {
-        if (!sprite->blockChains[blockChainID].blocksToRepeat.empty()) return true;
+void BlockExecutor::stopThread(Sprite *sprite, int32_t scriptIndex) {
+    if (scriptIndex < 0 || static_cast<size_t>(scriptIndex) >= sprite->threads.size()) return;
+    ScriptThread &thread = sprite->threads[scriptIndex];
+    for (int32_t pc : thread.repeatStack) {
+        if (pc < 0 || static_cast<size_t>(pc) >= sprite->data->bytecode.size()) continue;
+        const Block *repeatBlock = sprite->data->bytecode[pc].block;
+        if (repeatBlock->stateIndex < 0 || static_cast<size_t>(repeatBlock->stateIndex) >= thread.states.size()) continue;
+        thread.states[repeatBlock->stateIndex].repeatTimes = -1;
     }
-    return false;
+    thread.repeatStack.clear();
+    thread.warpYielded = false;
+}
+
+bool BlockExecutor::hasActiveRepeats(Sprite *sprite, int32_t scriptIndex) {
+    if (sprite->toDelete) return false;
+    if (scriptIndex < 0 || static_cast<size_t>(scriptIndex) >= sprite->threads.size()) return false;
+    return !sprite->threads[scriptIndex].repeatStack.empty();
 }
@@ -1,7 +1,8 @@
 #pragma once
+#include "opcodes.hpp"
 #include "os.hpp"
 #include "sprite.hpp"
-#include <functional>
+#include <cstdint>
 #include <unordered_map>
 
 // Number of blocks run in a single frame.
@@ -15,11 +16,13 @@ enum class BlockResult {
     RETURN,
 };
 
+typedef BlockResult (*BlockHandler)(Block &, Sprite *, bool *, bool);
+typedef Value (*ValueHandler)(Block &, Sprite *);
+
 class BlockExecutor {
   private:
-    std::unordered_map<std::string, std::function<BlockResult(Block &, Sprite *, bool *, bool)>> handlers;
-    std::unordered_map<std::string, std::function<Value(Block &, Sprite *)>> valueHandlers;
-    // std::unordered_map<Block::opCode, std::function<Value(Block&,Sprite*)>> conditionBlockHandlers;
+    OpcodeTable<BlockHandler> handlers;
+    OpcodeTable<ValueHandler> valueHandlers;
 
   public:
     /**
@@ -37,21 +40,62 @@ class BlockExecutor {
     std::vector<Block *> runBlock(Block &block, Sprite *sprite, bool *withoutScreenRefresh = nullptr, bool fromRepeat = false);
 
     /**
-     * Goes through every `block` in every `sprite` to find and run a block with the specified `opCode`.
-     * @param opCodeToFind Name of the block to run
+     * Gets the `ScriptThread` of a script in a `sprite`, creating the Sprite's threads if it doesn't have them yet.
+     * @param sprite Pointer to the Sprite (or Clone).
+     * @param scriptIndex Index of the script. `(block->scriptIndex)`
+     * @return The thread of the script, or an empty throwaway one if `scriptIndex` is out of range.
+     */
+    static ScriptThread &getThread(Sprite *sprite, int32_t scriptIndex);
+
+    /**
+     * Gets the runtime state (loop counters, timers, etc.) of a `block` for a specific `sprite`.
+     * It's stored in the `ScriptThread` the block is in. Only blocks with a `stateIndex` have one, see `Compiler::needsState()`.
+     * @param sprite Pointer to the Sprite (or Clone) running the block.
+     * @param block Reference to the block
+     * @return The `BlockState` of the block, or a fresh throwaway one if the block's indices are out of range.
+     */
+    static BlockState &getBlockState(Sprite *sprite, const Block &block);
+
+    /**
+     * Checks if a `block` is currently in its Sprite's repeat queue.
+     * @param sprite Pointer to the Sprite (or Clone) running the block.
+     * @param block Reference to the block
+     */
+    static bool isRepeating(Sprite *sprite, const Block &block);
+
+    /**
+     * Gets the first block inside a C block's `SUBSTACK` (or `SUBSTACK2`).
+     * @param block Reference to the C block
+     * @param sprite Pointer to the Sprite the block is inside.
+     * @param second Whether to get `SUBSTACK2` (the 'else' part of an if/else) instead.
+     * @return A `Block*` if the substack has blocks in it, `nullptr` otherwise.
+     */
+    static Block *getSubstack(Block &block, Sprite *sprite, bool second = false);
+
+    /**
+     * Runs every hat block with the specified `opCode`, in every `sprite` it's indexed for, front to back and then the Stage.
+     * @param opCodeToFind The block to run
+     */
+    static std::vector<Block *> runAllBlocksByOpcode(Opcode opcodeToFind);
+
+    /**
+     * Runs every `when key pressed` hat block for the pressed `keys`, front to back and then the Stage.
+     * @param keys Scratch names of the pressed keys, like `Input::inputButtons`. Include "any" to run `when any key pressed` hats.
      */
-    static std::vector<Block *> runAllBlocksByOpcode(std::string opcodeToFind);
+    static std::vector<Block *> runKeyHats(const std::vector<std::string> &keys);
 
     /**
      * Goes through every currently active repeat block in every `sprite` and runs it once.
      */
     static void runRepeatBlocks();
     /**
-     * Goes through every currently active repeat block in every `sprite` and runs it until completion.
+     * Goes through every currently active repeat block in every `sprite` and runs it until completion,
+     * or until it has run for `Scratch::warpTimeLimit`. Then it's marked `ScriptThread::warpYielded`,
+     * and the custom block call that started it picks it up again next frame.
      * @param sprite Pointer to the Sprite the Blocks are inside.
-     * @param blockChainId ID of the Block Chain to run. `(block->blockChainId)`
+     * @param scriptIndex Index of the script to run. `(block->scriptIndex)`
      */
-    static void runRepeatsWithoutRefresh(Sprite *sprite, std::string blockChainID);
+    static void runRepeatsWithoutRefresh(Sprite *sprite, int32_t scriptIndex);
 
     /**
      * Runs and executes a `Custom Block` (Scratch's 'My Block')
@@ -83,6 +127,31 @@ class BlockExecutor {
      */
     Value getBlockValue(Block &block, Sprite *sprite);
 
+    /**
+     * Finds the slot of a variable (or list) `id`, first in the `sprite`, then in the Stage.
+     * @param id ID of the variable or list to find
+     * @param sprite Pointer to the sprite the variable is used in.
+     * @param list Whether to look for a list. If `false`, variables are checked first and lists after.
+     * @return The resolved reference, with a `NONE` scope if the variable doesn't exist.
+     */
+    static VariableRef resolveVariable(const std::string &id, Sprite *sprite, bool list = false);
+
+    /**
+     * Gets the variable a resolved reference points to.
+     * @param ref Reference from `resolveVariable()`
+     * @param sprite Pointer to the Sprite (or Clone) using the variable.
+     * @return A pointer to the Variable, or `nullptr` if it's a list or doesn't exist.
+     */
+    static Variable *getVariable(const VariableRef &ref, Sprite *sprite);
+
+    /**
+     * Gets the list a resolved reference points to.
+     * @param ref Reference from `resolveVariable()`
+     * @param sprite Pointer to the Sprite (or Clone) using the list.
+     * @return A pointer to the List, or `nullptr` if it's a variable or doesn't exist.
+     */
+    static List *getList(const VariableRef &ref, Sprite *sprite);
+
     /**
      * Gets the Value of the specified Scratch variable.
      * @param variableId ID of the variable to find
@@ -91,6 +160,14 @@ class BlockExecutor {
      */
     static Value getVariableValue(std::string variableId, Sprite *sprite);
 
+    /**
+     * Gets the Value of a resolved Scratch variable. Lists are joined into a single string.
+     * @param ref Reference from `resolveVariable()`
+     * @param sprite Pointer to the Sprite (or Clone) using the variable.
+     * @return The Value of the Variable.
+     */
+    static Value getVariableValue(const VariableRef &ref, Sprite *sprite);
+
     /**
      * Gets the Value of the specified Monitor (a Monitor is just a variable that shows up on the screen).
      * @param var The Monitor to find the value of
@@ -115,6 +192,14 @@ class BlockExecutor {
      */
     static void setVariableValue(const std::string &variableId, const Value &newValue, Sprite *sprite);
 
+    /**
+     * Sets the Value of a resolved Scratch variable.
+     * @param ref Reference from `resolveVariable()`
+     * @param newValue the new Value to set.
+     * @param sprite Pointer to the Sprite (or Clone) using the variable.
+     */
+    static void setVariableValue(const VariableRef &ref, const Value &newValue, Sprite *sprite);
+
 #ifdef ENABLE_CLOUDVARS
     /**
      * Called when a cloud variable is changed by another user. Updates that variable
@@ -136,14 +221,80 @@ class BlockExecutor {
     /**
      * Checks if a chain of blocks has any repeating blocks inside.
      * @param sprite pointer to the Sprite the blocks are inside.
-     * @param blockChainId ID of the Block Chain to check. `(block->blockChainId)`
+     * @param scriptIndex Index of the script to check. `(block->scriptIndex)`
+     */
+    static bool hasActiveRepeats(Sprite *sprite, int32_t scriptIndex);
+
+    /**
+     * Stops a script, clearing its repeat queue.
+     * @param sprite pointer to the Sprite the script is running in.
+     * @param scriptIndex Index of the script to stop. `(block->scriptIndex)`
+     */
+    static void stopThread(Sprite *sprite, int32_t scriptIndex);
+
+    /**
+     * Adds every hat block in a `sprite` to the hat index, so events only have to look at the scripts they start.
+     * Must be called once for every Sprite after it's compiled, and for every Clone when it's created.
+     * @param sprite Pointer to the Sprite (or Clone).
+     */
+    static void addHats(Sprite *sprite);
+
+    /**
+     * Removes every hat block of the `deletedSprites` from the hat index.
+     * @param deletedSprites Sprites (or Clones) that are being deleted.
+     */
+    static void removeHats(const std::vector<Sprite *> &deletedSprites);
+
+    /**
+     * Removes everything from the hat index. Called when the project is unloaded.
      */
-    static bool hasActiveRepeats(Sprite *sprite, std::string blockChainID);
+    static void clearHats();
+
+    /**
+     * Gets every indexed hat block with the specified `opcode` and field value, along with the Sprite to run it in.
+     * @param opcode Opcode of the hat block.
+     * @param fieldValue Value of the hat's field (the broadcast name for `when I receive`, the backdrop name for `when backdrop switches to`,
+     * the key for `when key pressed`.)
+     * Leave empty for hats that don't have a field.
+     * @return A Vector pair of every matching block and its Sprite, in the order they should run: front to back, then the Stage.
+     */
+    static std::vector<std::pair<Block *, Sprite *>> getHats(Opcode opcode, const std::string &fieldValue = "");
 
     // For the `Timer` Scratch block.
     static Timer timer;
 
   private:
+    struct HatList {
+        std::vector<std::pair<Block *, Sprite *>> hats;
+        // whether `hats` is in the order to run them, as of `Layers::version()` being `sortedAt`
+        bool sorted = false;
+        uint64_t sortedAt = 0;
+    };
+
+    // hat blocks of every running Sprite, by opcode and field value
+    static OpcodeTable<std::unordered_map<std::string, HatList>> hatIndex;
+
+    /**
+     * Gets the hats in a `list` in the order they should run, sorting it first if a Sprite was added or moved since it last was.
+     * @param list Reference to a list in `hatIndex`
+     */
+    static const std::vector<std::pair<Block *, Sprite *>> &sortedHats(HatList &list);
+
+    /**
+     * Gets the field value a hat block is indexed by.
+     * @param hat Reference to the hat block
+     * @return The value of the hat's field, or an empty string if it doesn't have one.
+     */
+    static std::string getHatKey(Block &hat);
+
+    /**
+     * Joins the items of a `list` into one string, the way Scratch shows a list used as a variable.
+     * @param list Reference to the List
+     * @param separator Put between items, unless every item is a single character.
+     * @return The joined items.
+     */
+    static std::string joinList(const List &list, const std::string &separator);
+
     /**
      * Registers every block function to the lookup map.
      * If you're adding new blocks, they MUST be put in this function to be able to run.
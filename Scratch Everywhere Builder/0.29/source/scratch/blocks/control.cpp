@@ -2,23 +2,71 @@
 #include "../audio.hpp"
 #include "blockExecutor.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "os.hpp"
+#include "spatialHash.hpp"
 #include "sprite.hpp"
 #include "value.hpp"
 #include <iostream>
 #include <ostream>
 
+namespace {
+
+// Copies what a Clone inherits from the Sprite it's cloned from. Scripts and assets are shared through `data`.
+// Everything else about the slot (its Pool and layer links, render and collision caches, running scripts) is the Clone's own
+void copyToClone(const Sprite *source, Sprite *clone) {
+    clone->name = source->name;
+    clone->data = source->data;
+    clone->draggable = source->draggable;
+    clone->shouldDoSpriteClick = source->shouldDoSpriteClick;
+
+    // position
+    clone->xPosition = source->xPosition;
+    clone->yPosition = source->yPosition;
+    clone->size = source->size;
+    clone->rotation = source->rotation;
+    clone->rotationStyle = source->rotationStyle;
+
+    // look
+    clone->visible = source->visible;
+    clone->currentCostume = source->currentCostume;
+    clone->rotationCenterX = source->rotationCenterX;
+    clone->rotationCenterY = source->rotationCenterY;
+    clone->spriteWidth = source->spriteWidth;
+    clone->spriteHeight = source->spriteHeight;
+    clone->volume = source->volume;
+    clone->penData = source->penData;
+
+    // effects
+    clone->ghostEffect = source->ghostEffect;
+    clone->brightnessEffect = source->brightnessEffect;
+    clone->colorEffect = source->colorEffect;
+
+    clone->variables = source->variables;
+    clone->lists = source->lists;
+
+    // a reused slot still has the last Clone's caches, so make them update
+    clone->renderInfo = RenderInfo();
+    clone->renderInfo.forceUpdate = true;
+    clone->collisionBox = CollisionBox();
+    clone->threads.clear();
+    clone->customBlockArguments.clear();
+}
+
+} // namespace
+
 BlockResult ControlBlocks::If(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
     Value conditionValue = Scratch::getInputValue(block, "CONDITION", sprite);
     bool condition = conditionValue.asBoolean();
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -4;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -4;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     } else {
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
@@ -26,14 +74,11 @@ BlockResult ControlBlocks::If(Block &block, Sprite *sprite, bool *withoutScreenR
     }
 
     if (condition) {
-        auto it = block.parsedInputs->find("SUBSTACK");
-        if (it != block.parsedInputs->end()) {
-            Block *subBlock = &sprite->blocks[it->second.blockId];
-            if (subBlock) {
-                for (auto &ranBlock : executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat)) {
-                    if (ranBlock->isRepeating) {
-                        return BlockResult::RETURN;
-                    }
+        Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+        if (subBlock) {
+            for (auto &ranBlock : executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat)) {
+                if (BlockExecutor::isRepeating(sprite, *ranBlock)) {
+                    return BlockResult::RETURN;
                 }
             }
         }
@@ -44,30 +89,27 @@ BlockResult ControlBlocks::If(Block &block, Sprite *sprite, bool *withoutScreenR
 }
 
 BlockResult ControlBlocks::ifElse(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
     Value conditionValue = Scratch::getInputValue(block, "CONDITION", sprite);
     bool condition = conditionValue.asBoolean();
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -4;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -4;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     } else {
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
 
-    std::string key = condition ? "SUBSTACK" : "SUBSTACK2";
-    auto it = block.parsedInputs->find(key);
-    if (it != block.parsedInputs->end()) {
-        Block *subBlock = &sprite->blocks[it->second.blockId];
-        if (subBlock) {
-            for (auto &ranBlock : executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat)) {
-                if (ranBlock->isRepeating) {
-                    return BlockResult::RETURN;
-                }
+    Block *subBlock = BlockExecutor::getSubstack(block, sprite, !condition);
+    if (subBlock) {
+        for (auto &ranBlock : executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat)) {
+            if (BlockExecutor::isRepeating(sprite, *ranBlock)) {
+                return BlockResult::RETURN;
             }
         }
     }
@@ -77,24 +119,29 @@ BlockResult ControlBlocks::ifElse(Block &block, Sprite *sprite, bool *withoutScr
 }
 
 BlockResult ControlBlocks::createCloneOf(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    // std::cout << "Trying " << std::endl;
-
     Block *cloneOptions = nullptr;
     auto it = block.parsedInputs->find("CLONE_OPTION");
-    cloneOptions = &sprite->blocks[it->second.literalValue.asString()];
+    if (it == block.parsedInputs->end()) return BlockResult::CONTINUE;
+    auto optionIt = sprite->data->blocks.find(it->second.literalValue.asString());
+    if (optionIt == sprite->data->blocks.end()) return BlockResult::CONTINUE;
+    cloneOptions = &optionIt->second;
 
-    Sprite *spriteToClone = getAvailableSprite();
-    if (!spriteToClone) return BlockResult::CONTINUE;
+    Sprite *sourceSprite = nullptr;
     if (Scratch::getFieldValue(*cloneOptions, "CLONE_OPTION") == "_myself_") {
-        *spriteToClone = *sprite;
+        sourceSprite = sprite;
     } else {
         for (Sprite *currentSprite : sprites) {
             if (currentSprite->name == Math::removeQuotations(Scratch::getFieldValue(*cloneOptions, "CLONE_OPTION")) && !currentSprite->isClone) {
-                *spriteToClone = *currentSprite;
+                sourceSprite = currentSprite;
             }
         }
     }
-    spriteToClone->blockChains.clear();
+    if (!sourceSprite) return BlockResult::CONTINUE;
+
+    Sprite *spriteToClone = getAvailableSprite();
+    if (!spriteToClone) return BlockResult::CONTINUE;
+
+    copyToClone(sourceSprite, spriteToClone);
 
     if (spriteToClone != nullptr && !spriteToClone->name.empty()) {
         spriteToClone->isClone = true;
@@ -104,16 +151,13 @@ BlockResult ControlBlocks::createCloneOf(Block &block, Sprite *sprite, bool *wit
         // Log::log("Cloned " + sprite->name);
         //  add clone to sprite list
         sprites.push_back(spriteToClone);
-        Sprite *addedSprite = sprites.back();
+        Layers::addBehind(spriteToClone, sourceSprite);
+        SpatialHash::markMoved(spriteToClone);
+        BlockExecutor::addHats(spriteToClone);
         // Run "when I start as a clone" scripts for the clone
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite == addedSprite) {
-                for (auto &[id, block] : currentSprite->blocks) {
-                    if (block.opcode == "control_start_as_clone") {
-                        // std::cout << "Running clone block " << block.id << std::endl;
-                        executor.runBlock(block, currentSprite, withoutScreenRefresh, fromRepeat);
-                    }
-                }
+        for (Block *hat : spriteToClone->data->hats) {
+            if (hat->opcodeId == Opcode::CONTROL_START_AS_CLONE) {
+                executor.runBlock(*hat, spriteToClone, withoutScreenRefresh, fromRepeat);
             }
         }
     }
@@ -135,29 +179,16 @@ BlockResult ControlBlocks::stop(Block &block, Sprite *sprite, bool *withoutScree
         return BlockResult::RETURN;
     }
     if (stopType == "this script") {
-        for (std::string repeatID : sprite->blockChains[block.blockChainID].blocksToRepeat) {
-            Block *repeatBlock = &sprite->blocks[repeatID];
-            if (repeatBlock) {
-                repeatBlock->repeatTimes = -1;
-            }
-        }
-
-        sprite->blockChains[block.blockChainID].blocksToRepeat.clear();
+        BlockExecutor::stopThread(sprite, block.scriptIndex);
         return BlockResult::RETURN;
     }
 
     if (stopType == "other scripts in sprite") {
-        for (auto &[id, chain] : sprite->blockChains) {
-            if (id == block.blockChainID) continue;
-            for (std::string repeatID : chain.blocksToRepeat) {
-                Block *repeatBlock = &sprite->blocks[repeatID];
-                if (repeatBlock) {
-                    repeatBlock->repeatTimes = -1;
-                }
-            }
-            chain.blocksToRepeat.clear();
+        for (size_t i = 0; i < sprite->threads.size(); i++) {
+            if (static_cast<int32_t>(i) == block.scriptIndex) continue;
+            BlockExecutor::stopThread(sprite, static_cast<int32_t>(i));
         }
-        for (auto &[id, sound] : sprite->sounds) {
+        for (auto &[id, sound] : sprite->data->sounds) {
             SoundPlayer::stopSound(sound.fullName);
         }
         return BlockResult::CONTINUE;
@@ -170,28 +201,29 @@ BlockResult ControlBlocks::startAsClone(Block &block, Sprite *sprite, bool *with
 }
 
 BlockResult ControlBlocks::wait(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -2;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -2;
 
         Value duration = Scratch::getInputValue(block, "DURATION", sprite);
         if (duration.isNumeric()) {
-            block.waitDuration = duration.asDouble() * 1000; // convert to milliseconds
+            state.waitDuration = duration.asDouble() * 1000; // convert to milliseconds
         } else {
-            block.waitDuration = 0;
+            state.waitDuration = 0;
         }
 
-        block.waitTimer.start();
+        state.waitTimer.start();
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
-    block.repeatTimes -= 1;
+    state.repeatTimes -= 1;
 
-    if (block.waitTimer.hasElapsed(block.waitDuration) && block.repeatTimes <= -4) {
-        block.repeatTimes = -1;
+    if (state.waitTimer.hasElapsed(state.waitDuration) && state.repeatTimes <= -4) {
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         Scratch::forceRedraw = true;
         return BlockResult::CONTINUE;
@@ -201,13 +233,14 @@ BlockResult ControlBlocks::wait(Block &block, Sprite *sprite, bool *withoutScree
 }
 
 BlockResult ControlBlocks::waitUntil(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -4;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -4;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
@@ -216,7 +249,7 @@ BlockResult ControlBlocks::waitUntil(Block &block, Sprite *sprite, bool *without
     bool conditionMet = conditionValue.asBoolean();
 
     if (conditionMet) {
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
@@ -225,30 +258,28 @@ BlockResult ControlBlocks::waitUntil(Block &block, Sprite *sprite, bool *without
 }
 
 BlockResult ControlBlocks::repeat(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = Scratch::getInputValue(block, "TIMES", sprite).asInt();
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = Scratch::getInputValue(block, "TIMES", sprite).asInt();
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
-    if (block.repeatTimes > 0) {
-        auto it = block.parsedInputs->find("SUBSTACK");
-        if (it != block.parsedInputs->end()) {
-            Block *subBlock = &sprite->blocks[it->second.blockId];
-            if (subBlock) {
-                executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
-            }
+    if (state.repeatTimes > 0) {
+        Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+        if (subBlock) {
+            executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
         }
 
         // Countdown
-        block.repeatTimes -= 1;
+        state.repeatTimes -= 1;
         return BlockResult::RETURN;
     } else {
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
     }
     // std::cout << "done with repeat " << block.id << std::endl;
     BlockExecutor::removeFromRepeatQueue(sprite, &block);
@@ -256,12 +287,13 @@ BlockResult ControlBlocks::repeat(Block &block, Sprite *sprite, bool *withoutScr
 }
 
 BlockResult ControlBlocks::While(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -2;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -2;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
@@ -269,34 +301,28 @@ BlockResult ControlBlocks::While(Block &block, Sprite *sprite, bool *withoutScre
     bool condition = conditionValue.asBoolean();
 
     if (!condition) {
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
 
-    auto it = block.parsedInputs->find("SUBSTACK");
-    if (it != block.parsedInputs->end()) {
-        const std::string &blockId = it->second.blockId;
-        auto blockIt = sprite->blocks.find(blockId);
-        if (blockIt != sprite->blocks.end()) {
-            Block *subBlock = &blockIt->second;
-            executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
-        } else {
-            std::cerr << "Invalid blockId: " << blockId << std::endl;
-        }
+    Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+    if (subBlock) {
+        executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
     }
 
     return BlockResult::RETURN;
 }
 
 BlockResult ControlBlocks::repeatUntil(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -2;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -2;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
@@ -304,22 +330,15 @@ BlockResult ControlBlocks::repeatUntil(Block &block, Sprite *sprite, bool *witho
     bool condition = conditionValue.asBoolean();
     
     if (condition) {
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
 
         return BlockResult::CONTINUE;
     }
 
-    auto it = block.parsedInputs->find("SUBSTACK");
-    if (it != block.parsedInputs->end()) {
-        const std::string &blockId = it->second.blockId;
-        auto blockIt = sprite->blocks.find(blockId);
-        if (blockIt != sprite->blocks.end()) {
-            Block *subBlock = &blockIt->second;
-            executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
-        } else {
-            std::cerr << "Invalid blockId: " << blockId << std::endl;
-        }
+    Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+    if (subBlock) {
+        executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
     }
 
     // Continue the loop
@@ -327,22 +346,20 @@ BlockResult ControlBlocks::repeatUntil(Block &block, Sprite *sprite, bool *witho
 }
 
 BlockResult ControlBlocks::forever(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -3;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -3;
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
-    auto it = block.parsedInputs->find("SUBSTACK");
-    if (it != block.parsedInputs->end()) {
-        Block *subBlock = &sprite->blocks[it->second.blockId];
-        if (subBlock) {
-            executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
-        }
+    Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+    if (subBlock) {
+        executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
     }
     return BlockResult::RETURN;
 }
@@ -362,26 +379,24 @@ BlockResult ControlBlocks::clearCounter(Block &block, Sprite *sprite, bool *with
 }
 
 BlockResult ControlBlocks::forEach(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    if (block.repeatTimes != -1 && !fromRepeat) block.repeatTimes = -1;
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
+    if (state.repeatTimes != -1 && !fromRepeat) state.repeatTimes = -1;
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = Scratch::getInputValue(block, "VALUE", sprite).asInt();
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = Scratch::getInputValue(block, "VALUE", sprite).asInt();
         BlockExecutor::addToRepeatQueue(sprite, &block);
     }
 
-    if (block.repeatTimes > 0) {
-        BlockExecutor::setVariableValue(Scratch::getFieldId(block, "VARIABLE"), Value(Scratch::getInputValue(block, "VALUE", sprite).asInt() - block.repeatTimes + 1), sprite);
+    if (state.repeatTimes > 0) {
+        BlockExecutor::setVariableValue(block.variable, Value(Scratch::getInputValue(block, "VALUE", sprite).asInt() - state.repeatTimes + 1), sprite);
 
-        auto it = block.parsedInputs->find("SUBSTACK");
-        if (it != block.parsedInputs->end()) {
-            Block *subBlock = &sprite->blocks[it->second.blockId];
-            if (subBlock) executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
-        }
+        Block *subBlock = BlockExecutor::getSubstack(block, sprite);
+        if (subBlock) executor.runBlock(*subBlock, sprite, withoutScreenRefresh, fromRepeat);
 
-        block.repeatTimes -= 1;
+        state.repeatTimes -= 1;
         return BlockResult::RETURN;
     }
-    block.repeatTimes = -1;
+    state.repeatTimes = -1;
 
     BlockExecutor::removeFromRepeatQueue(sprite, &block);
     return BlockResult::CONTINUE;
@@ -10,18 +10,17 @@ const unsigned int MAX_LIST_ITEMS = 200000;
 
 BlockResult DataBlocks::setVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "VALUE", sprite);
-    std::string varId = Scratch::getFieldId(block, "VARIABLE");
 
-    BlockExecutor::setVariableValue(varId, val, sprite);
+    BlockExecutor::setVariableValue(block.variable, val, sprite);
     return BlockResult::CONTINUE;
 }
 
 BlockResult DataBlocks::changeVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "VALUE", sprite);
-    std::string varId = Scratch::getFieldId(block, "VARIABLE");
-    Value oldVariable = BlockExecutor::getVariableValue(varId, sprite);
+    Variable *variable = BlockExecutor::getVariable(block.variable, sprite);
+    if (!variable) return BlockResult::CONTINUE;
 
-    BlockExecutor::setVariableValue(varId, Value(val + oldVariable), sprite);
+    BlockExecutor::setVariableValue(block.variable, Value(val + variable->value), sprite);
     return BlockResult::CONTINUE;
 }
 
@@ -75,50 +74,23 @@ BlockResult DataBlocks::hideList(Block &block, Sprite *sprite, bool *withoutScre
 
 BlockResult DataBlocks::addToList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = Scratch::getFieldId(block, "LIST");
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    val.isNumeric(); // caches the number in the item, so it isn't parsed every time the item is read
 
-    if (targetSprite && targetSprite->lists[listId].items.size() < MAX_LIST_ITEMS) targetSprite->lists[listId].items.push_back(val);
+    List *list = BlockExecutor::getList(block.variable, sprite);
+
+    if (list && list->items.size() < MAX_LIST_ITEMS) list->items.push_back(val);
 
     return BlockResult::CONTINUE;
 }
 
 BlockResult DataBlocks::deleteFromList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "INDEX", sprite);
-    std::string listId = Scratch::getFieldId(block, "LIST");
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
 
-    if (!targetSprite) return BlockResult::CONTINUE;
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    auto &items = targetSprite->lists[listId].items;
+    if (!list) return BlockResult::CONTINUE;
+
+    auto &items = list->items;
 
     if (val.isNumeric()) {
         int index = val.asInt() - 1; // Convert to 0-based index
@@ -148,25 +120,10 @@ BlockResult DataBlocks::deleteFromList(Block &block, Sprite *sprite, bool *witho
 }
 
 BlockResult DataBlocks::deleteAllOfList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string listId = Scratch::getFieldId(block, "LIST");
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (targetSprite) {
-        targetSprite->lists[listId].items.clear(); // Clear the list
+    if (list) {
+        list->items.clear(); // Clear the list
     }
 
     return BlockResult::CONTINUE;
@@ -174,29 +131,16 @@ BlockResult DataBlocks::deleteAllOfList(Block &block, Sprite *sprite, bool *with
 
 BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = Scratch::getFieldId(block, "LIST");
+    val.isNumeric();
     Value index = Scratch::getInputValue(block, "INDEX", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (!targetSprite || targetSprite->lists[listId].items.size() >= MAX_LIST_ITEMS) return BlockResult::CONTINUE;
+    if (!list || list->items.size() >= MAX_LIST_ITEMS) return BlockResult::CONTINUE;
 
     if (index.isNumeric()) {
         int idx = index.asInt() - 1; // Convert to 0-based index
-        auto &items = targetSprite->lists[listId].items;
+        auto &items = list->items;
 
         // Check if the index is within bounds
         if (idx >= 0 && idx <= static_cast<int>(items.size())) {
@@ -206,15 +150,15 @@ BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *without
         return BlockResult::CONTINUE;
     }
 
-    if (targetSprite->lists[listId].items.empty()) return BlockResult::CONTINUE;
+    if (list->items.empty()) return BlockResult::CONTINUE;
 
     if (index.asString() == "last") {
-        targetSprite->lists[listId].items.push_back(val);
+        list->items.push_back(val);
         return BlockResult::CONTINUE;
     }
 
     if (index.asString() == "random") {
-        auto &items = targetSprite->lists[listId].items;
+        auto &items = list->items;
         int idx = rand() % (items.size() + 1);
         items.insert(items.begin() + idx, val);
     }
@@ -224,26 +168,14 @@ BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *without
 
 BlockResult DataBlocks::replaceItemOfList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = Scratch::getFieldId(block, "LIST");
+    val.isNumeric();
     Value index = Scratch::getInputValue(block, "INDEX", sprite);
 
-    Sprite *targetSprite = nullptr;
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    if (!list) return BlockResult::CONTINUE;
 
-    // If we found the target sprite with the list, attempt the replacement
-    if (!targetSprite) return BlockResult::CONTINUE;
-
-    auto &items = targetSprite->lists[listId].items;
+    auto &items = list->items;
 
     if (index.isNumeric()) {
         int idx = index.asInt() - 1;
@@ -268,26 +200,12 @@ BlockResult DataBlocks::replaceItemOfList(Block &block, Sprite *sprite, bool *wi
 Value DataBlocks::itemOfList(Block &block, Sprite *sprite) {
     Value indexStr = Scratch::getInputValue(block, "INDEX", sprite);
     int index = indexStr.asInt() - 1;
-    std::string listName = Scratch::getFieldId(block, "LIST");
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
 
-    if (!targetSprite) return Value();
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    auto &items = targetSprite->lists[listName].items;
+    if (!list) return Value();
+
+    auto &items = list->items;
 
     if (items.empty()) return Value();
 
@@ -306,28 +224,13 @@ Value DataBlocks::itemOfList(Block &block, Sprite *sprite) {
 }
 
 Value DataBlocks::itemNumOfList(Block &block, Sprite *sprite) {
-    std::string listName = Scratch::getFieldId(block, "LIST");
     Value itemToFind = Scratch::getInputValue(block, "ITEM", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (targetSprite) {
-        auto &list = targetSprite->lists[listName];
+    if (list) {
         int index = 1;
-        for (auto &item : list.items) {
+        for (auto &item : list->items) {
             if (item == itemToFind) {
                 return Value(index);
             }
@@ -339,52 +242,22 @@ Value DataBlocks::itemNumOfList(Block &block, Sprite *sprite) {
 }
 
 Value DataBlocks::lengthOfList(Block &block, Sprite *sprite) {
-    std::string listName = Scratch::getFieldId(block, "LIST");
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (targetSprite) {
-        return Value(static_cast<int>(targetSprite->lists[listName].items.size()));
+    if (list) {
+        return Value(static_cast<int>(list->items.size()));
     }
 
     return Value();
 }
 
 Value DataBlocks::listContainsItem(Block &block, Sprite *sprite) {
-    std::string listName = Scratch::getFieldId(block, "LIST");
     Value itemToFind = Scratch::getInputValue(block, "ITEM", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getList(block.variable, sprite);
 
-    if (targetSprite) {
-        auto &list = targetSprite->lists[listName];
-        for (const auto &item : list.items) {
+    if (list) {
+        for (const auto &item : list->items) {
             if (item == itemToFind) {
                 return Value(true);
             }
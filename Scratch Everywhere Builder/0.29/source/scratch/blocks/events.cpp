@@ -1,6 +1,5 @@
 #include "events.hpp"
 #include "blockExecutor.hpp"
-#include "input.hpp"
 #include "interpret.hpp"
 #include "sprite.hpp"
 
@@ -18,21 +17,22 @@ BlockResult EventBlocks::broadcast(Block &block, Sprite *sprite, bool *withoutSc
 }
 
 BlockResult EventBlocks::broadcastAndWait(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -10;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -10;
         BlockExecutor::addToRepeatQueue(sprite, &block);
-        block.broadcastsRun = BlockExecutor::runBroadcast(Scratch::getInputValue(block, "BROADCAST_INPUT", sprite).asString());
+        state.broadcastsRun = BlockExecutor::runBroadcast(Scratch::getInputValue(block, "BROADCAST_INPUT", sprite).asString());
     }
 
     bool shouldEnd = true;
-    for (auto &[blockPtr, spritePtr] : block.broadcastsRun) {
+    for (auto &[blockPtr, spritePtr] : state.broadcastsRun) {
         if (spritePtr->toDelete) continue;
-        if (!spritePtr->blockChains[blockPtr->blockChainID].blocksToRepeat.empty()) {
+        if (BlockExecutor::hasActiveRepeats(spritePtr, blockPtr->scriptIndex)) {
             shouldEnd = false;
             break;
         }
@@ -40,16 +40,12 @@ BlockResult EventBlocks::broadcastAndWait(Block &block, Sprite *sprite, bool *wi
 
     if (!shouldEnd) return BlockResult::RETURN;
 
-    block.repeatTimes = -1;
+    state.repeatTimes = -1;
     BlockExecutor::removeFromRepeatQueue(sprite, &block);
     return BlockResult::CONTINUE;
 }
 
 BlockResult EventBlocks::whenKeyPressed(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    for (std::string button : Input::inputButtons) {
-        if (Scratch::getFieldValue(block, "KEY_OPTION") == button) {
-            return BlockResult::CONTINUE;
-        }
-    }
-    return BlockResult::RETURN;
+    // only started for the pressed keys, by `BlockExecutor::runKeyHats()`
+    return BlockResult::CONTINUE;
 }
@@ -2,19 +2,21 @@
 #include "blockExecutor.hpp"
 #include "image.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "sprite.hpp"
 #include "unzip.hpp"
 #include "value.hpp"
 #include <algorithm>
 #include <cstddef>
+#include <limits>
 
 BlockResult LooksBlocks::show(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     sprite->visible = true;
     if (projectType == UNZIPPED) {
-        Image::loadImageFromFile(sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromFile(sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     } else {
-        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     }
     Scratch::forceRedraw = true;
     return BlockResult::CONTINUE;
@@ -39,8 +41,8 @@ BlockResult LooksBlocks::switchCostumeTo(Block &block, Sprite *sprite, bool *wit
     }
 
     bool imageFound = false;
-    for (size_t i = 0; i < sprite->costumes.size(); i++) {
-        if (sprite->costumes[i].name == inputString) {
+    for (size_t i = 0; i < sprite->data->costumes.size(); i++) {
+        if (sprite->data->costumes[i].name == inputString) {
             sprite->currentCostume = i;
             imageFound = true;
             break;
@@ -48,31 +50,31 @@ BlockResult LooksBlocks::switchCostumeTo(Block &block, Sprite *sprite, bool *wit
     }
     if (((Math::isNumber(inputString) && inputFind != block.parsedInputs->end() && !imageFound) || inputValue.isNumeric()) && (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE)) {
         int costumeIndex = inputValue.asInt() - 1;
-        if (costumeIndex >= 0 && static_cast<size_t>(costumeIndex) < sprite->costumes.size()) {
+        if (costumeIndex >= 0 && static_cast<size_t>(costumeIndex) < sprite->data->costumes.size()) {
             sprite->currentCostume = costumeIndex;
             imageFound = true;
         }
     }
 
     if (projectType == UNZIPPED) {
-        Image::loadImageFromFile(sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromFile(sprite->data->costumes[sprite->currentCostume].fullName, sprite);
         return BlockResult::CONTINUE;
     }
 
-    Image::loadImageFromSB3(&Unzip::zipArchive, sprite->costumes[sprite->currentCostume].fullName, sprite);
+    Image::loadImageFromSB3(&Unzip::zipArchive, sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     Scratch::forceRedraw = true;
     return BlockResult::CONTINUE;
 }
 
 BlockResult LooksBlocks::nextCostume(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     sprite->currentCostume++;
-    if (sprite->currentCostume >= static_cast<int>(sprite->costumes.size())) {
+    if (sprite->currentCostume >= static_cast<int>(sprite->data->costumes.size())) {
         sprite->currentCostume = 0;
     }
     if (projectType == UNZIPPED) {
-        Image::loadImageFromFile(sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromFile(sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     } else {
-        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     }
     Scratch::forceRedraw = true;
     return BlockResult::CONTINUE;
@@ -98,8 +100,8 @@ BlockResult LooksBlocks::switchBackdropTo(Block &block, Sprite *sprite, bool *wi
         }
 
         bool imageFound = false;
-        for (size_t i = 0; i < currentSprite->costumes.size(); i++) {
-            if (currentSprite->costumes[i].name == inputString) {
+        for (size_t i = 0; i < currentSprite->data->costumes.size(); i++) {
+            if (currentSprite->data->costumes[i].name == inputString) {
                 currentSprite->currentCostume = i;
                 imageFound = true;
                 break;
@@ -107,29 +109,23 @@ BlockResult LooksBlocks::switchBackdropTo(Block &block, Sprite *sprite, bool *wi
         }
         if (((Math::isNumber(inputString) && inputFind != block.parsedInputs->end() && !imageFound) || inputValue.isNumeric()) && (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE)) {
             int costumeIndex = inputValue.asInt() - 1;
-            if (costumeIndex >= 0 && static_cast<size_t>(costumeIndex) < currentSprite->costumes.size()) {
+            if (costumeIndex >= 0 && static_cast<size_t>(costumeIndex) < currentSprite->data->costumes.size()) {
                 imageFound = true;
                 currentSprite->currentCostume = costumeIndex;
             }
         }
 
         if (projectType == UNZIPPED) {
-            Image::loadImageFromFile(currentSprite->costumes[currentSprite->currentCostume].fullName, sprite);
+            Image::loadImageFromFile(currentSprite->data->costumes[currentSprite->currentCostume].fullName, sprite);
         } else {
-            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->costumes[currentSprite->currentCostume].fullName, sprite);
+            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->data->costumes[currentSprite->currentCostume].fullName, sprite);
         }
     }
 
-    for (auto &currentSprite : sprites) {
-        for (auto &[id, spriteBlock] : currentSprite->blocks) {
-            if (spriteBlock.opcode != "event_whenbackdropswitchesto") continue;
-            try {
-                if (Scratch::getFieldValue(spriteBlock, "BACKDROP") == sprite->costumes[sprite->currentCostume].name) {
-                    executor.runBlock(spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
-                }
-            } catch (...) {
-                continue;
-            }
+    if (sprite->currentCostume >= 0 && sprite->currentCostume < static_cast<int>(sprite->data->costumes.size())) {
+        std::vector<std::pair<Block *, Sprite *>> blocksToRun = BlockExecutor::getHats(Opcode::EVENT_WHENBACKDROPSWITCHESTO, sprite->data->costumes[sprite->currentCostume].name);
+        for (auto &[spriteBlock, currentSprite] : blocksToRun) {
+            executor.runBlock(*spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
         }
     }
 
@@ -143,26 +139,20 @@ BlockResult LooksBlocks::nextBackdrop(Block &block, Sprite *sprite, bool *withou
             continue;
         }
         currentSprite->currentCostume++;
-        if (currentSprite->currentCostume >= static_cast<int>(currentSprite->costumes.size())) {
+        if (currentSprite->currentCostume >= static_cast<int>(currentSprite->data->costumes.size())) {
             currentSprite->currentCostume = 0;
         }
         if (projectType == UNZIPPED) {
-            Image::loadImageFromFile(currentSprite->costumes[currentSprite->currentCostume].fullName, sprite);
+            Image::loadImageFromFile(currentSprite->data->costumes[currentSprite->currentCostume].fullName, sprite);
         } else {
-            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->costumes[currentSprite->currentCostume].fullName, sprite);
+            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->data->costumes[currentSprite->currentCostume].fullName, sprite);
         }
     }
 
-    for (auto &currentSprite : sprites) {
-        for (auto &[id, spriteBlock] : currentSprite->blocks) {
-            if (spriteBlock.opcode != "event_whenbackdropswitchesto") continue;
-            try {
-                if (Scratch::getFieldValue(spriteBlock, "BACKDROP") == sprite->costumes[sprite->currentCostume].name) {
-                    executor.runBlock(spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
-                }
-            } catch (...) {
-                continue;
-            }
+    if (sprite->currentCostume >= 0 && sprite->currentCostume < static_cast<int>(sprite->data->costumes.size())) {
+        std::vector<std::pair<Block *, Sprite *>> blocksToRun = BlockExecutor::getHats(Opcode::EVENT_WHENBACKDROPSWITCHESTO, sprite->data->costumes[sprite->currentCostume].name);
+        for (auto &[spriteBlock, currentSprite] : blocksToRun) {
+            executor.runBlock(*spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
         }
     }
 
@@ -175,66 +165,28 @@ BlockResult LooksBlocks::goForwardBackwardLayers(Block &block, Sprite *sprite, b
     std::string forwardBackward = Scratch::getFieldValue(block, "FORWARD_BACKWARD");
     if (!value.isNumeric()) return BlockResult::CONTINUE;
 
-    int shift = value.asInt();
+    // the lowest int can't be negated, and going back one layer less still goes past every Sprite
+    const int shift = std::max(value.asInt(), -std::numeric_limits<int>::max());
     if (shift == 0) return BlockResult::CONTINUE;
 
     if (forwardBackward == "forward") {
-        int targetLayer = sprite->layer + shift;
-
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage || currentSprite == sprite) continue;
-            if (currentSprite->layer >= targetLayer) {
-                currentSprite->layer++;
-            }
-        }
-
-        sprite->layer = targetLayer;
-
+        Layers::goForward(sprite, shift);
     } else if (forwardBackward == "backward") {
-        int targetLayer = sprite->layer - shift;
-
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage || currentSprite == sprite) continue;
-            if (currentSprite->layer <= targetLayer) {
-                currentSprite->layer--;
-                if (currentSprite->layer < 0) currentSprite->layer = 0;
-            }
-        }
-
-        sprite->layer = targetLayer;
+        Layers::goForward(sprite, -shift);
     }
 
     Scratch::forceRedraw = true;
-    Scratch::sortSprites();
     return BlockResult::CONTINUE;
 }
 
 BlockResult LooksBlocks::goToFrontBack(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     std::string value = Scratch::getFieldValue(block, "FRONT_BACK");
     if (value == "front") {
-
-        double maxLayer = 0.0;
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->layer > maxLayer) {
-                maxLayer = currentSprite->layer;
-            }
-        }
-
-        sprite->layer = maxLayer + 1;
-
+        Layers::goToFront(sprite);
     } else if (value == "back") {
-        double minLayer = std::numeric_limits<double>::max();
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage) continue;
-            if (currentSprite->layer < minLayer) {
-                minLayer = currentSprite->layer;
-            }
-        }
-
-        sprite->layer = minLayer - 1;
+        Layers::goToBack(sprite);
     }
     Scratch::forceRedraw = true;
-    Scratch::sortSprites();
     return BlockResult::CONTINUE;
 }
 
@@ -365,7 +317,7 @@ Value LooksBlocks::costumeNumberName(Block &block, Sprite *sprite) {
     std::string value = Scratch::getFieldValue(block, "NUMBER_NAME");
     ;
     if (value == "name") {
-        return Value(sprite->costumes[sprite->currentCostume].name);
+        return Value(sprite->data->costumes[sprite->currentCostume].name);
     } else if (value == "number") {
         return Value(sprite->currentCostume + 1);
     }
@@ -378,7 +330,7 @@ Value LooksBlocks::backdropNumberName(Block &block, Sprite *sprite) {
     if (value == "name") {
         for (Sprite *currentSprite : sprites) {
             if (currentSprite->isStage) {
-                return Value(currentSprite->costumes[currentSprite->currentCostume].name);
+                return Value(currentSprite->data->costumes[currentSprite->currentCostume].name);
             }
         }
     } else if (value == "number") {
@@ -174,54 +174,55 @@ BlockResult MotionBlocks::setY(Block &block, Sprite *sprite, bool *withoutScreen
 }
 
 BlockResult MotionBlocks::glideSecsToXY(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -6;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -6;
 
         Value duration = Scratch::getInputValue(block, "SECS", sprite);
         if (duration.isNumeric()) {
-            block.waitDuration = duration.asDouble() * 1000; // milliseconds
+            state.waitDuration = duration.asDouble() * 1000; // milliseconds
         } else {
-            block.waitDuration = 0;
+            state.waitDuration = 0;
         }
 
-        block.waitTimer.start();
-        block.glideStartX = sprite->xPosition;
-        block.glideStartY = sprite->yPosition;
+        state.waitTimer.start();
+        state.glideStartX = sprite->xPosition;
+        state.glideStartY = sprite->yPosition;
 
         // Get target positions
         Value positionXStr = Scratch::getInputValue(block, "X", sprite);
         Value positionYStr = Scratch::getInputValue(block, "Y", sprite);
-        block.glideEndX = positionXStr.isNumeric() ? positionXStr.asDouble() : block.glideStartX;
-        block.glideEndY = positionYStr.isNumeric() ? positionYStr.asDouble() : block.glideStartY;
+        state.glideEndX = positionXStr.isNumeric() ? positionXStr.asDouble() : state.glideStartX;
+        state.glideEndY = positionYStr.isNumeric() ? positionYStr.asDouble() : state.glideStartY;
 
         BlockExecutor::addToRepeatQueue(sprite, const_cast<Block *>(&block));
     }
 
-    int elapsedTime = block.waitTimer.getTimeMs();
+    int elapsedTime = state.waitTimer.getTimeMs();
 
-    if (elapsedTime >= block.waitDuration) {
-        sprite->xPosition = block.glideEndX;
-        sprite->yPosition = block.glideEndY;
+    if (elapsedTime >= state.waitDuration) {
+        sprite->xPosition = state.glideEndX;
+        sprite->yPosition = state.glideEndY;
         if (Scratch::fencing) Scratch::fenceSpriteWithinBounds(sprite);
         Scratch::forceRedraw = true;
 
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
 
-    double progress = static_cast<double>(elapsedTime) / block.waitDuration;
+    double progress = static_cast<double>(elapsedTime) / state.waitDuration;
     if (progress > 1.0) progress = 1.0;
 
     const double oldX = sprite->xPosition;
     const double oldY = sprite->yPosition;
 
-    sprite->xPosition = block.glideStartX + (block.glideEndX - block.glideStartX) * progress;
-    sprite->yPosition = block.glideStartY + (block.glideEndY - block.glideStartY) * progress;
+    sprite->xPosition = state.glideStartX + (state.glideEndX - state.glideStartX) * progress;
+    sprite->yPosition = state.glideStartY + (state.glideEndY - state.glideStartY) * progress;
     if (Scratch::fencing) Scratch::fenceSpriteWithinBounds(sprite);
 
     if (sprite->penData.down && (oldX != sprite->xPosition || oldY != sprite->yPosition)) Render::penMove(oldX, oldY, sprite->xPosition, sprite->yPosition, sprite);
@@ -231,24 +232,25 @@ BlockResult MotionBlocks::glideSecsToXY(Block &block, Sprite *sprite, bool *with
 }
 
 BlockResult MotionBlocks::glideTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -7;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -7;
 
         Value duration = Scratch::getInputValue(block, "SECS", sprite);
         if (duration.isNumeric()) {
-            block.waitDuration = duration.asDouble() * 1000; // Convert to milliseconds
+            state.waitDuration = duration.asDouble() * 1000; // Convert to milliseconds
         } else {
-            block.waitDuration = 0;
+            state.waitDuration = 0;
         }
 
-        block.waitTimer.start();
-        block.glideStartX = sprite->xPosition;
-        block.glideStartY = sprite->yPosition;
+        state.waitTimer.start();
+        state.glideStartX = sprite->xPosition;
+        state.glideStartY = sprite->yPosition;
 
         Block *inputBlock;
         auto itVal = block.parsedInputs->find("TO");
@@ -275,33 +277,33 @@ BlockResult MotionBlocks::glideTo(Block &block, Sprite *sprite, bool *withoutScr
             }
         }
 
-        block.glideEndX = Math::isNumber(positionXStr) ? std::stod(positionXStr) : block.glideStartX;
-        block.glideEndY = Math::isNumber(positionYStr) ? std::stod(positionYStr) : block.glideStartY;
+        state.glideEndX = Math::isNumber(positionXStr) ? std::stod(positionXStr) : state.glideStartX;
+        state.glideEndY = Math::isNumber(positionYStr) ? std::stod(positionYStr) : state.glideStartY;
 
         BlockExecutor::addToRepeatQueue(sprite, const_cast<Block *>(&block));
     }
 
-    int elapsedTime = block.waitTimer.getTimeMs();
+    int elapsedTime = state.waitTimer.getTimeMs();
 
-    if (elapsedTime >= block.waitDuration) {
-        sprite->xPosition = block.glideEndX;
-        sprite->yPosition = block.glideEndY;
+    if (elapsedTime >= state.waitDuration) {
+        sprite->xPosition = state.glideEndX;
+        sprite->yPosition = state.glideEndY;
         if (Scratch::fencing) Scratch::fenceSpriteWithinBounds(sprite);
         Scratch::forceRedraw = true;
 
-        block.repeatTimes = -1;
+        state.repeatTimes = -1;
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
 
-    double progress = static_cast<double>(elapsedTime) / block.waitDuration;
+    double progress = static_cast<double>(elapsedTime) / state.waitDuration;
     if (progress > 1.0) progress = 1.0;
 
     const double oldX = sprite->xPosition;
     const double oldY = sprite->yPosition;
 
-    sprite->xPosition = block.glideStartX + (block.glideEndX - block.glideStartX) * progress;
-    sprite->yPosition = block.glideStartY + (block.glideEndY - block.glideStartY) * progress;
+    sprite->xPosition = state.glideStartX + (state.glideEndX - state.glideStartX) * progress;
+    sprite->yPosition = state.glideStartY + (state.glideEndY - state.glideStartY) * progress;
     if (Scratch::fencing) Scratch::fenceSpriteWithinBounds(sprite);
 
     if (sprite->penData.down && (oldX != sprite->xPosition || oldY != sprite->yPosition)) Render::penMove(oldX, oldY, sprite->xPosition, sprite->yPosition, sprite);
@@ -55,16 +55,18 @@ Value OperatorBlocks::random(Block &block, Sprite *sprite) {
 Value OperatorBlocks::join(Block &block, Sprite *sprite) {
     Value value1 = Scratch::getInputValue(block, "STRING1", sprite);
     Value value2 = Scratch::getInputValue(block, "STRING2", sprite);
-    return Value(value1.asString() + value2.asString());
+    return Value::concat(value1, value2);
 }
 
 Value OperatorBlocks::letterOf(Block &block, Sprite *sprite) {
     Value value1 = Scratch::getInputValue(block, "LETTER", sprite);
     Value value2 = Scratch::getInputValue(block, "STRING", sprite);
-    if (value1.isNumeric() && value2.asString() != "") {
+    std::string buffer;
+    const std::string_view string = value2.isString() ? value2.stringView() : std::string_view(buffer = value2.asString());
+    if (value1.isNumeric() && !string.empty()) {
         int index = value1.asInt() - 1;
-        if (index >= 0 && index < static_cast<int>(value2.asString().size())) {
-            return Value(std::string(1, value2.asString()[index]));
+        if (index >= 0 && index < static_cast<int>(string.size())) {
+            return Value(string.substr(index, 1));
         }
     }
     return Value();
@@ -72,6 +74,7 @@ Value OperatorBlocks::letterOf(Block &block, Sprite *sprite) {
 
 Value OperatorBlocks::length(Block &block, Sprite *sprite) {
     Value value1 = Scratch::getInputValue(block, "STRING", sprite);
+    if (value1.isString()) return Value(static_cast<int>(value1.stringView().size()));
     return Value(static_cast<int>(value1.asString().size()));
 }
 
@@ -197,12 +197,12 @@ BlockResult PenBlocks::Stamp(Block &block, Sprite *sprite, bool *withoutScreenRe
     if (!sprite->visible || !Render::initPen()) return BlockResult::CONTINUE;
 
     if (projectType == UNZIPPED) {
-        Image::loadImageFromFile(sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromFile(sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     } else {
-        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     }
 
-    const auto &imgFind = images.find(sprite->costumes[sprite->currentCostume].id);
+    const auto &imgFind = images.find(sprite->data->costumes[sprite->currentCostume].id);
     if (imgFind == images.end()) {
         Log::logWarning("Invalid Image for Stamp");
         return BlockResult::CONTINUE;
@@ -212,8 +212,8 @@ BlockResult PenBlocks::Stamp(Block &block, Sprite *sprite, bool *withoutScreenRe
     SDL_SetRenderTarget(renderer, penTexture);
 
     // IDK if these are needed
-    sprite->rotationCenterX = sprite->costumes[sprite->currentCostume].rotationCenterX;
-    sprite->rotationCenterY = sprite->costumes[sprite->currentCostume].rotationCenterY;
+    sprite->rotationCenterX = sprite->data->costumes[sprite->currentCostume].rotationCenterX;
+    sprite->rotationCenterY = sprite->data->costumes[sprite->currentCostume].rotationCenterY;
 
     // TODO: remove duplicate code (maybe make a Render::drawSprite function.)
     SDL_Image *image = imgFind->second;
@@ -222,7 +222,7 @@ BlockResult PenBlocks::Stamp(Block &block, Sprite *sprite, bool *withoutScreenRe
 
     sprite->spriteWidth = image->textureRect.w / 2;
     sprite->spriteHeight = image->textureRect.h / 2;
-    if (sprite->costumes[sprite->currentCostume].isSVG) {
+    if (sprite->data->costumes[sprite->currentCostume].isSVG) {
         sprite->spriteWidth *= 2;
         sprite->spriteHeight *= 2;
     }
@@ -276,12 +276,12 @@ BlockResult PenBlocks::Stamp(Block &block, Sprite *sprite, bool *withoutScreenRe
     if (!Render::initPen()) return BlockResult::CONTINUE;
 
     if (projectType == UNZIPPED) {
-        Image::loadImageFromFile(sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromFile(sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     } else {
-        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->costumes[sprite->currentCostume].fullName, sprite);
+        Image::loadImageFromSB3(&Unzip::zipArchive, sprite->data->costumes[sprite->currentCostume].fullName, sprite);
     }
 
-    const auto &imgFind = images.find(sprite->costumes[sprite->currentCostume].id);
+    const auto &imgFind = images.find(sprite->data->costumes[sprite->currentCostume].id);
     if (imgFind == images.end()) {
         Log::logWarning("Invalid Image for Stamp");
         return BlockResult::CONTINUE;
@@ -297,8 +297,8 @@ BlockResult PenBlocks::Stamp(Block &block, Sprite *sprite, bool *withoutScreenRe
     C3D_DepthTest(false, GPU_ALWAYS, GPU_WRITE_COLOR);
 
     const bool isSVG = data.isSVG;
-    sprite->rotationCenterX = sprite->costumes[sprite->currentCostume].rotationCenterX;
-    sprite->rotationCenterY = sprite->costumes[sprite->currentCostume].rotationCenterY;
+    sprite->rotationCenterX = sprite->data->costumes[sprite->currentCostume].rotationCenterX;
+    sprite->rotationCenterY = sprite->data->costumes[sprite->currentCostume].rotationCenterY;
     sprite->spriteWidth = data.width >> 1;
     sprite->spriteHeight = data.height >> 1;
     Render::calculateRenderPosition(sprite, isSVG);
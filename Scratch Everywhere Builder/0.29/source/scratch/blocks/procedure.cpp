@@ -44,38 +44,44 @@ Value ProcedureBlocks::booleanArgument(Block &block, Sprite *sprite) {
 }
 
 BlockResult ProcedureBlocks::call(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -8;
-        block.customBlockExecuted = false;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -8;
+        state.customBlockExecuted = false;
 
         // Run the custom block for the first time
         if (BlockExecutor::runCustomBlock(sprite, block, &block, withoutScreenRefresh) == BlockResult::RETURN) return BlockResult::RETURN;
-        block.customBlockExecuted = true;
+        state.customBlockExecuted = true;
 
         BlockExecutor::addToRepeatQueue(sprite, &block);
+    } else if (state.customBlockPtr != nullptr && BlockExecutor::hasActiveRepeats(sprite, state.customBlockPtr->scriptIndex) &&
+        BlockExecutor::getThread(sprite, state.customBlockPtr->scriptIndex).warpYielded) {
+        // A custom block that ran out of time without screen refresh last frame picks up again here,
+        // so it finishes before the script that called it goes on
+        BlockExecutor::runRepeatsWithoutRefresh(sprite, state.customBlockPtr->scriptIndex);
     }
 
     // Check if any repeat blocks are still running inside the custom block
-    if (block.customBlockPtr != nullptr &&
-        !BlockExecutor::hasActiveRepeats(sprite, block.customBlockPtr->blockChainID)) {
+    if (state.customBlockPtr != nullptr &&
+        !BlockExecutor::hasActiveRepeats(sprite, state.customBlockPtr->scriptIndex)) {
 
         // std::cout << "done with custom!" << std::endl;
 
         // Custom block execution is complete
-        block.repeatTimes = -1; // Reset for next use
-        block.customBlockExecuted = false;
-        block.customBlockPtr = nullptr;
+        state.repeatTimes = -1; // Reset for next use
+        state.customBlockExecuted = false;
+        state.customBlockPtr = nullptr;
 
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
 
         return BlockResult::CONTINUE;
     }
-    if (block.customBlockPtr == nullptr) {
+    if (state.customBlockPtr == nullptr) {
         BlockExecutor::removeFromRepeatQueue(sprite, &block);
         return BlockResult::CONTINUE;
     }
@@ -1,8 +1,10 @@
 #include "sensing.hpp"
 #include "blockExecutor.hpp"
+#include "colorRaster.hpp"
 #include "input.hpp"
 #include "interpret.hpp"
 #include "keyboard.hpp"
+#include "spatialHash.hpp"
 #include "sprite.hpp"
 #include "value.hpp"
 #include <cmath>
@@ -71,14 +73,14 @@ Value SensingBlocks::of(Block &block, Sprite *sprite) {
     } else if (value == "costume #" || value == "backdrop #") {
         return Value(spriteObject->currentCostume + 1);
     } else if (value == "costume name" || value == "backdrop name") {
-        return Value(spriteObject->costumes[spriteObject->currentCostume].name);
+        return Value(spriteObject->data->costumes[spriteObject->currentCostume].name);
     } else if (value == "size") {
         return Value(spriteObject->size);
     } else if (value == "volume") {
         return Value(spriteObject->volume);
     }
 
-    for (const auto &[id, variable] : spriteObject->variables) {
+    for (const Variable &variable : spriteObject->variables) {
         if (value == variable.name) {
             return variable.value;
         }
@@ -180,9 +182,8 @@ Value SensingBlocks::touchingObject(Block &block, Sprite *sprite) {
     } else if (objectName == "_edge_") {
         return Value(isColliding("edge", sprite));
     } else {
-        for (size_t i = 0; i < sprites.size(); i++) {
-            Sprite *currentSprite = sprites[i];
-            if (currentSprite->name == objectName &&
+        for (Sprite *currentSprite : SpatialHash::query(sprite)) {
+            if (currentSprite != sprite && currentSprite->name == objectName &&
                 isColliding("sprite", sprite, currentSprite, objectName)) {
                 return Value(true);
             }
@@ -191,6 +192,18 @@ Value SensingBlocks::touchingObject(Block &block, Sprite *sprite) {
     return Value(false);
 }
 
+Value SensingBlocks::touchingColor(Block &block, Sprite *sprite) {
+    if (!sprite->visible) return Value(false);
+    return Value(ColorRaster::touchingColor(sprite, Scratch::getInputValue(block, "COLOR", sprite).asColor()));
+}
+
+Value SensingBlocks::colorIsTouchingColor(Block &block, Sprite *sprite) {
+    if (!sprite->visible) return Value(false);
+    const Color color = Scratch::getInputValue(block, "COLOR", sprite).asColor();
+    const Color touching = Scratch::getInputValue(block, "COLOR2", sprite).asColor();
+    return Value(ColorRaster::colorTouchingColor(sprite, color, touching));
+}
+
 Value SensingBlocks::mouseDown(Block &block, Sprite *sprite) {
     return Value(Input::mousePointer.isPressed);
 }
@@ -8,6 +8,7 @@
 #include "value.hpp"
 
 BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    BlockState &state = BlockExecutor::getBlockState(sprite, block);
     Value inputValue = Scratch::getInputValue(block, "SOUND_MENU", sprite);
     std::string inputString = inputValue.asString();
 
@@ -20,19 +21,19 @@ BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *
         }
     }
 
-    if (block.repeatTimes != -1 && !fromRepeat) {
-        block.repeatTimes = -1;
+    if (state.repeatTimes != -1 && !fromRepeat) {
+        state.repeatTimes = -1;
     }
 
-    if (block.repeatTimes == -1) {
-        block.repeatTimes = -2;
+    if (state.repeatTimes == -1) {
+        state.repeatTimes = -2;
 
         // Find sound by name first
         std::string soundFullName;
         bool soundFound = false;
 
-        auto soundFind = sprite->sounds.find(inputString);
-        if (soundFind != sprite->sounds.end()) {
+        auto soundFind = sprite->data->sounds.find(inputString);
+        if (soundFind != sprite->data->sounds.end()) {
             soundFullName = soundFind->second.fullName;
             soundFound = true;
         }
@@ -41,8 +42,8 @@ BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *
         if (!soundFound && Math::isNumber(inputString) && inputFind != block.parsedInputs->end() &&
             (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE)) {
             int soundIndex = inputValue.asInt() - 1;
-            if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->sounds.size()) {
-                auto it = sprite->sounds.begin();
+            if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->data->sounds.size()) {
+                auto it = sprite->data->sounds.begin();
                 std::advance(it, soundIndex);
                 soundFullName = it->second.fullName;
                 soundFound = true;
@@ -61,14 +62,14 @@ BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *
 
     // Check if sound is still playing (need to determine sound name again for check)
     std::string checkSoundName;
-    auto soundFind = sprite->sounds.find(inputString);
-    if (soundFind != sprite->sounds.end()) {
+    auto soundFind = sprite->data->sounds.find(inputString);
+    if (soundFind != sprite->data->sounds.end()) {
         checkSoundName = soundFind->second.fullName;
     } else if (Math::isNumber(inputString) && inputFind != block.parsedInputs->end() &&
                (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE)) {
         int soundIndex = inputValue.asInt() - 1;
-        if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->sounds.size()) {
-            auto it = sprite->sounds.begin();
+        if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->data->sounds.size()) {
+            auto it = sprite->data->sounds.begin();
             std::advance(it, soundIndex);
             checkSoundName = it->second.fullName;
         }
@@ -99,8 +100,8 @@ BlockResult SoundBlocks::playSound(Block &block, Sprite *sprite, bool *withoutSc
     std::string soundFullName;
     bool soundFound = false;
 
-    auto soundFind = sprite->sounds.find(inputString);
-    if (soundFind != sprite->sounds.end()) {
+    auto soundFind = sprite->data->sounds.find(inputString);
+    if (soundFind != sprite->data->sounds.end()) {
         soundFullName = soundFind->second.fullName;
         soundFound = true;
     }
@@ -109,8 +110,8 @@ BlockResult SoundBlocks::playSound(Block &block, Sprite *sprite, bool *withoutSc
     if (!soundFound && Math::isNumber(inputString) && inputFind != block.parsedInputs->end() &&
         (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE)) {
         int soundIndex = inputValue.asInt() - 1;
-        if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->sounds.size()) {
-            auto it = sprite->sounds.begin();
+        if (soundIndex >= 0 && static_cast<size_t>(soundIndex) < sprite->data->sounds.size()) {
+            auto it = sprite->data->sounds.begin();
             std::advance(it, soundIndex);
             soundFullName = it->second.fullName;
             soundFound = true;
@@ -129,7 +130,7 @@ BlockResult SoundBlocks::playSound(Block &block, Sprite *sprite, bool *withoutSc
 
 BlockResult SoundBlocks::stopAllSounds(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     for (auto &currentSprite : sprites) {
-        for (auto &[id, sound] : currentSprite->sounds) {
+        for (auto &[id, sound] : currentSprite->data->sounds) {
             SoundPlayer::stopSound(sound.fullName);
         }
     }
@@ -150,7 +151,7 @@ BlockResult SoundBlocks::clearSoundEffects(Block &block, Sprite *sprite, bool *w
 
 BlockResult SoundBlocks::changeVolumeBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value inputValue = Scratch::getInputValue(block, "VOLUME", sprite);
-    for (auto &[id, sound] : sprite->sounds) {
+    for (auto &[id, sound] : sprite->data->sounds) {
         SoundPlayer::setSoundVolume(sound.fullName, sprite->volume + inputValue.asDouble());
         sprite->volume = SoundPlayer::getSoundVolume(sound.fullName);
     }
@@ -159,7 +160,7 @@ BlockResult SoundBlocks::changeVolumeBy(Block &block, Sprite *sprite, bool *with
 
 BlockResult SoundBlocks::setVolumeTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value inputValue = Scratch::getInputValue(block, "VOLUME", sprite);
-    for (auto &[id, sound] : sprite->sounds) {
+    for (auto &[id, sound] : sprite->data->sounds) {
         SoundPlayer::setSoundVolume(sound.fullName, inputValue.asDouble());
     }
     sprite->volume = inputValue.asDouble();
@@ -0,0 +1,233 @@
+#include "collisionMask.hpp"
+#include "interpret.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// one row of stage pixels for each Sprite, reused between checks
+std::vector<uint64_t> rowBits;
+std::vector<uint64_t> otherRowBits;
+
+// copies `count` bits starting at bit `start` of a mask row, which may start or end outside of it
+bool copyBits(const uint64_t *source, int sourceWords, int start, int count, uint64_t *destination) {
+    const int words = (count + 63) / 64;
+    uint64_t any = 0;
+    for (int i = 0; i < words; i++) {
+        const int bit = start + i * 64;
+        const int word = bit >= 0 ? bit / 64 : -((-bit + 63) / 64);
+        const int shift = bit - word * 64;
+        const uint64_t low = word >= 0 && word < sourceWords ? source[word] : 0;
+        const uint64_t high = word + 1 >= 0 && word + 1 < sourceWords ? source[word + 1] : 0;
+        destination[i] = shift == 0 ? low : (low >> shift) | (high << (64 - shift));
+        if (i == words - 1 && count % 64 != 0) destination[i] &= (uint64_t{1} << (count % 64)) - 1;
+        any |= destination[i];
+    }
+    return any != 0;
+}
+
+// packs the mask pixels under a row of stage pixels into `row`, starting at the pixel centered on (x, y).
+// Returns whether any of them are set
+bool sampleRow(const CollisionMask &mask, const CollisionMask::Transform &transform, double x, double y, int count, uint64_t *row) {
+    double u = (x - transform.originX) * transform.uPerX + (y - transform.originY) * transform.uPerY;
+    double v = (x - transform.originX) * transform.vPerX + (y - transform.originY) * transform.vPerY;
+
+    // unrotated and at 100% size, the row is one run of mask pixels, so it can be copied a word at a time
+    if (std::abs(transform.uPerX - 1.0) < 1e-9 && std::abs(transform.vPerX) < 1e-9) {
+        const int maskY = static_cast<int>(std::floor(v));
+        if (maskY < mask.minY || maskY > mask.maxY) return false;
+        return copyBits(&mask.bits[static_cast<size_t>(maskY) * mask.wordsPerRow], mask.wordsPerRow, static_cast<int>(std::floor(u)), count, row);
+    }
+
+    std::fill(row, row + (count + 63) / 64, 0);
+    bool any = false;
+    for (int i = 0; i < count; i++, u += transform.uPerX, v += transform.vPerX) {
+        if (mask.getPixel(static_cast<int>(std::floor(u)), static_cast<int>(std::floor(v)))) {
+            row[i >> 6] |= uint64_t{1} << (i & 63);
+            any = true;
+        }
+    }
+    return any;
+}
+
+bool anyCommonBits(const uint64_t *a, const uint64_t *b, size_t words) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i common = _mm_setzero_si128();
+    for (; i + 2 <= words; i += 2) {
+        common = _mm_or_si128(common, _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i))));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(common, _mm_setzero_si128())) != 0xFFFF) return true;
+#elif defined(__ARM_NEON)
+    uint64x2_t common = vdupq_n_u64(0);
+    for (; i + 2 <= words; i += 2) {
+        common = vorrq_u64(common, vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+    }
+    if ((vgetq_lane_u64(common, 0) | vgetq_lane_u64(common, 1)) != 0) return true;
+#endif
+    for (; i < words; i++) {
+        if (a[i] & b[i]) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool CollisionMask::keepColors = false;
+
+bool CollisionMask::getTransform(Sprite *sprite, const CollisionMask &mask, Transform &transform) {
+    // the box starts at the costume's bottom left corner, then goes right, up, and back left.
+    // Sprites facing left with the left-right rotation style get turned around there instead of mirrored, so mirror them back
+    const CollisionPoints &points = getCollisionPoints(sprite);
+    const bool mirrored = sprite->rotationStyle == Sprite::LEFT_RIGHT && sprite->rotation < 0;
+    const auto &origin = mirrored ? points[0] : points[3];
+    const auto &bottom = mirrored ? points[3] : points[0];
+
+    const double acrossX = points[1].first - points[0].first;
+    const double acrossY = points[1].second - points[0].second;
+    const double downX = bottom.first - origin.first;
+    const double downY = bottom.second - origin.second;
+    const double acrossLength = acrossX * acrossX + acrossY * acrossY;
+    const double downLength = downX * downX + downY * downY;
+    if (!(acrossLength > 0) || !(downLength > 0)) return false;
+
+    transform.originX = origin.first;
+    transform.originY = origin.second;
+    transform.uPerX = acrossX / acrossLength * mask.width;
+    transform.uPerY = acrossY / acrossLength * mask.width;
+    transform.vPerX = downX / downLength * mask.height;
+    transform.vPerY = downY / downLength * mask.height;
+    transform.xPerU = acrossX / mask.width;
+    transform.yPerU = acrossY / mask.width;
+    transform.xPerV = downX / mask.height;
+    transform.yPerV = downY / mask.height;
+    return true;
+}
+
+CollisionMask::Bounds CollisionMask::getBounds(const CollisionMask &mask, const Transform &transform) {
+    Bounds bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+    for (const int u : {mask.minX, mask.maxX + 1}) {
+        for (const int v : {mask.minY, mask.maxY + 1}) {
+            const double x = transform.originX + u * transform.xPerU + v * transform.xPerV;
+            const double y = transform.originY + u * transform.yPerU + v * transform.yPerV;
+            bounds.minX = std::min(bounds.minX, x);
+            bounds.minY = std::min(bounds.minY, y);
+            bounds.maxX = std::max(bounds.maxX, x);
+            bounds.maxY = std::max(bounds.maxY, y);
+        }
+    }
+    return bounds;
+}
+
+CollisionMask::CollisionMask(const uint8_t *pixels, int imageWidth, int imageHeight, int pitch, int pixelsPerUnit) {
+    if (pixels == nullptr || imageWidth <= 0 || imageHeight <= 0) return;
+
+    // image pixels per mask pixel, along each side
+    int step = std::max(1, pixelsPerUnit);
+    while ((imageWidth + step - 1) / step > maxSize || (imageHeight + step - 1) / step > maxSize) {
+        step++;
+    }
+    width = (imageWidth + step - 1) / step;
+    height = (imageHeight + step - 1) / step;
+    wordsPerRow = (width + 63) / 64;
+    bits.assign(static_cast<size_t>(height) * wordsPerRow, 0);
+
+    // alpha weighted sums of red, green, blue, then the sum of alpha, for each pixel of the mask row being built
+    std::vector<uint32_t> sums;
+    if (keepColors) {
+        colors.assign(static_cast<size_t>(width) * height, 0);
+        sums.resize(static_cast<size_t>(width) * 4);
+    }
+    auto storeColors = [&](int maskY) {
+        const uint32_t pixelCount = static_cast<uint32_t>(step * step);
+        for (int maskX = 0; maskX < width; maskX++) {
+            uint32_t *sum = &sums[static_cast<size_t>(maskX) * 4];
+            if (sum[3] == 0) continue;
+            const uint32_t r = (sum[0] + sum[3] / 2) / sum[3];
+            const uint32_t g = (sum[1] + sum[3] / 2) / sum[3];
+            const uint32_t b = (sum[2] + sum[3] / 2) / sum[3];
+            const uint32_t a = std::max<uint32_t>(1, (sum[3] + pixelCount / 2) / pixelCount);
+            colors[static_cast<size_t>(maskY) * width + maskX] = r | g << 8 | b << 16 | a << 24;
+            std::fill(sum, sum + 4, 0);
+        }
+    };
+
+    minX = width;
+    minY = height;
+    for (int y = 0; y < imageHeight; y++) {
+        const uint8_t *imageRow = pixels + static_cast<size_t>(y) * pitch;
+        const int maskY = y / step;
+        uint64_t *maskRow = &bits[static_cast<size_t>(maskY) * wordsPerRow];
+        for (int x = 0; x < imageWidth; x++) {
+            const uint8_t *pixel = imageRow + x * 4;
+            if (pixel[3] == 0) continue;
+            const int maskX = x / step;
+            maskRow[maskX >> 6] |= uint64_t{1} << (maskX & 63);
+            minX = std::min(minX, maskX);
+            maxX = std::max(maxX, maskX);
+            minY = std::min(minY, maskY);
+            maxY = std::max(maxY, maskY);
+            if (keepColors) {
+                uint32_t *sum = &sums[static_cast<size_t>(maskX) * 4];
+                sum[0] += pixel[0] * pixel[3];
+                sum[1] += pixel[1] * pixel[3];
+                sum[2] += pixel[2] * pixel[3];
+                sum[3] += pixel[3];
+            }
+        }
+        if (keepColors && (y % step == step - 1 || y == imageHeight - 1)) storeColors(maskY);
+    }
+    if (maxX < 0) {
+        minX = 0;
+        minY = 0;
+    }
+}
+
+bool CollisionMask::touching(Sprite *sprite, const CollisionMask &mask, Sprite *other, const CollisionMask &otherMask) {
+    if (mask.maxX < mask.minX || otherMask.maxX < otherMask.minX) return false;
+
+    Transform transform, otherTransform;
+    if (!getTransform(sprite, mask, transform) || !getTransform(other, otherMask, otherTransform)) return false;
+
+    // only stage pixels covered by both Sprites can touch
+    const Bounds bounds = getBounds(mask, transform);
+    const Bounds otherBounds = getBounds(otherMask, otherTransform);
+    const double halfWidth = Scratch::projectWidth / 2.0;
+    const double halfHeight = Scratch::projectHeight / 2.0;
+    const double left = std::floor(std::max({bounds.minX, otherBounds.minX, -halfWidth}));
+    const double right = std::ceil(std::min({bounds.maxX, otherBounds.maxX, halfWidth}));
+    const double bottom = std::floor(std::max({bounds.minY, otherBounds.minY, -halfHeight}));
+    const double top = std::ceil(std::min({bounds.maxY, otherBounds.maxY, halfHeight}));
+    if (!(left < right) || !(bottom < top)) return false;
+
+    const int columns = static_cast<int>(right - left);
+    const size_t words = (columns + 63) / 64;
+    if (rowBits.size() < words) {
+        rowBits.resize(words);
+        otherRowBits.resize(words);
+    }
+
+    for (double y = top - 0.5; y > bottom; y--) {
+        if (!sampleRow(mask, transform, left + 0.5, y, columns, rowBits.data())) continue;
+        if (!sampleRow(otherMask, otherTransform, left + 0.5, y, columns, otherRowBits.data())) continue;
+        if (anyCommonBits(rowBits.data(), otherRowBits.data(), words)) return true;
+    }
+    return false;
+}
+
+bool CollisionMask::touchingPoint(Sprite *sprite, const CollisionMask &mask, double x, double y) {
+    Transform transform;
+    if (!getTransform(sprite, mask, transform)) return false;
+
+    const double u = (x - transform.originX) * transform.uPerX + (y - transform.originY) * transform.uPerY;
+    const double v = (x - transform.originX) * transform.vPerX + (y - transform.originY) * transform.vPerY;
+    if (!(u >= 0 && u < mask.width && v >= 0 && v < mask.height)) return false;
+    return mask.getPixel(static_cast<int>(u), static_cast<int>(v));
+}
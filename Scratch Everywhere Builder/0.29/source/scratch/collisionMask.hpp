@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Sprite;
+
+/**
+ * 1-bit alpha mask of a costume, for pixel-accurate collision checks.
+ * It's built once when the costume is decoded and kept next to its texture (see `Image::getCollisionMask()`),
+ * so checks never have to read pixels back from the GPU.
+ * Masks are never finer than the stage at 100% size, and never larger than `maxSize` on either side.
+ * While `keepColors` is set, the mask also keeps the costume's colors at the same resolution, for the touching color blocks.
+ */
+class CollisionMask {
+  public:
+    // longest side of a mask, in pixels. Larger costumes get downscaled
+    static constexpr int maxSize = 256;
+
+    // whether new masks keep colors too. Only projects that check for colors need them
+    static bool keepColors;
+
+    // maps stage coordinates to mask pixels (and back), from a Sprite's collision box
+    struct Transform {
+        double originX, originY; // stage position of the mask's top left corner
+        double uPerX, uPerY;     // mask columns per stage unit along X and Y
+        double vPerX, vPerY;     // mask rows per stage unit along X and Y
+        double xPerU, yPerU;     // stage units per mask column
+        double xPerV, yPerV;     // stage units per mask row
+    };
+
+    struct Bounds {
+        double minX, minY, maxX, maxY;
+    };
+
+    CollisionMask() = default;
+
+    /**
+     * Builds a mask from decoded pixels. A mask pixel is set if any image pixel it covers isn't fully transparent,
+     * and its color is the average of those pixels, weighted by their alpha.
+     * @param pixels RGBA pixels, 4 bytes each, with alpha last
+     * @param width Width of the image, in pixels
+     * @param height Height of the image, in pixels
+     * @param pitch Bytes from the start of one row to the next
+     * @param pixelsPerUnit Image pixels per Scratch unit at 100% size (2 for bitmaps, 1 for SVGs)
+     */
+    CollisionMask(const uint8_t *pixels, int width, int height, int pitch, int pixelsPerUnit);
+
+    /**
+     * Whether the mask was built from an image. Costumes without one fall back to box collision.
+     */
+    bool isLoaded() const { return width > 0 && height > 0; }
+
+    /**
+     * Whether a pixel is set. Pixels outside the mask never are.
+     * @param x
+     * @param y From the top of the costume
+     */
+    bool getPixel(int x, int y) const {
+        if (x < minX || x > maxX || y < minY || y > maxY) return false;
+        return (bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    /**
+     * Gets the color of a pixel, packed as `r | g << 8 | b << 16 | a << 24` without premultiplied alpha.
+     * Pixels outside the mask, or of a mask without colors, are transparent black.
+     * @param x
+     * @param y From the top of the costume
+     */
+    uint32_t getColor(int x, int y) const {
+        if (colors.empty() || x < minX || x > maxX || y < minY || y > maxY) return 0;
+        return colors[static_cast<size_t>(y) * width + x];
+    }
+
+    /**
+     * Gets where a Sprite's mask currently is on the stage.
+     * @param sprite
+     * @param mask The mask of `sprite`'s current costume
+     * @param transform Set to the Sprite's transform
+     * @return false if the Sprite has no area, like at 0% size.
+     */
+    static bool getTransform(Sprite *sprite, const CollisionMask &mask, Transform &transform);
+
+    /**
+     * Gets the stage bounds of a mask's set pixels, which can be a lot smaller than the costume.
+     * @param mask
+     * @param transform From `getTransform()`
+     */
+    static Bounds getBounds(const CollisionMask &mask, const Transform &transform);
+
+    /**
+     * Checks whether two Sprites touch, by sampling both masks at every stage pixel where their boxes overlap.
+     * Each row is packed into words and ANDed together, so a row of up to 64 pixels takes one instruction.
+     * @param sprite
+     * @param mask The mask of `sprite`'s current costume
+     * @param other
+     * @param otherMask The mask of `other`'s current costume
+     */
+    static bool touching(Sprite *sprite, const CollisionMask &mask, Sprite *other, const CollisionMask &otherMask);
+
+    /**
+     * Checks whether a Sprite covers a point on the stage, like the mouse pointer.
+     * @param sprite
+     * @param mask The mask of `sprite`'s current costume
+     * @param x
+     * @param y
+     */
+    static bool touchingPoint(Sprite *sprite, const CollisionMask &mask, double x, double y);
+
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    // tightest box around every set pixel, inclusive. `minX > maxX` if nothing is set
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    // row by row, pixel `x` of a row is bit `x & 63` of word `x >> 6`. Bits past `width` are always 0
+    std::vector<uint64_t> bits;
+    // row by row, one packed color per pixel (see `getColor()`). Empty unless `keepColors` was set
+    std::vector<uint32_t> colors;
+};
@@ -0,0 +1,208 @@
+#include "colorRaster.hpp"
+#include "collisionMask.hpp"
+#include "interpret.hpp"
+#include "spatialHash.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// bits of each channel that have to match, packed like `CollisionMask::getColor()`
+constexpr uint32_t touchingBits = 0x00F0F8F8;
+constexpr uint32_t ownColorBits = 0x00FCFCFC;
+constexpr uint32_t white = 0xFFFFFFFF;
+
+// something drawn under the asking Sprite
+struct Layer {
+    const CollisionMask *mask;
+    CollisionMask::Transform transform;
+    CollisionMask::Bounds bounds;
+};
+
+// everything that might be under the asking Sprite, from back to front
+std::vector<Layer> layers;
+std::vector<Sprite *> nearby;
+// one row of stage pixels under the asking Sprite, and which of them it covers. Reused between checks
+std::vector<uint32_t> rowPixels;
+std::vector<uint64_t> rowKeep;
+
+// a single set pixel, which covers a Sprite's whole collision box. Stands in for costumes without a mask
+const CollisionMask boxMask = [] {
+    CollisionMask mask;
+    mask.width = mask.height = mask.wordsPerRow = 1;
+    mask.minX = mask.minY = mask.maxX = mask.maxY = 0;
+    mask.bits = {1};
+    return mask;
+}();
+
+uint32_t pack(const Color &color) {
+    const ColorRGB rgb = CSB2RGB(color);
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::clamp<long>(std::lround(value), 0, 255));
+    };
+    return channel(rgb.r) | channel(rgb.g) << 8 | channel(rgb.b) << 16;
+}
+
+void addLayer(Sprite *sprite) {
+    Layer layer;
+    // costumes without colors can't be drawn, so they're left out
+    layer.mask = getCostumeMask(sprite);
+    if (layer.mask == nullptr || layer.mask->colors.empty() || layer.mask->maxX < layer.mask->minX) return;
+    if (!CollisionMask::getTransform(sprite, *layer.mask, layer.transform)) return;
+    layer.bounds = CollisionMask::getBounds(*layer.mask, layer.transform);
+    layers.push_back(layer);
+}
+
+// draws a straight alpha color over an opaque one
+uint32_t blend(uint32_t destination, uint32_t source) {
+    const uint32_t alpha = source >> 24;
+    if (alpha == 255) return source;
+    if (alpha == 0) return destination;
+    uint32_t result = 0xFF000000;
+    for (int shift = 0; shift < 24; shift += 8) {
+        const uint32_t sourceChannel = (source >> shift) & 0xFF;
+        const uint32_t destinationChannel = (destination >> shift) & 0xFF;
+        result |= ((sourceChannel * alpha + destinationChannel * (255 - alpha) + 127) / 255) << shift;
+    }
+    return result;
+}
+
+// draws a layer over the kept pixels of the row, which starts at the stage pixel centered on (x, y)
+void drawRow(const Layer &layer, double x, double y, int count) {
+    if (y < layer.bounds.minY || y > layer.bounds.maxY) return;
+    const int first = static_cast<int>(std::max(0.0, std::floor(layer.bounds.minX - x)));
+    const int last = static_cast<int>(std::min(static_cast<double>(count), std::ceil(layer.bounds.maxX - x) + 1));
+
+    const CollisionMask::Transform &transform = layer.transform;
+    double u = (x + first - transform.originX) * transform.uPerX + (y - transform.originY) * transform.uPerY;
+    double v = (x + first - transform.originX) * transform.vPerX + (y - transform.originY) * transform.vPerY;
+    for (int i = first; i < last; i++, u += transform.uPerX, v += transform.vPerX) {
+        if (!((rowKeep[i >> 6] >> (i & 63)) & 1)) continue;
+        const uint32_t color = layer.mask->getColor(static_cast<int>(std::floor(u)), static_cast<int>(std::floor(v)));
+        if (color != 0) rowPixels[i] = blend(rowPixels[i], color);
+    }
+}
+
+// whether any kept pixel matches `color` in the given bits. Four pixels are compared at once where possible
+bool anyMatching(const uint32_t *pixels, int count, uint32_t color, uint32_t bits, const uint64_t *keep) {
+    const uint32_t target = color & bits;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i targets = _mm_set1_epi32(static_cast<int>(target));
+    const __m128i masks = _mm_set1_epi32(static_cast<int>(bits));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i matches = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i)), masks), targets);
+        const uint64_t matched = static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+        if (matched & (keep[i >> 6] >> (i & 63))) return true;
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t targets = vdupq_n_u32(target);
+    const uint32x4_t masks = vdupq_n_u32(bits);
+    const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t lanes = vld1q_u32(laneBits);
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t matches = vandq_u32(vceqq_u32(vandq_u32(vld1q_u32(pixels + i), masks), targets), lanes);
+        const uint32x2_t halves = vadd_u32(vget_low_u32(matches), vget_high_u32(matches));
+        const uint64_t matched = vget_lane_u32(vpadd_u32(halves, halves), 0);
+        if (matched & (keep[i >> 6] >> (i & 63))) return true;
+    }
+#endif
+    for (; i < count; i++) {
+        if (((keep[i >> 6] >> (i & 63)) & 1) && (pixels[i] & bits) == target) return true;
+    }
+    return false;
+}
+
+// `ownColor` is only checked if `matchOwnColor` is set
+bool isTouchingColor(Sprite *sprite, uint32_t color, bool matchOwnColor, uint32_t ownColor) {
+    const CollisionMask *mask = getCostumeMask(sprite);
+    if (mask == nullptr || !mask->isLoaded()) {
+        // without a mask, the Sprite's whole box counts, like for the touching blocks. Its own colors are unknown though
+        if (matchOwnColor) return false;
+        mask = &boxMask;
+    }
+    if (mask->maxX < mask->minX || (matchOwnColor && mask->colors.empty())) return false;
+    CollisionMask::Transform transform;
+    if (!CollisionMask::getTransform(sprite, *mask, transform)) return false;
+
+    // only stage pixels the Sprite covers count
+    const CollisionMask::Bounds bounds = CollisionMask::getBounds(*mask, transform);
+    const double halfWidth = Scratch::projectWidth / 2.0;
+    const double halfHeight = Scratch::projectHeight / 2.0;
+    const double left = std::floor(std::max(bounds.minX, -halfWidth));
+    const double right = std::ceil(std::min(bounds.maxX, halfWidth));
+    const double bottom = std::floor(std::max(bounds.minY, -halfHeight));
+    const double top = std::ceil(std::min(bounds.maxY, halfHeight));
+    if (!(left < right) || !(bottom < top)) return false;
+
+    layers.clear();
+    for (auto it = sprites.rbegin(); it != sprites.rend(); it++) {
+        if ((*it)->isStage) {
+            addLayer(*it);
+            break;
+        }
+    }
+    nearby.clear();
+    for (Sprite *other : SpatialHash::query(sprite)) {
+        if (other != sprite) nearby.push_back(other);
+    }
+    std::sort(nearby.begin(), nearby.end(), [](Sprite *a, Sprite *b) { return a->layer < b->layer; });
+    for (Sprite *other : nearby) {
+        addLayer(other);
+    }
+
+    const int columns = static_cast<int>(right - left);
+    const size_t words = (columns + 63) / 64;
+    if (rowPixels.size() < static_cast<size_t>(columns)) rowPixels.resize(columns);
+    if (rowKeep.size() < words) rowKeep.resize(words);
+    ownColor &= ownColorBits;
+
+    for (double y = top - 0.5; y > bottom; y--) {
+        const double x = left + 0.5;
+        double u = (x - transform.originX) * transform.uPerX + (y - transform.originY) * transform.uPerY;
+        double v = (x - transform.originX) * transform.vPerX + (y - transform.originY) * transform.vPerY;
+        std::fill(rowKeep.begin(), rowKeep.begin() + words, 0);
+        bool any = false;
+        for (int i = 0; i < columns; i++, u += transform.uPerX, v += transform.vPerX) {
+            const int maskX = static_cast<int>(std::floor(u));
+            const int maskY = static_cast<int>(std::floor(v));
+            bool keep;
+            if (matchOwnColor) {
+                const uint32_t pixel = mask->getColor(maskX, maskY);
+                keep = (pixel >> 24) != 0 && (pixel & ownColorBits) == ownColor;
+            } else {
+                keep = mask->getPixel(maskX, maskY);
+            }
+            if (keep) {
+                rowKeep[i >> 6] |= uint64_t{1} << (i & 63);
+                any = true;
+            }
+        }
+        if (!any) continue;
+
+        std::fill(rowPixels.begin(), rowPixels.begin() + columns, white);
+        for (const Layer &layer : layers) {
+            drawRow(layer, x, y, columns);
+        }
+        if (anyMatching(rowPixels.data(), columns, color, touchingBits, rowKeep.data())) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool ColorRaster::touchingColor(Sprite *sprite, const Color &color) {
+    return isTouchingColor(sprite, pack(color), false, 0);
+}
+
+bool ColorRaster::colorTouchingColor(Sprite *sprite, const Color &color, const Color &touching) {
+    return isTouchingColor(sprite, pack(touching), true, pack(color));
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "color.hpp"
+
+class Sprite;
+
+/**
+ * Answers the touching color blocks without reading anything back from the GPU.
+ * Only the stage pixels under the asking Sprite get drawn, on the CPU, from the colors kept in each costume's
+ * collision mask (see `CollisionMask::keepColors`): first the backdrop, then every nearby Sprite from back to front.
+ * Like Scratch, the asking Sprite is left out and the ghost effect is ignored. The pen layer and other effects aren't drawn.
+ * A costume without a collision mask covers its whole box when asking, and isn't drawn under other Sprites.
+ */
+class ColorRaster {
+  public:
+    /**
+     * Checks whether any of a Sprite's pixels are over a color.
+     * Colors match if their top 5 bits of red and green and top 4 bits of blue are the same, like in Scratch.
+     * @param sprite
+     * @param color
+     */
+    static bool touchingColor(Sprite *sprite, const Color &color);
+
+    /**
+     * Checks whether any of a Sprite's pixels of one color are over another color.
+     * The Sprite's own pixels match if their top 6 bits of each channel are the same.
+     * @param sprite
+     * @param color The color of the Sprite's own pixels
+     * @param touching The color those pixels need to be over
+     */
+    static bool colorTouchingColor(Sprite *sprite, const Color &color, const Color &touching);
+};
@@ -0,0 +1,131 @@
+#include "compiler.hpp"
+#include "blockExecutor.hpp"
+#include "interpret.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+void Compiler::compileSprite(Sprite *sprite) {
+    sprite->data->bytecode.clear();
+    sprite->data->scriptStateCounts.clear();
+    sprite->data->hats.clear();
+    for (auto &[id, block] : sprite->data->blocks) {
+        block.pc = -1;
+        block.scriptIndex = -1;
+        block.stateIndex = -1;
+
+        // resolve reporter inputs so they don't need a lookup every time they're evaluated
+        for (auto &[inputName, input] : *block.parsedInputs) {
+            if (input.inputType == ParsedInput::BLOCK || input.inputType == ParsedInput::BOOLEAN)
+                input.block = input.blockId.empty() ? nullptr : findBlock(input.blockId);
+            else if (input.inputType == ParsedInput::VARIABLE)
+                input.variable = BlockExecutor::resolveVariable(input.variableId, sprite);
+        }
+
+        // same for variables and lists, so they don't have to be searched for by ID
+        block.variable = VariableRef();
+        auto variableIt = block.parsedFields->find("VARIABLE");
+        auto listIt = block.parsedFields->find("LIST");
+        if (variableIt != block.parsedFields->end() && !variableIt->second.id.empty())
+            block.variable = BlockExecutor::resolveVariable(variableIt->second.id, sprite);
+        else if (listIt != block.parsedFields->end() && !listIt->second.id.empty())
+            block.variable = BlockExecutor::resolveVariable(listIt->second.id, sprite, true);
+    }
+
+    for (auto &[id, block] : sprite->data->blocks) {
+        if (!block.topLevel) continue;
+        sprite->data->scriptStateCounts.push_back(0);
+        compileStack(sprite, id, static_cast<int32_t>(sprite->data->scriptStateCounts.size() - 1));
+        if (isHat(block.opcodeId)) sprite->data->hats.push_back(&block);
+    }
+
+    sprite->threads.clear();
+}
+
+bool Compiler::needsState(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::CONTROL_IF:
+    case Opcode::CONTROL_IF_ELSE:
+    case Opcode::CONTROL_WAIT:
+    case Opcode::CONTROL_WAIT_UNTIL:
+    case Opcode::CONTROL_REPEAT:
+    case Opcode::CONTROL_REPEAT_UNTIL:
+    case Opcode::CONTROL_WHILE:
+    case Opcode::CONTROL_FOREVER:
+    case Opcode::CONTROL_FOR_EACH:
+    case Opcode::EVENT_BROADCASTANDWAIT:
+    case Opcode::MOTION_GLIDESECSTOXY:
+    case Opcode::MOTION_GLIDETO:
+    case Opcode::SOUND_PLAYUNTILDONE:
+    case Opcode::PROCEDURES_CALL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Compiler::isHat(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::EVENT_WHENFLAGCLICKED:
+    case Opcode::EVENT_WHENKEYPRESSED:
+    case Opcode::EVENT_WHENTHISSPRITECLICKED:
+    case Opcode::EVENT_WHENBACKDROPSWITCHESTO:
+    case Opcode::EVENT_WHENBROADCASTRECEIVED:
+    case Opcode::CONTROL_START_AS_CLONE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int32_t Compiler::compileStack(Sprite *sprite, const std::string &blockId, int32_t scriptIndex) {
+    const int32_t start = static_cast<int32_t>(sprite->data->bytecode.size());
+
+    // lay the stack out contiguously first, so `next` is usually just the following instruction
+    std::vector<Block *> stack;
+    std::string currentId = blockId;
+    while (!currentId.empty() && currentId != "null") {
+        auto it = sprite->data->blocks.find(currentId);
+        if (it == sprite->data->blocks.end()) break;
+        Block *block = &it->second;
+        if (block->pc != -1) break;
+
+        block->pc = static_cast<int32_t>(sprite->data->bytecode.size());
+        block->scriptIndex = scriptIndex;
+        if (needsState(block->opcodeId)) block->stateIndex = static_cast<int32_t>(sprite->data->scriptStateCounts[scriptIndex]++);
+        sprite->data->bytecode.push_back({block->opcodeId, block, -1, -1, -1});
+        stack.push_back(block);
+        currentId = block->next;
+    }
+    if (stack.empty()) {
+        auto it = sprite->data->blocks.find(blockId);
+        return it != sprite->data->blocks.end() ? it->second.pc : -1;
+    }
+
+    for (size_t i = 0; i < stack.size(); i++) {
+        Block *block = stack[i];
+        int32_t next = -1;
+        if (i + 1 < stack.size()) {
+            next = stack[i + 1]->pc;
+        } else if (!block->next.empty()) {
+            auto it = sprite->data->blocks.find(block->next);
+            if (it != sprite->data->blocks.end()) next = it->second.pc;
+        }
+
+        int32_t substack = -1;
+        int32_t substack2 = -1;
+        auto substackIt = block->parsedInputs->find("SUBSTACK");
+        if (substackIt != block->parsedInputs->end() && !substackIt->second.blockId.empty())
+            substack = compileStack(sprite, substackIt->second.blockId, scriptIndex);
+        auto substack2It = block->parsedInputs->find("SUBSTACK2");
+        if (substack2It != block->parsedInputs->end() && !substack2It->second.blockId.empty())
+            substack2 = compileStack(sprite, substack2It->second.blockId, scriptIndex);
+
+        // `bytecode` may have grown while compiling substacks, so index it again
+        Instruction &instruction = sprite->data->bytecode[block->pc];
+        instruction.next = next;
+        instruction.substack = substack;
+        instruction.substack2 = substack2;
+    }
+    return start;
+}
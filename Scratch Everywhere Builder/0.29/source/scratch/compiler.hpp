@@ -0,0 +1,42 @@
+#pragma once
+#include "sprite.hpp"
+
+class Compiler {
+  public:
+    /**
+     * Flattens every script in a `sprite` into `sprite->data->bytecode`.
+     * Each stack block gets an `Instruction` with its `Opcode`,
+     * and its `next`/`SUBSTACK`/`SUBSTACK2` links turned into indices into the same array.
+     * Block inputs that point to reporter blocks are resolved to `Block*` as well, and variable and list references to a `VariableRef`,
+     * and every block is given the index of the script it is in, plus a `stateIndex` if it needs runtime state.
+     * Top level hat blocks are collected into `sprite->data->hats`.
+     * Must be called after every Sprite has been loaded, since inputs are resolved through `blockLookup` and the Stage's variables.
+     * @param sprite Pointer to the Sprite to compile.
+     */
+    static void compileSprite(Sprite *sprite);
+
+    /**
+     * Checks if blocks with this `opcode` keep a `BlockState` while running (loops, waits, glides, etc.)
+     * @param opcode
+     * @return `true` if the block needs a `BlockState`.
+     */
+    static bool needsState(Opcode opcode);
+
+    /**
+     * Checks if blocks with this `opcode` are hat blocks that get started by an event (green flag, broadcasts, key presses, etc.)
+     * Hat blocks are kept in `sprite->data->hats` and indexed by `BlockExecutor::addHats()`.
+     * @param opcode
+     * @return `true` if the block is an event hat.
+     */
+    static bool isHat(Opcode opcode);
+
+  private:
+    /**
+     * Emits a stack of blocks (and every substack inside it) into `sprite->data->bytecode`.
+     * @param sprite Pointer to the Sprite being compiled.
+     * @param blockId ID of the first block in the stack.
+     * @param scriptIndex Index of the script the stack is in.
+     * @return Index of the first emitted instruction, or `-1` if the stack is empty.
+     */
+    static int32_t compileStack(Sprite *sprite, const std::string &blockId, int32_t scriptIndex);
+};
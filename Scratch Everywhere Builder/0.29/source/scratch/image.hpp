@@ -1,4 +1,5 @@
 #pragma once
+#include "collisionMask.hpp"
 #include "interpret.hpp"
 #include "miniz.h"
 #include <string>
@@ -44,6 +45,14 @@ class Image {
      */
     static void loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId, Sprite *sprite);
 
+    /**
+     * Gets the collision mask that was built when a costume got loaded.
+     * It lives as long as the costume's image does.
+     * @param costumeId
+     * @return The mask, or `nullptr` if the costume isn't loaded or doesn't have one.
+     */
+    static const CollisionMask *getCollisionMask(const std::string &costumeId);
+
     /**
      * `3DS`: Frees a `C2D_Image` from memory.
      * `SDL`: Frees an `SDL_Image` from memory.
@@ -101,9 +101,9 @@ class Input {
 
                         // run all "when this sprite clicked" blocks in the sprite
                         hasClicked = true;
-                        for (auto &[id, data] : sprite->blocks) {
-                            if (data.opcode == "event_whenthisspriteclicked") {
-                                executor.runBlock(data, sprite);
+                        for (Block *hat : sprite->data->hats) {
+                            if (hat->opcodeId == Opcode::EVENT_WHENTHISSPRITECLICKED) {
+                                executor.runBlock(*hat, sprite);
                             }
                         }
                     }
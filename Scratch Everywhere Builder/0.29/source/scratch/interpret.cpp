@@ -1,17 +1,24 @@
 #include "interpret.hpp"
 #include "audio.hpp"
+#include "collisionMask.hpp"
+#include "compiler.hpp"
 #include "image.hpp"
 #include "input.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "nlohmann/json.hpp"
 #include "os.hpp"
 #include "render.hpp"
+#include "spatialHash.hpp"
 #include "sprite.hpp"
+#include "trace.hpp"
 #include "unzip.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <math.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -21,6 +28,10 @@
 #include <whb/sdcard.h>
 #endif
 
+#ifdef ENABLE_PROFILER
+#include "profiler.hpp"
+#endif
+
 #ifdef ENABLE_CLOUDVARS
 #include <mist/mist.hpp>
 #include <random>
@@ -41,7 +52,13 @@ bool useCustomUsername;
 std::string customUsername;
 
 std::vector<Sprite *> sprites;
-std::vector<Sprite> spritePool;
+// Clones live in chunks that never move, so `Sprite*`s to them stay valid. Deleted ones are chained
+// through `Sprite::nextFree` for the next Clone to reuse
+std::vector<std::unique_ptr<Sprite[]>> spritePool;
+Sprite *freeSprites = nullptr;
+int spritePoolSize = 0;
+int spritePoolLimit = 0;
+Sprite *stageSprite = nullptr;
 std::vector<std::string> broadcastQueue;
 std::unordered_map<std::string, Block *> blockLookup;
 std::string answer;
@@ -54,6 +71,9 @@ int Scratch::projectWidth = 480;
 int Scratch::projectHeight = 360;
 int Scratch::FPS = 30;
 bool Scratch::turbo = false;
+float Scratch::turboFrameBudget = 0.75f;
+int Scratch::ticksPerFrame = 0;
+int Scratch::warpTimeLimit = 500;
 bool Scratch::hqpen = false;
 bool Scratch::fencing = true;
 bool Scratch::miscellaneousLimits = true;
@@ -126,6 +146,31 @@ void initMist() {
 }
 #endif
 
+int ticksSinceRender = 0;
+
+// Runs one tick. In turbo mode, keeps running ticks until `turboFrameBudget` of the frame is used up or the next frame is due,
+// the project stops, or a tick runs no blocks at all
+void runTicks() {
+    blocksRun = 0;
+    Timer budgetTimer;
+    const double frameBudgetMs = Scratch::FPS > 0 ? Scratch::turboFrameBudget * 1000.0 / Scratch::FPS : 0;
+    // the frame this runs before may already be partly over, so never run past when it's due
+    const int budgetMs = static_cast<int>(std::min(frameBudgetMs, Render::timeUntilFrame()));
+    size_t blocksBefore;
+    do {
+        blocksBefore = blocksRun;
+        {
+            TRACE_SPAN("BlockExecutor::runRepeatBlocks");
+            BlockExecutor::runRepeatBlocks();
+        }
+        {
+            TRACE_SPAN("BlockExecutor::runBroadcasts");
+            BlockExecutor::runBroadcasts();
+        }
+        ticksSinceRender++;
+    } while (Scratch::turbo && !Scratch::shouldStop && blocksRun > blocksBefore && budgetTimer.getTimeMs() < budgetMs);
+}
+
 bool Scratch::startScratchProject() {
     customUsername = "Player";
     useCustomUsername = false;
@@ -159,19 +204,33 @@ bool Scratch::startScratchProject() {
     Scratch::nextProject = false;
 
     // Render first before running any blocks, otherwise 3DS rendering may get weird
+    Layers::updateSprites();
     Render::renderSprites();
 
-    BlockExecutor::runAllBlocksByOpcode("event_whenflagclicked");
+    BlockExecutor::runAllBlocksByOpcode(Opcode::EVENT_WHENFLAGCLICKED);
     BlockExecutor::timer.start();
 
     while (Render::appShouldRun()) {
         const bool checkFPS = Render::checkFramerate();
-        if (!forceRedraw || checkFPS) {
+        // turbo mode doesn't hold scripts back for a redraw, it keeps running ticks and only renders when a frame is due
+        if (!forceRedraw || checkFPS || Scratch::turbo) {
+            TRACE_SPAN("Frame");
             forceRedraw = false;
-            Input::getInput();
-            BlockExecutor::runRepeatBlocks();
-            BlockExecutor::runBroadcasts();
-            if (checkFPS) Render::renderSprites();
+            {
+                TRACE_SPAN("Input::getInput");
+                Input::getInput();
+            }
+            runTicks();
+            if (checkFPS) {
+                TRACE_SPAN("Render::renderSprites");
+                ticksPerFrame = ticksSinceRender;
+                ticksSinceRender = 0;
+                Layers::updateSprites();
+                Render::renderSprites();
+            } else if (Scratch::turbo && blocksRun == 0) {
+                // nothing is running, so more ticks before the next frame would just spin
+                Render::waitForFrame();
+            }
 
             if (shouldStop) {
 #if defined(HEADLESS_BUILD)
@@ -186,6 +245,9 @@ bool Scratch::startScratchProject() {
                 shouldStop = false;
                 return true;
             }
+        } else {
+            // a redraw is waiting on the next frame, and nothing else can run until then
+            Render::waitForFrame();
         }
     }
     cleanupScratchProject();
@@ -195,6 +257,7 @@ bool Scratch::startScratchProject() {
 void Scratch::cleanupScratchProject() {
     cleanupSprites();
     Image::cleanupImages();
+    CollisionMask::keepColors = false;
     SoundPlayer::cleanupAudio();
     blockLookup.clear();
 
@@ -208,19 +271,11 @@ void Scratch::cleanupScratchProject() {
 
     // Clean up ZIP archive if it was initialized
     if (projectType != UNZIPPED) {
-
-        mz_zip_reader_end(&Unzip::zipArchive);
-        if (Unzip::trackedBufferPtr) {
-            MemoryTracker::deallocate(Unzip::trackedBufferPtr, Unzip::trackedBufferSize);
-            Unzip::trackedBufferPtr = nullptr;
-            Unzip::trackedBufferSize = 0;
-        }
-        Unzip::zipBuffer.clear();
-        Unzip::zipBuffer.shrink_to_fit();
-        memset(&Unzip::zipArchive, 0, sizeof(Unzip::zipArchive));
+        Unzip::closeArchive();
     }
 
 #ifdef ENABLE_CLOUDVARS
+    MemoryTracker::untrack(projectJSON.size());
     projectJSON.clear();
     projectJSON.shrink_to_fit();
 #endif
@@ -228,6 +283,9 @@ void Scratch::cleanupScratchProject() {
     // reset default settings
     Scratch::FPS = 30;
     Scratch::turbo = false;
+    Scratch::turboFrameBudget = 0.75f;
+    Scratch::ticksPerFrame = 0;
+    Scratch::warpTimeLimit = 500;
     Scratch::hqpen = false;
     Scratch::projectWidth = 480;
     Scratch::projectHeight = 360;
@@ -240,28 +298,50 @@ void Scratch::cleanupScratchProject() {
 }
 
 void initializeSpritePool(int poolSize) {
-    for (int i = 0; i < poolSize; i++) {
-        Sprite newSprite;
-        newSprite.id = Math::generateRandomString(15);
-        newSprite.isClone = true;
-        newSprite.toDelete = true;
-        newSprite.isDeleted = true;
-        spritePool.push_back(newSprite);
-    }
+    spritePoolLimit = poolSize;
 }
 
 Sprite *getAvailableSprite() {
-    for (Sprite &sprite : spritePool) {
-        if (sprite.isDeleted) {
-            sprite.isDeleted = false;
-            sprite.toDelete = false;
-            return &sprite;
+    if (freeSprites == nullptr) {
+        if (spritePoolSize >= spritePoolLimit) return nullptr;
+
+        // each chunk doubles the Pool, up to 256 Sprites at a time
+        const int chunkSize = std::min(spritePoolLimit - spritePoolSize, std::clamp(spritePoolSize, 16, 256));
+        spritePool.emplace_back(new Sprite[chunkSize]);
+        Sprite *chunk = spritePool.back().get();
+        for (int i = chunkSize - 1; i >= 0; i--) {
+            chunk[i].isClone = true;
+            chunk[i].toDelete = true;
+            chunk[i].isDeleted = true;
+            chunk[i].nextFree = freeSprites;
+            freeSprites = &chunk[i];
         }
+        spritePoolSize += chunkSize;
     }
-    return nullptr;
+
+    Sprite *sprite = freeSprites;
+    freeSprites = sprite->nextFree;
+    sprite->nextFree = nullptr;
+    sprite->isDeleted = false;
+    sprite->toDelete = false;
+    return sprite;
+}
+
+void releaseSprite(Sprite *sprite) {
+    // the slot's buffers are kept for the next Clone, but its values (and the strings and lists in them) aren't
+    sprite->variables.clear();
+    sprite->lists.clear();
+    sprite->customBlockArguments.clear();
+    sprite->threads.clear();
+    sprite->isDeleted = true;
+    sprite->nextFree = freeSprites;
+    freeSprites = sprite;
 }
 
 void cleanupSprites() {
+#ifdef ENABLE_PROFILER
+    Profiler::forgetSprites();
+#endif
     for (Sprite *sprite : sprites) {
         if (sprite) {
             if (sprite->isClone) {
@@ -271,14 +351,36 @@ void cleanupSprites() {
         }
     }
     sprites.clear();
+    Layers::clear();
     spritePool.clear();
+    freeSprites = nullptr;
+    spritePoolSize = 0;
+    SpatialHash::invalidate();
+    stageSprite = nullptr;
+    BlockExecutor::clearHats();
 }
 
-std::vector<std::pair<double, double>> getCollisionPoints(Sprite *currentSprite) {
-    std::vector<std::pair<double, double>> collisionPoints;
+const CollisionPoints &getCollisionPoints(Sprite *currentSprite) {
+    CollisionBox &box = currentSprite->collisionBox;
+    if (currentSprite->currentCostume == box.oldCostumeID && currentSprite->xPosition == box.oldX && currentSprite->yPosition == box.oldY &&
+        currentSprite->size == box.oldSize && currentSprite->rotation == box.oldRotation && currentSprite->rotationStyle == box.oldRotationStyle &&
+        currentSprite->spriteWidth == box.oldWidth && currentSprite->spriteHeight == box.oldHeight &&
+        currentSprite->rotationCenterX == box.oldRotationCenterX && currentSprite->rotationCenterY == box.oldRotationCenterY) {
+        return box.points;
+    }
+    box.oldCostumeID = currentSprite->currentCostume;
+    box.oldX = currentSprite->xPosition;
+    box.oldY = currentSprite->yPosition;
+    box.oldSize = currentSprite->size;
+    box.oldRotation = currentSprite->rotation;
+    box.oldRotationStyle = currentSprite->rotationStyle;
+    box.oldWidth = currentSprite->spriteWidth;
+    box.oldHeight = currentSprite->spriteHeight;
+    box.oldRotationCenterX = currentSprite->rotationCenterX;
+    box.oldRotationCenterY = currentSprite->rotationCenterY;
 
     double divisionAmount = 2.0;
-    const bool isSVG = currentSprite->costumes[currentSprite->currentCostume].isSVG;
+    const bool isSVG = currentSprite->data->costumes[currentSprite->currentCostume].isSVG;
 
     if (isSVG)
         divisionAmount = 1.0;
@@ -307,28 +409,29 @@ std::vector<std::pair<double, double>> getCollisionPoints(Sprite *currentSprite)
     double rotationCenterY = -((currentSprite->rotationCenterY - currentSprite->spriteHeight) >> shiftAmount);
 
     // Define the four corners relative to the sprite's center
-    std::vector<std::pair<double, double>> corners = {
+    const CollisionPoints corners = {{
         {-halfWidth - (rotationCenterX * currentSprite->size * 0.01), -halfHeight + (rotationCenterY)}, // Top-left
         {halfWidth - (rotationCenterX * currentSprite->size * 0.01), -halfHeight + (rotationCenterY)},  // Top-right
         {halfWidth - (rotationCenterX * currentSprite->size * 0.01), halfHeight + (rotationCenterY)},   // Bottom-right
         {-halfWidth - (rotationCenterX * currentSprite->size * 0.01), halfHeight + (rotationCenterY)}   // Bottom-left
-    };
+    }};
 
     // Rotate and translate each corner
-    for (const auto &corner : corners) {
-        double rotatedX = corner.first * cos(rotationRadians) - corner.second * sin(rotationRadians);
-        double rotatedY = corner.first * sin(rotationRadians) + corner.second * cos(rotationRadians);
-
-        collisionPoints.emplace_back(
-            currentSprite->xPosition + rotatedX,
-            currentSprite->yPosition + rotatedY);
+    const double rotationCos = cos(rotationRadians);
+    const double rotationSin = sin(rotationRadians);
+    for (size_t i = 0; i < corners.size(); i++) {
+        double rotatedX = corners[i].first * rotationCos - corners[i].second * rotationSin;
+        double rotatedY = corners[i].first * rotationSin + corners[i].second * rotationCos;
+
+        box.points[i] = {currentSprite->xPosition + rotatedX,
+                         currentSprite->yPosition + rotatedY};
     }
 
-    return collisionPoints;
+    return box.points;
 }
 
-bool isSeparated(const std::vector<std::pair<double, double>> &poly1,
-                 const std::vector<std::pair<double, double>> &poly2,
+bool isSeparated(const CollisionPoints &poly1,
+                 const CollisionPoints &poly2,
                  double axisX, double axisY) {
     double min1 = 1e9, max1 = -1e9;
     double min2 = 1e9, max2 = -1e9;
@@ -350,54 +453,65 @@ bool isSeparated(const std::vector<std::pair<double, double>> &poly1,
     return max1 < min2 || max2 < min1;
 }
 
-bool isColliding(std::string collisionType, Sprite *currentSprite, Sprite *targetSprite, std::string targetName) {
+// separating axis test between two boxes, using the edges of both as axes
+bool boxesOverlap(const CollisionPoints &box1, const CollisionPoints &box2) {
+    for (int i = 0; i < 4; i++) {
+        auto edge1 = std::pair{
+            box1[(i + 1) % 4].first - box1[i].first,
+            box1[(i + 1) % 4].second - box1[i].second};
+        auto edge2 = std::pair{
+            box2[(i + 1) % 4].first - box2[i].first,
+            box2[(i + 1) % 4].second - box2[i].second};
+
+        double axis1X = -edge1.second, axis1Y = edge1.first;
+        double axis2X = -edge2.second, axis2Y = edge2.first;
+
+        double len1 = sqrt(axis1X * axis1X + axis1Y * axis1Y);
+        double len2 = sqrt(axis2X * axis2X + axis2Y * axis2Y);
+        if (len1 > 0) {
+            axis1X /= len1;
+            axis1Y /= len1;
+        }
+        if (len2 > 0) {
+            axis2X /= len2;
+            axis2Y /= len2;
+        }
+
+        if (isSeparated(box1, box2, axis1X, axis1Y) ||
+            isSeparated(box1, box2, axis2X, axis2Y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const CollisionMask *getCostumeMask(Sprite *sprite) {
+    if (sprite->currentCostume < 0 || sprite->currentCostume >= static_cast<int>(sprite->data->costumes.size())) return nullptr;
+    return Image::getCollisionMask(sprite->data->costumes[sprite->currentCostume].id);
+}
+
+bool isColliding(const std::string &collisionType, Sprite *currentSprite, Sprite *targetSprite, const std::string &targetName) {
     // Get collision points of the current sprite
-    std::vector<std::pair<double, double>> currentSpritePoints = getCollisionPoints(currentSprite);
+    const CollisionPoints &currentSpritePoints = getCollisionPoints(currentSprite);
 
     if (collisionType == "mouse") {
         // Define a small square centered on the mouse pointer
         double halfWidth = 0.5;
         double halfHeight = 0.5;
 
-        std::vector<std::pair<double, double>> mousePoints = {
+        const CollisionPoints mousePoints = {{
             {Input::mousePointer.x - halfWidth, Input::mousePointer.y - halfHeight}, // Top-left
             {Input::mousePointer.x + halfWidth, Input::mousePointer.y - halfHeight}, // Top-right
             {Input::mousePointer.x + halfWidth, Input::mousePointer.y + halfHeight}, // Bottom-right
             {Input::mousePointer.x - halfWidth, Input::mousePointer.y + halfHeight}  // Bottom-left
-        };
-
-        bool collision = true;
-
-        for (int i = 0; i < 4; i++) {
-            auto edge1 = std::pair{
-                currentSpritePoints[(i + 1) % 4].first - currentSpritePoints[i].first,
-                currentSpritePoints[(i + 1) % 4].second - currentSpritePoints[i].second};
-            auto edge2 = std::pair{
-                mousePoints[(i + 1) % 4].first - mousePoints[i].first,
-                mousePoints[(i + 1) % 4].second - mousePoints[i].second};
-
-            double axis1X = -edge1.second, axis1Y = edge1.first;
-            double axis2X = -edge2.second, axis2Y = edge2.first;
-
-            double len1 = sqrt(axis1X * axis1X + axis1Y * axis1Y);
-            double len2 = sqrt(axis2X * axis2X + axis2Y * axis2Y);
-            if (len1 > 0) {
-                axis1X /= len1;
-                axis1Y /= len1;
-            }
-            if (len2 > 0) {
-                axis2X /= len2;
-                axis2Y /= len2;
-            }
+        }};
 
-            if (isSeparated(currentSpritePoints, mousePoints, axis1X, axis1Y) ||
-                isSeparated(currentSpritePoints, mousePoints, axis2X, axis2Y)) {
-                collision = false;
-                break;
-            }
-        }
+        if (!boxesOverlap(currentSpritePoints, mousePoints)) return false;
 
-        return collision;
+        // Only count the costume's visible pixels, if they're known
+        const CollisionMask *mask = getCostumeMask(currentSprite);
+        if (mask == nullptr) return true;
+        return CollisionMask::touchingPoint(currentSprite, *mask, Input::mousePointer.x, Input::mousePointer.y);
     } else if (collisionType == "edge") {
         double halfWidth = Scratch::projectWidth / 2.0;
         double halfHeight = Scratch::projectHeight / 2.0;
@@ -423,53 +537,14 @@ bool isColliding(std::string collisionType, Sprite *currentSprite, Sprite *targe
             return false;
         }
 
-        std::vector<std::pair<double, double>> targetSpritePoints = getCollisionPoints(targetSprite);
-
-        // Check if any point of current sprite is inside target sprite
-        for (const auto &currentPoint : currentSpritePoints) {
-            double x = currentPoint.first;
-            double y = currentPoint.second;
-
-            // Ray casting to check if point is inside target sprite
-            int intersections = 0;
-            for (int i = 0; i < 4; i++) {
-                int j = (i + 1) % 4;
-                double x1 = targetSpritePoints[i].first, y1 = targetSpritePoints[i].second;
-                double x2 = targetSpritePoints[j].first, y2 = targetSpritePoints[j].second;
-
-                if (((y1 > y) != (y2 > y)) &&
-                    (x < (x2 - x1) * (y - y1) / (y2 - y1) + x1)) {
-                    intersections++;
-                }
-            }
-
-            if ((intersections % 2) == 1) {
-                return true;
-            }
-        }
-
-        // Check if any point of target sprite is inside current sprite
-        for (const auto &targetPoint : targetSpritePoints) {
-            double x = targetPoint.first;
-            double y = targetPoint.second;
-
-            // Ray casting to check if point is inside current sprite
-            int intersections = 0;
-            for (int i = 0; i < 4; i++) {
-                int j = (i + 1) % 4;
-                double x1 = currentSpritePoints[i].first, y1 = currentSpritePoints[i].second;
-                double x2 = currentSpritePoints[j].first, y2 = currentSpritePoints[j].second;
-
-                if (((y1 > y) != (y2 > y)) &&
-                    (x < (x2 - x1) * (y - y1) / (y2 - y1) + x1)) {
-                    intersections++;
-                }
-            }
+        const CollisionPoints &targetSpritePoints = getCollisionPoints(targetSprite);
+        if (!boxesOverlap(currentSpritePoints, targetSpritePoints)) return false;
 
-            if ((intersections % 2) == 1) {
-                return true;
-            }
-        }
+        // The boxes overlap, so check the costumes' visible pixels, if they're known
+        const CollisionMask *currentMask = getCostumeMask(currentSprite);
+        const CollisionMask *targetMask = getCostumeMask(targetSprite);
+        if (currentMask == nullptr || targetMask == nullptr) return true;
+        return CollisionMask::touching(currentSprite, *currentMask, targetSprite, *targetMask);
     }
 
     return false;
@@ -511,342 +586,613 @@ void Scratch::sortSprites() {
                   if (!a->isStage && b->isStage) return true;
                   return a->layer > b->layer;
               });
-}
 
-void loadSprites(const nlohmann::json &json) {
-    Log::log("beginning to load sprites...");
-    sprites.reserve(400);
-    for (const auto &target : json["targets"]) { // "target" is sprite in Scratch speak, so for every sprite in sprites
+    // from here on the order is kept by `Layers`, which relabels `layer`
+    Layers::clear();
+    for (auto it = sprites.rbegin(); it != sprites.rend(); ++it) {
+        if (!(*it)->isStage) Layers::addToFront(*it);
+    }
+    Layers::updateSprites();
+}
 
-        // Sprite *newSprite = MemoryTracker::allocate<Sprite>();
-        Sprite *newSprite = new Sprite();
-        // new (newSprite) Sprite();
-        if (target.contains("name")) {
-            newSprite->name = target["name"].get<std::string>();
-        }
-        newSprite->id = Math::generateRandomString(15);
-        if (target.contains("isStage")) {
-            newSprite->isStage = target["isStage"].get<bool>();
-        }
-        if (target.contains("draggable")) {
-            newSprite->draggable = target["draggable"].get<bool>();
-        }
-        if (target.contains("visible")) {
-            newSprite->visible = target["visible"].get<bool>();
-        } else newSprite->visible = true;
-        if (target.contains("currentCostume")) {
-            newSprite->currentCostume = target["currentCostume"].get<int>();
-        }
-        if (target.contains("volume")) {
-            newSprite->volume = target["volume"].get<int>();
-        }
-        if (target.contains("x")) {
-            newSprite->xPosition = target["x"].get<int>();
-        }
-        if (target.contains("y")) {
-            newSprite->yPosition = target["y"].get<int>();
-        }
-        if (target.contains("size")) {
-            newSprite->size = target["size"].get<int>();
-        } else newSprite->size = 100;
-        if (target.contains("direction")) {
-            newSprite->rotation = target["direction"].get<int>();
-        } else newSprite->rotation = 90;
-        if (target.contains("layerOrder")) {
-            newSprite->layer = target["layerOrder"].get<int>();
-        } else newSprite->layer = 0;
-        if (target.contains("rotationStyle")) {
-            if (target["rotationStyle"].get<std::string>() == "all around")
-                newSprite->rotationStyle = newSprite->ALL_AROUND;
-            else if (target["rotationStyle"].get<std::string>() == "left-right")
-                newSprite->rotationStyle = newSprite->LEFT_RIGHT;
-            else
-                newSprite->rotationStyle = newSprite->NONE;
-        }
-        newSprite->toDelete = false;
-        newSprite->isClone = false;
-        // std::cout<<"name = "<< newSprite.name << std::endl;
+namespace {
+
+// a block from project.json, along with the custom block it declares if it's a prototype
+struct LoadedBlock {
+    Block block;
+    bool declaresCustomBlock = false;
+    CustomBlock customBlock;
+};
+
+Sprite *newLoadedSprite() {
+    // Sprite *newSprite = MemoryTracker::allocate<Sprite>();
+    Sprite *newSprite = new Sprite();
+    // new (newSprite) Sprite();
+    newSprite->data = std::make_shared<SpriteData>();
+    newSprite->id = Math::generateRandomString(15);
+    newSprite->visible = true;
+    newSprite->size = 100;
+    newSprite->rotation = 90;
+    newSprite->layer = 0;
+    newSprite->toDelete = false;
+    newSprite->isClone = false;
+    return newSprite;
+}
 
-        // set variables
-        for (const auto &[id, data] : target["variables"].items()) {
+void setSpriteProperty(Sprite *sprite, const std::string &key, const nlohmann::json &value) {
+    if (key == "name") {
+        sprite->name = value.get<std::string>();
+    } else if (key == "isStage") {
+        sprite->isStage = value.get<bool>();
+        if (sprite->isStage) stageSprite = sprite;
+    } else if (key == "draggable") {
+        sprite->draggable = value.get<bool>();
+    } else if (key == "visible") {
+        sprite->visible = value.get<bool>();
+    } else if (key == "currentCostume") {
+        sprite->currentCostume = value.get<int>();
+    } else if (key == "volume") {
+        sprite->volume = value.get<int>();
+    } else if (key == "x") {
+        sprite->xPosition = value.get<int>();
+    } else if (key == "y") {
+        sprite->yPosition = value.get<int>();
+    } else if (key == "size") {
+        sprite->size = value.get<int>();
+    } else if (key == "direction") {
+        sprite->rotation = value.get<int>();
+    } else if (key == "layerOrder") {
+        sprite->layer = value.get<int>();
+    } else if (key == "rotationStyle") {
+        if (value.get<std::string>() == "all around")
+            sprite->rotationStyle = sprite->ALL_AROUND;
+        else if (value.get<std::string>() == "left-right")
+            sprite->rotationStyle = sprite->LEFT_RIGHT;
+        else
+            sprite->rotationStyle = sprite->NONE;
+    }
+}
 
-            Variable newVariable;
-            newVariable.id = id;
-            newVariable.name = data[0];
-            newVariable.value = Value::fromJson(data[1]);
+Variable parseVariable(const std::string &id, const nlohmann::json &data) {
+    Variable newVariable;
+    newVariable.id = id;
+    newVariable.name = data[0];
+    newVariable.value = Value::fromJson(data[1]);
 #ifdef ENABLE_CLOUDVARS
-            newVariable.cloud = data.size() == 3;
-            cloudProject = cloudProject || newVariable.cloud;
+    newVariable.cloud = data.size() == 3;
+    cloudProject = cloudProject || newVariable.cloud;
 #endif
-            newSprite->variables[newVariable.id] = newVariable; // add variable to sprite
-        }
-
-        // set Blocks
-        for (const auto &[id, data] : target["blocks"].items()) {
+    return newVariable;
+}
 
-            Block newBlock;
-            newBlock.id = id;
-            if (data.contains("opcode")) {
-                newBlock.opcode = data["opcode"].get<std::string>();
+void addVariable(Sprite *sprite, Variable &&variable) {
+    auto slot = sprite->data->variableSlots.try_emplace(variable.id, static_cast<uint32_t>(sprite->variables.size()));
+    if (slot.second) sprite->variables.push_back(std::move(variable));
+    else sprite->variables[slot.first->second] = std::move(variable);
+}
 
-                if (newBlock.opcode == "event_whenthisspriteclicked") newSprite->shouldDoSpriteClick = true;
-            }
-            if (data.contains("next") && !data["next"].is_null()) {
-                newBlock.next = data["next"].get<std::string>();
-            }
-            if (data.contains("parent") && !data["parent"].is_null()) {
-                newBlock.parent = data["parent"].get<std::string>();
-            } else newBlock.parent = "null";
-            if (data.contains("fields")) {
-                for (const auto &[fieldName, fieldData] : data["fields"].items()) {
-                    ParsedField parsedField;
-
-                    // Fields are almost always arrays with [0] being the value
-                    if (fieldData.is_array() && !fieldData.empty()) {
-                        parsedField.value = fieldData[0].get<std::string>();
-
-                        // Store ID for variables and lists
-                        if (fieldData.size() > 1 && !fieldData[1].is_null()) {
-                            parsedField.id = fieldData[1].get<std::string>();
-                        }
-                    }
+LoadedBlock parseBlock(Sprite *sprite, const std::string &id, const nlohmann::json &data) {
+    LoadedBlock loaded;
+    Block &newBlock = loaded.block;
+    newBlock.id = id;
+    if (data.contains("opcode")) {
+        newBlock.opcode = data["opcode"].get<std::string>();
+        newBlock.opcodeId = Opcodes::fromString(newBlock.opcode);
 
-                    (*newBlock.parsedFields)[fieldName] = parsedField;
+        if (newBlock.opcodeId == Opcode::EVENT_WHENTHISSPRITECLICKED) sprite->shouldDoSpriteClick = true;
+        if (newBlock.opcodeId == Opcode::SENSING_TOUCHINGCOLOR || newBlock.opcodeId == Opcode::SENSING_COLORISTOUCHINGCOLOR) CollisionMask::keepColors = true;
+    }
+    if (data.contains("next") && !data["next"].is_null()) {
+        newBlock.next = data["next"].get<std::string>();
+    }
+    if (data.contains("parent") && !data["parent"].is_null()) {
+        newBlock.parent = data["parent"].get<std::string>();
+    } else newBlock.parent = "null";
+    if (data.contains("fields")) {
+        for (const auto &[fieldName, fieldData] : data["fields"].items()) {
+            ParsedField parsedField;
+
+            // Fields are almost always arrays with [0] being the value
+            if (fieldData.is_array() && !fieldData.empty()) {
+                parsedField.value = fieldData[0].get<std::string>();
+
+                // Store ID for variables and lists
+                if (fieldData.size() > 1 && !fieldData[1].is_null()) {
+                    parsedField.id = fieldData[1].get<std::string>();
                 }
             }
-            if (data.contains("inputs")) {
-
-                for (const auto &[inputName, inputData] : data["inputs"].items()) {
-                    ParsedInput parsedInput;
-
-                    int type = inputData[0];
-                    auto &inputValue = inputData[1];
-
-                    if (type == 1) {
-                        parsedInput.inputType = ParsedInput::LITERAL;
-                        parsedInput.literalValue = Value::fromJson(inputValue);
-
-                    } else if (type == 3) {
-                        if (inputValue.is_array()) {
-                            parsedInput.inputType = ParsedInput::VARIABLE;
-                            parsedInput.variableId = inputValue[2].get<std::string>();
-                        } else {
-                            parsedInput.inputType = ParsedInput::BLOCK;
-                            if (!inputValue.is_null())
-                                parsedInput.blockId = inputValue.get<std::string>();
-                        }
-                    } else if (type == 2) {
-                        if (inputValue.is_array()) {
-                            parsedInput.inputType = ParsedInput::VARIABLE;
-                            parsedInput.variableId = inputValue[2].get<std::string>();
-                        } else {
-                            parsedInput.inputType = ParsedInput::BLOCK;
-                            if (!inputValue.is_null())
-                                parsedInput.blockId = inputValue.get<std::string>();
-                        }
-                    }
-                    (*newBlock.parsedInputs)[inputName] = parsedInput;
+
+            (*newBlock.parsedFields)[fieldName] = parsedField;
+        }
+    }
+    if (data.contains("inputs")) {
+
+        for (const auto &[inputName, inputData] : data["inputs"].items()) {
+            ParsedInput parsedInput;
+
+            int type = inputData[0];
+            auto &inputValue = inputData[1];
+
+            if (type == 1) {
+                parsedInput.inputType = ParsedInput::LITERAL;
+                parsedInput.literalValue = Value::fromJson(inputValue);
+                if (parsedInput.literalValue.isString()) parsedInput.literalValue = Value::intern(parsedInput.literalValue.stringView());
+
+            } else if (type == 3) {
+                if (inputValue.is_array()) {
+                    parsedInput.inputType = ParsedInput::VARIABLE;
+                    parsedInput.variableId = inputValue[2].get<std::string>();
+                } else {
+                    parsedInput.inputType = ParsedInput::BLOCK;
+                    if (!inputValue.is_null())
+                        parsedInput.blockId = inputValue.get<std::string>();
                 }
-            }
-            if (data.contains("topLevel")) {
-                newBlock.topLevel = data["topLevel"].get<bool>();
-            }
-            if (data.contains("shadow")) {
-                newBlock.shadow = data["shadow"].get<bool>();
-            }
-            if (data.contains("mutation")) {
-                if (data["mutation"].contains("proccode")) {
-                    newBlock.customBlockId = data["mutation"]["proccode"].get<std::string>();
+            } else if (type == 2) {
+                if (inputValue.is_array()) {
+                    parsedInput.inputType = ParsedInput::VARIABLE;
+                    parsedInput.variableId = inputValue[2].get<std::string>();
                 } else {
-                    newBlock.customBlockId = "";
+                    parsedInput.inputType = ParsedInput::BLOCK;
+                    if (!inputValue.is_null())
+                        parsedInput.blockId = inputValue.get<std::string>();
                 }
             }
-            newSprite->blocks[newBlock.id] = newBlock; // add block
-
-            // add custom function blocks
-            if (newBlock.opcode == "procedures_prototype") {
-                if (!data.is_array()) {
-                    CustomBlock newCustomBlock;
-                    newCustomBlock.name = data["mutation"]["proccode"];
-                    newCustomBlock.blockId = newBlock.id;
-
-                    // custom blocks uses a different json structure for some reason?? have to parse them.
-                    std::string rawArgumentNames = data["mutation"]["argumentnames"];
-                    nlohmann::json parsedAN = nlohmann::json::parse(rawArgumentNames);
-                    newCustomBlock.argumentNames = parsedAN.get<std::vector<std::string>>();
-
-                    std::string rawArgumentDefaults = data["mutation"]["argumentdefaults"];
-                    nlohmann::json parsedAD = nlohmann::json::parse(rawArgumentDefaults);
-                    // newCustomBlock.argumentDefaults = parsedAD.get<std::vector<std::string>>();
-
-                    for (const auto &item : parsedAD) {
-                        if (item.is_string()) {
-                            newCustomBlock.argumentDefaults.push_back(item.get<std::string>());
-                        } else if (item.is_number_integer()) {
-                            newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<int>()));
-                        } else if (item.is_number_float()) {
-                            newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<double>()));
-                        } else {
-                            newCustomBlock.argumentDefaults.push_back(item.dump());
-                        }
-                    }
-
-                    std::string rawArgumentIds = data["mutation"]["argumentids"];
-                    nlohmann::json parsedAID = nlohmann::json::parse(rawArgumentIds);
-                    newCustomBlock.argumentIds = parsedAID.get<std::vector<std::string>>();
-
-                    if (data["mutation"]["warp"] == "true") {
-                        newCustomBlock.runWithoutScreenRefresh = true;
-                    } else newCustomBlock.runWithoutScreenRefresh = false;
+            (*newBlock.parsedInputs)[inputName] = parsedInput;
+        }
+    }
+    if (data.contains("topLevel")) {
+        newBlock.topLevel = data["topLevel"].get<bool>();
+    }
+    if (data.contains("shadow")) {
+        newBlock.shadow = data["shadow"].get<bool>();
+    }
+    if (data.contains("mutation")) {
+        if (data["mutation"].contains("proccode")) {
+            newBlock.customBlockId = data["mutation"]["proccode"].get<std::string>();
+        } else {
+            newBlock.customBlockId = "";
+        }
+    }
 
-                    newSprite->customBlocks[newCustomBlock.name] = newCustomBlock; // add custom block
+    // custom function blocks
+    if (newBlock.opcodeId == Opcode::PROCEDURES_PROTOTYPE) {
+        if (!data.is_array()) {
+            CustomBlock &newCustomBlock = loaded.customBlock;
+            loaded.declaresCustomBlock = true;
+            newCustomBlock.name = data["mutation"]["proccode"];
+            newCustomBlock.blockId = newBlock.id;
+
+            // custom blocks uses a different json structure for some reason?? have to parse them.
+            std::string rawArgumentNames = data["mutation"]["argumentnames"];
+            nlohmann::json parsedAN = nlohmann::json::parse(rawArgumentNames);
+            newCustomBlock.argumentNames = parsedAN.get<std::vector<std::string>>();
+
+            std::string rawArgumentDefaults = data["mutation"]["argumentdefaults"];
+            nlohmann::json parsedAD = nlohmann::json::parse(rawArgumentDefaults);
+            // newCustomBlock.argumentDefaults = parsedAD.get<std::vector<std::string>>();
+
+            for (const auto &item : parsedAD) {
+                if (item.is_string()) {
+                    newCustomBlock.argumentDefaults.push_back(item.get<std::string>());
+                } else if (item.is_number_integer()) {
+                    newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<int>()));
+                } else if (item.is_number_float()) {
+                    newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<double>()));
                 } else {
-                    Log::logError("Unknown Custom block data: " + data.dump()); // TODO handle these
+                    newCustomBlock.argumentDefaults.push_back(item.dump());
                 }
             }
-        }
 
-        // set Lists
-        for (const auto &[id, data] : target["lists"].items()) {
-            auto result = newSprite->lists.try_emplace(id).first;
-            List &newList = result->second;
-            newList.id = id;
-            newList.name = data[0];
-            newList.items.reserve(data[1].size());
-            for (const auto &listItem : data[1])
-                newList.items.push_back(Value::fromJson(listItem));
-        }
+            std::string rawArgumentIds = data["mutation"]["argumentids"];
+            nlohmann::json parsedAID = nlohmann::json::parse(rawArgumentIds);
+            newCustomBlock.argumentIds = parsedAID.get<std::vector<std::string>>();
 
-        // set Sounds
-        for (const auto &[id, data] : target["sounds"].items()) {
-            Sound newSound;
-            newSound.id = data["assetId"];
-            newSound.name = data["name"];
-            newSound.fullName = data["md5ext"];
-            newSound.dataFormat = data["dataFormat"];
-            newSound.sampleRate = data["rate"];
-            newSound.sampleCount = data["sampleCount"];
-            newSprite->sounds[newSound.name] = newSound;
+            if (data["mutation"]["warp"] == "true") {
+                newCustomBlock.runWithoutScreenRefresh = true;
+            } else newCustomBlock.runWithoutScreenRefresh = false;
+        } else {
+            Log::logError("Unknown Custom block data: " + data.dump()); // TODO handle these
         }
+    }
+    return loaded;
+}
 
-        // set Costumes
-        for (const auto &[id, data] : target["costumes"].items()) {
-            Costume newCostume;
-            newCostume.id = data["assetId"];
-            if (data.contains("name")) {
-                newCostume.name = data["name"];
-            }
-            if (data.contains("bitmapResolution")) {
-                newCostume.bitmapResolution = data["bitmapResolution"];
-            }
-            if (data.contains("dataFormat")) {
-                newCostume.dataFormat = data["dataFormat"];
-                if (newCostume.dataFormat == "svg" || newCostume.dataFormat == "SVG")
-                    newCostume.isSVG = true;
-                else
-                    newCostume.isSVG = false;
-            }
-            if (data.contains("md5ext")) {
-                newCostume.fullName = data["md5ext"];
-            }
-            if (data.contains("rotationCenterX")) {
-                newCostume.rotationCenterX = data["rotationCenterX"];
-            }
-            if (data.contains("rotationCenterY")) {
-                newCostume.rotationCenterY = data["rotationCenterY"];
-            }
-            newSprite->costumes.push_back(newCostume);
-        }
+void addBlock(Sprite *sprite, LoadedBlock &&loaded) {
+    if (loaded.declaresCustomBlock) {
+        std::string name = loaded.customBlock.name;
+        sprite->data->customBlocks[name] = std::move(loaded.customBlock); // add custom block
+    }
+    std::string id = loaded.block.id;
+    sprite->data->blocks[id] = std::move(loaded.block); // add block
+}
 
-        // set comments
-        for (const auto &[id, data] : target["comments"].items()) {
-            Comment newComment;
-            newComment.id = id;
-            if (data.contains("blockId") && !data["blockId"].is_null()) {
-                newComment.blockId = data["blockId"];
-            }
-            newComment.width = data["width"];
-            newComment.height = data["height"];
-            newComment.minimized = data["minimized"];
-            newComment.x = data["x"];
-            newComment.y = data["y"];
-            newComment.text = data["text"];
-            newSprite->comments[newComment.id] = newComment;
-        }
+List parseList(const std::string &id, const nlohmann::json &data) {
+    List newList;
+    newList.id = id;
+    newList.name = data[0];
+    newList.items.reserve(data[1].size());
+    for (const auto &listItem : data[1])
+        newList.items.push_back(Value::fromJson(listItem));
+    return newList;
+}
 
-        // set Broadcasts
-        for (const auto &[id, data] : target["broadcasts"].items()) {
-            Broadcast newBroadcast;
-            newBroadcast.id = id;
-            newBroadcast.name = data;
-            newSprite->broadcasts[newBroadcast.id] = newBroadcast;
-            // std::cout<<"broadcast name = "<< newBroadcast.name << std::endl;
-        }
+void addList(Sprite *sprite, List &&list) {
+    auto slot = sprite->data->listSlots.try_emplace(list.id, static_cast<uint32_t>(sprite->lists.size()));
+    if (slot.second) sprite->lists.push_back(std::move(list));
+    else sprite->lists[slot.first->second] = std::move(list);
+}
 
-        sprites.push_back(newSprite);
+void addSound(Sprite *sprite, const nlohmann::json &data) {
+    Sound newSound;
+    newSound.id = data["assetId"];
+    newSound.name = data["name"];
+    newSound.fullName = data["md5ext"];
+    newSound.dataFormat = data["dataFormat"];
+    newSound.sampleRate = data["rate"];
+    newSound.sampleCount = data["sampleCount"];
+    sprite->data->sounds[newSound.name] = newSound;
+}
+
+void addCostume(Sprite *sprite, const nlohmann::json &data) {
+    Costume newCostume;
+    newCostume.id = data["assetId"];
+    if (data.contains("name")) {
+        newCostume.name = data["name"];
+    }
+    if (data.contains("bitmapResolution")) {
+        newCostume.bitmapResolution = data["bitmapResolution"];
     }
+    if (data.contains("dataFormat")) {
+        newCostume.dataFormat = data["dataFormat"];
+        if (newCostume.dataFormat == "svg" || newCostume.dataFormat == "SVG")
+            newCostume.isSVG = true;
+        else
+            newCostume.isSVG = false;
+    }
+    if (data.contains("md5ext")) {
+        newCostume.fullName = data["md5ext"];
+    }
+    if (data.contains("rotationCenterX")) {
+        newCostume.rotationCenterX = data["rotationCenterX"];
+    }
+    if (data.contains("rotationCenterY")) {
+        newCostume.rotationCenterY = data["rotationCenterY"];
+    }
+    sprite->data->costumes.push_back(newCostume);
+}
 
-    Scratch::sortSprites();
+Comment parseComment(const std::string &id, const nlohmann::json &data) {
+    Comment newComment;
+    newComment.id = id;
+    if (data.contains("blockId") && !data["blockId"].is_null()) {
+        newComment.blockId = data["blockId"];
+    }
+    newComment.width = data["width"];
+    newComment.height = data["height"];
+    newComment.minimized = data["minimized"];
+    newComment.x = data["x"];
+    newComment.y = data["y"];
+    newComment.text = data["text"];
+    return newComment;
+}
 
-    for (const auto &monitor : json["monitors"]) { // "monitor" is any variable shown on screen
-        Monitor newMonitor;
+void addComment(Sprite *sprite, Comment &&comment) {
+    std::string id = comment.id;
+    sprite->data->comments[id] = std::move(comment);
+}
 
-        if (monitor.contains("id") && !monitor["id"].is_null())
-            newMonitor.id = monitor.at("id").get<std::string>();
+void addBroadcast(Sprite *sprite, const std::string &id, const nlohmann::json &data) {
+    Broadcast newBroadcast;
+    newBroadcast.id = id;
+    newBroadcast.name = data;
+    sprite->data->broadcasts[newBroadcast.id] = newBroadcast;
+}
 
-        if (monitor.contains("mode") && !monitor["mode"].is_null())
-            newMonitor.mode = monitor.at("mode").get<std::string>();
+void addMonitor(const nlohmann::json &monitor) {
+    Monitor newMonitor;
 
-        if (monitor.contains("opcode") && !monitor["opcode"].is_null())
-            newMonitor.opcode = monitor.at("opcode").get<std::string>();
+    if (monitor.contains("id") && !monitor["id"].is_null())
+        newMonitor.id = monitor.at("id").get<std::string>();
 
-        if (monitor.contains("params") && monitor["params"].is_object()) {
-            for (const auto &param : monitor["params"].items()) {
-                std::string key = param.key();
-                std::string value = param.value().dump();
-                newMonitor.parameters[key] = value;
-            }
+    if (monitor.contains("mode") && !monitor["mode"].is_null())
+        newMonitor.mode = monitor.at("mode").get<std::string>();
+
+    if (monitor.contains("opcode") && !monitor["opcode"].is_null()) {
+        newMonitor.opcode = monitor.at("opcode").get<std::string>();
+        newMonitor.opcodeId = Opcodes::fromString(newMonitor.opcode);
+    }
+
+    if (monitor.contains("params") && monitor["params"].is_object()) {
+        for (const auto &param : monitor["params"].items()) {
+            std::string key = param.key();
+            std::string value = param.value().dump();
+            newMonitor.parameters[key] = value;
         }
+    }
 
-        if (monitor.contains("spriteName") && !monitor["spriteName"].is_null())
-            newMonitor.spriteName = monitor.at("spriteName").get<std::string>();
-        else
-            newMonitor.spriteName = "";
+    if (monitor.contains("spriteName") && !monitor["spriteName"].is_null())
+        newMonitor.spriteName = monitor.at("spriteName").get<std::string>();
+    else
+        newMonitor.spriteName = "";
+
+    if (monitor.contains("value") && !monitor["value"].is_null())
+        newMonitor.value = Value(Math::removeQuotations(monitor.at("value").dump()));
+
+    if (monitor.contains("x") && !monitor["x"].is_null())
+        newMonitor.x = monitor.at("x").get<int>();
+
+    if (monitor.contains("y") && !monitor["y"].is_null())
+        newMonitor.y = monitor.at("y").get<int>();
+
+    if (monitor.contains("visible") && !monitor["visible"].is_null())
+        newMonitor.visible = monitor.at("visible").get<bool>();
+
+    if (monitor.contains("isDiscrete") && !monitor["isDiscrete"].is_null())
+        newMonitor.isDiscrete = monitor.at("isDiscrete").get<bool>();
+
+    if (monitor.contains("sliderMin") && !monitor["sliderMin"].is_null())
+        newMonitor.sliderMin = monitor.at("sliderMin").get<double>();
+
+    if (monitor.contains("sliderMax") && !monitor["sliderMax"].is_null())
+        newMonitor.sliderMax = monitor.at("sliderMax").get<double>();
 
-        if (monitor.contains("value") && !monitor["value"].is_null())
-            newMonitor.value = Value(Math::removeQuotations(monitor.at("value").dump()));
+    Render::visibleVariables.push_back(newMonitor);
+}
+
+/**
+ * Builds a small json value out of SAX events, for the parts of project.json
+ * (a single block, costume, monitor...) that are easier to read as a tree.
+ */
+class JsonCapture {
+  public:
+    bool active() const { return !open.empty(); }
+
+    void begin(nlohmann::json &&container) {
+        root = std::move(container);
+        open.assign(1, &root);
+    }
+
+    void key(std::string &&name) { pendingKey = std::move(name); }
+
+    void value(nlohmann::json &&value) { insert(std::move(value)); }
+
+    void openContainer(nlohmann::json &&container) { open.push_back(insert(std::move(container))); }
+
+    // returns `true` once the captured value is complete
+    bool closeContainer() {
+        open.pop_back();
+        return open.empty();
+    }
 
-        if (monitor.contains("x") && !monitor["x"].is_null())
-            newMonitor.x = monitor.at("x").get<int>();
+    nlohmann::json root;
 
-        if (monitor.contains("y") && !monitor["y"].is_null())
-            newMonitor.y = monitor.at("y").get<int>();
+  private:
+    nlohmann::json *insert(nlohmann::json &&value) {
+        nlohmann::json &parent = *open.back();
+        if (parent.is_object()) return &(parent[pendingKey] = std::move(value));
+        parent.push_back(std::move(value));
+        return &parent.back();
+    }
+
+    std::vector<nlohmann::json *> open;
+    std::string pendingKey;
+};
+
+/**
+ * Loads sprites straight from project.json's SAX events, so the whole file is never held as a json tree.
+ * Scalar sprite properties and list items are read as they arrive, and everything else is read one item
+ * (block, variable, costume...) at a time.
+ * Keyed items are inserted sorted by id once their sprite is done, the same order a parsed json object
+ * iterates in, so sprites come out exactly as they would from `loadSprites()`.
+ */
+class SpriteLoader : public nlohmann::json_sax<nlohmann::json> {
+  public:
+    ~SpriteLoader() override { delete sprite; }
+
+    bool null() override { return scalar(nullptr); }
+    bool boolean(bool val) override { return scalar(val); }
+    bool number_integer(number_integer_t val) override { return scalar(val); }
+    bool number_unsigned(number_unsigned_t val) override { return scalar(val); }
+    bool number_float(number_float_t val, const string_t &) override { return scalar(val); }
+    bool string(string_t &val) override { return scalar(std::move(val)); }
+    bool binary(binary_t &) override { return true; } // never in json text
+
+    bool start_object(std::size_t) override { return startContainer(nlohmann::json::object()); }
+    bool start_array(std::size_t) override { return startContainer(nlohmann::json::array()); }
+    bool end_object() override { return endContainer(); }
+    bool end_array() override { return endContainer(); }
+
+    bool key(string_t &val) override {
+        if (capture.active()) capture.key(std::move(val));
+        else if (depth == 1) {
+            inTargets = val == "targets";
+            inMonitors = val == "monitors";
+        }
+        else if (depth == 3 && sprite) targetKey = std::move(val);
+        else if (depth == 4 && section != Section::NONE) itemKey = std::move(val);
+        return true;
+    }
 
-        if (monitor.contains("visible") && !monitor["visible"].is_null())
-            newMonitor.visible = monitor.at("visible").get<bool>();
+    bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &ex) override {
+        Log::logError("Failed to parse project.json at byte " + std::to_string(position) + ": " + ex.what());
+        return false;
+    }
+
+  private:
+    enum class Section {
+        NONE,
+        VARIABLES,
+        BLOCKS,
+        LISTS,
+        SOUNDS,
+        COSTUMES,
+        COMMENTS,
+        BROADCASTS
+    };
 
-        if (monitor.contains("isDiscrete") && !monitor["isDiscrete"].is_null())
-            newMonitor.isDiscrete = monitor.at("isDiscrete").get<bool>();
+    static Section sectionFor(const std::string &key) {
+        if (key == "variables") return Section::VARIABLES;
+        if (key == "blocks") return Section::BLOCKS;
+        if (key == "lists") return Section::LISTS;
+        if (key == "sounds") return Section::SOUNDS;
+        if (key == "costumes") return Section::COSTUMES;
+        if (key == "comments") return Section::COMMENTS;
+        if (key == "broadcasts") return Section::BROADCASTS;
+        return Section::NONE;
+    }
 
-        if (monitor.contains("sliderMin") && !monitor["sliderMin"].is_null())
-            newMonitor.sliderMin = monitor.at("sliderMin").get<double>();
+    bool scalar(nlohmann::json &&value) {
+        if (capture.active()) {
+            capture.value(std::move(value));
+        } else if (depth == 3 && sprite) {
+            setSpriteProperty(sprite, targetKey, value);
+        } else if (depth == 4 && section == Section::BROADCASTS) {
+            broadcasts.emplace_back(itemKey, std::move(value));
+        } else if (depth == 5 && section == Section::LISTS) {
+            if (listIndex++ == 0) list.name = value;
+        } else if (depth == 6 && section == Section::LISTS && listIndex == 1) {
+            list.items.push_back(Value::fromJson(value));
+        }
+        return true;
+    }
 
-        if (monitor.contains("sliderMax") && !monitor["sliderMax"].is_null())
-            newMonitor.sliderMax = monitor.at("sliderMax").get<double>();
+    bool startContainer(nlohmann::json &&container) {
+        if (capture.active()) {
+            capture.openContainer(std::move(container));
+            return true;
+        }
+        const bool isArray = container.is_array();
+        if (depth == 2 && inTargets && !isArray) {
+            sprite = newLoadedSprite();
+        } else if (depth == 2 && inMonitors) {
+            capture.begin(std::move(container));
+            return true;
+        } else if (depth == 3 && sprite) {
+            section = sectionFor(targetKey);
+        } else if (depth == 4 && section == Section::LISTS && isArray) {
+            list = List();
+            list.id = itemKey;
+            listIndex = 0;
+        } else if ((depth == 4 && section != Section::NONE) || (depth == 6 && section == Section::LISTS && listIndex == 1)) {
+            capture.begin(std::move(container));
+            return true;
+        }
+        depth++;
+        return true;
+    }
 
-        Render::visibleVariables.push_back(newMonitor);
+    bool endContainer() {
+        if (capture.active()) {
+            if (capture.closeContainer()) captured();
+            return true;
+        }
+        depth--;
+        if (depth == 2 && sprite) {
+            finishSprite();
+        } else if (depth == 3 && sprite) {
+            section = Section::NONE;
+        } else if (depth == 4 && section == Section::LISTS) {
+            lists.push_back(std::move(list));
+        } else if (depth == 5 && section == Section::LISTS) {
+            listIndex++;
+        }
+        return true;
     }
 
+    void captured() {
+        nlohmann::json value = std::move(capture.root);
+        if (inMonitors) {
+            addMonitor(value);
+            return;
+        }
+        switch (section) {
+        case Section::VARIABLES:
+            variables.push_back(parseVariable(itemKey, value));
+            break;
+        case Section::BLOCKS:
+            blocks.push_back(parseBlock(sprite, itemKey, value));
+            break;
+        case Section::LISTS:
+            list.items.push_back(Value::fromJson(value));
+            break;
+        case Section::SOUNDS:
+            addSound(sprite, value);
+            break;
+        case Section::COSTUMES:
+            addCostume(sprite, value);
+            break;
+        case Section::COMMENTS:
+            comments.push_back(parseComment(itemKey, value));
+            break;
+        case Section::BROADCASTS:
+            broadcasts.emplace_back(itemKey, std::move(value));
+            break;
+        default:
+            break;
+        }
+    }
+
+    void finishSprite() {
+        const auto byId = [](const auto &a, const auto &b) { return a.id < b.id; };
+        std::stable_sort(variables.begin(), variables.end(), byId);
+        std::stable_sort(blocks.begin(), blocks.end(), [](const LoadedBlock &a, const LoadedBlock &b) { return a.block.id < b.block.id; });
+        std::stable_sort(lists.begin(), lists.end(), byId);
+        std::stable_sort(comments.begin(), comments.end(), byId);
+        std::stable_sort(broadcasts.begin(), broadcasts.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        for (Variable &variable : variables)
+            addVariable(sprite, std::move(variable));
+        for (LoadedBlock &block : blocks)
+            addBlock(sprite, std::move(block));
+        for (List &list : lists)
+            addList(sprite, std::move(list));
+        for (Comment &comment : comments)
+            addComment(sprite, std::move(comment));
+        for (const auto &[id, data] : broadcasts)
+            addBroadcast(sprite, id, data);
+        variables.clear();
+        blocks.clear();
+        lists.clear();
+        comments.clear();
+        broadcasts.clear();
+
+        sprites.push_back(sprite);
+        sprite = nullptr;
+    }
+
+    // how many objects and arrays outside of `capture` are open
+    int depth = 0;
+    bool inTargets = false;
+    bool inMonitors = false;
+    Section section = Section::NONE;
+    std::string targetKey;
+    std::string itemKey;
+    JsonCapture capture;
+
+    Sprite *sprite = nullptr;
+    List list;
+    int listIndex = 0;
+    std::vector<Variable> variables;
+    std::vector<LoadedBlock> blocks;
+    std::vector<List> lists;
+    std::vector<Comment> comments;
+    std::vector<std::pair<std::string, nlohmann::json>> broadcasts;
+};
+
+// sets up everything that needs every sprite to be read first: layers, block lookups, project settings and bytecode
+void finishLoadingSprites() {
+    Scratch::sortSprites();
+
     // load block lookup table
     blockLookup.clear();
     for (Sprite *sprite : sprites) {
-        for (auto &[id, block] : sprite->blocks) {
+        for (auto &[id, block] : sprite->data->blocks) {
             blockLookup[id] = &block;
         }
     }
     // setup top level blocks
     for (Sprite *currentSprite : sprites) {
-        for (auto &[id, block] : currentSprite->blocks) {
+        for (auto &[id, block] : currentSprite->data->blocks) {
             if (block.topLevel) continue;                           // skip top level blocks
             block.topLevelParentBlock = getBlockParent(&block)->id; // get parent block id
             // std::cout<<"block id = "<< block.topLevelParentBlock << std::endl;
@@ -857,7 +1203,7 @@ void loadSprites(const nlohmann::json &json) {
     nlohmann::json config;
     for (Sprite *currentSprite : sprites) {
         if (!currentSprite->isStage) continue;
-        for (auto &[id, comment] : currentSprite->comments) {
+        for (auto &[id, comment] : currentSprite->data->comments) {
             // make sure its the turbowarp comment
             std::size_t settingsFind = comment.text.find("Configuration for https");
             if (settingsFind == std::string::npos) continue;
@@ -927,6 +1273,18 @@ void loadSprites(const nlohmann::json &json) {
         Log::logWarning("no turbo property.");
 #endif
     }
+    // the project's settings file, read once for every setting in it
+    const nlohmann::json settings = Unzip::getSettings();
+    auto turboFrameBudget = settings.value("turboFrameBudget", nlohmann::json());
+    if (turboFrameBudget.is_number()) {
+        Scratch::turboFrameBudget = std::clamp(turboFrameBudget.get<float>(), 0.0f, 1.0f);
+        Log::log("Set turbo frame budget to: " + std::to_string(Scratch::turboFrameBudget));
+    }
+    auto warpTimeLimit = settings.value("warpTimeLimit", nlohmann::json());
+    if (warpTimeLimit.is_number()) {
+        Scratch::warpTimeLimit = std::max(0, warpTimeLimit.get<int>());
+        Log::log("Set warp time limit to: " + std::to_string(Scratch::warpTimeLimit));
+    }
     try {
         Scratch::hqpen = config["hq"].get<bool>();
         Log::log("Set hqpen mode to: " + std::to_string(Scratch::hqpen));
@@ -980,8 +1338,8 @@ void loadSprites(const nlohmann::json &json) {
     else if (Scratch::projectWidth == 320 && Scratch::projectHeight == 240)
         Render::renderMode = Render::BOTTOM_SCREEN_ONLY;
     else {
-        auto bottomScreen = Unzip::getSetting("bottomScreen");
-        if (!bottomScreen.is_null() && bottomScreen.get<bool>())
+        auto bottomScreen = settings.value("bottomScreen", nlohmann::json());
+        if (bottomScreen.is_boolean() && bottomScreen.get<bool>())
             Render::renderMode = Render::BOTTOM_SCREEN_ONLY;
         else
             Render::renderMode = Render::TOP_SCREEN_ONLY;
@@ -1011,23 +1369,10 @@ void loadSprites(const nlohmann::json &json) {
         }
     }
 
-    // get block chains for every block
+    // compile every script into bytecode
     for (Sprite *currentSprite : sprites) {
-        for (auto &[id, block] : currentSprite->blocks) {
-            if (!block.topLevel) continue;
-            std::string outID;
-            BlockChain chain;
-            chain.blockChain = getBlockChain(block.id, &outID);
-            currentSprite->blockChains[outID] = chain;
-            // std::cout << "ok = " << outID << std::endl;
-            block.blockChainID = outID;
-
-            for (auto &chainBlock : chain.blockChain) {
-                if (currentSprite->blocks.find(chainBlock->id) != currentSprite->blocks.end()) {
-                    currentSprite->blocks[chainBlock->id].blockChainID = outID;
-                }
-            }
-        }
+        Compiler::compileSprite(currentSprite);
+        BlockExecutor::addHats(currentSprite);
     }
 
     Unzip::loadingState = "Finishing up!";
@@ -1037,6 +1382,79 @@ void loadSprites(const nlohmann::json &json) {
     Log::log("Loaded " + std::to_string(sprites.size()) + " sprites.");
 }
 
+} // namespace
+
+void loadSprites(const nlohmann::json &json) {
+    Log::log("beginning to load sprites...");
+    sprites.reserve(400);
+    for (const auto &target : json["targets"]) { // "target" is sprite in Scratch speak, so for every sprite in sprites
+
+        Sprite *newSprite = newLoadedSprite();
+        for (const auto &[key, value] : target.items()) {
+            if (!value.is_structured()) setSpriteProperty(newSprite, key, value);
+        }
+        // std::cout<<"name = "<< newSprite.name << std::endl;
+
+        // set variables
+        for (const auto &[id, data] : target["variables"].items())
+            addVariable(newSprite, parseVariable(id, data));
+
+        // set Blocks
+        for (const auto &[id, data] : target["blocks"].items())
+            addBlock(newSprite, parseBlock(newSprite, id, data));
+
+        // set Lists
+        for (const auto &[id, data] : target["lists"].items())
+            addList(newSprite, parseList(id, data));
+
+        // set Sounds
+        for (const auto &[id, data] : target["sounds"].items())
+            addSound(newSprite, data);
+
+        // set Costumes
+        for (const auto &[id, data] : target["costumes"].items())
+            addCostume(newSprite, data);
+
+        // set comments
+        for (const auto &[id, data] : target["comments"].items())
+            addComment(newSprite, parseComment(id, data));
+
+        // set Broadcasts
+        for (const auto &[id, data] : target["broadcasts"].items())
+            addBroadcast(newSprite, id, data);
+
+        sprites.push_back(newSprite);
+    }
+
+    for (const auto &monitor : json["monitors"]) // "monitor" is any variable shown on screen
+        addMonitor(monitor);
+
+    finishLoadingSprites();
+}
+
+bool streamSprites(std::string_view json) {
+    Log::log("beginning to stream sprites...");
+    sprites.reserve(400);
+    SpriteLoader loader;
+    bool parsed;
+    try {
+        parsed = nlohmann::json::sax_parse(json.begin(), json.end(), &loader);
+    } catch (const std::exception &e) {
+        // valid json that isn't shaped like a project, like a string where a number should be
+        Log::logError(std::string("Failed to load project.json: ") + e.what());
+        parsed = false;
+    }
+    if (!parsed) {
+        // don't leave the sprites and monitors read before the error behind
+        cleanupSprites();
+        Render::visibleVariables.clear();
+        return false;
+    }
+
+    finishLoadingSprites();
+    return true;
+}
+
 Block *findBlock(std::string blockId) {
 
     auto block = blockLookup.find(blockId);
@@ -1047,46 +1465,6 @@ Block *findBlock(std::string blockId) {
     return nullptr;
 }
 
-std::vector<Block *> getBlockChain(std::string blockId, std::string *outID) {
-    std::vector<Block *> blockChain;
-    Block *currentBlock = findBlock(blockId);
-    while (currentBlock != nullptr) {
-        blockChain.push_back(currentBlock);
-        if (outID)
-            *outID += currentBlock->id;
-
-        auto substackIt = currentBlock->parsedInputs->find("SUBSTACK");
-        if (substackIt != currentBlock->parsedInputs->end() &&
-            (substackIt->second.inputType == ParsedInput::BOOLEAN || substackIt->second.inputType == ParsedInput::BLOCK) &&
-            !substackIt->second.blockId.empty()) {
-
-            std::vector<Block *> subBlockChain;
-            subBlockChain = getBlockChain(substackIt->second.blockId, outID);
-            for (auto &block : subBlockChain) {
-                blockChain.push_back(block);
-                if (outID)
-                    *outID += block->id;
-            }
-        }
-
-        auto substack2It = currentBlock->parsedInputs->find("SUBSTACK2");
-        if (substack2It != currentBlock->parsedInputs->end() &&
-            (substack2It->second.inputType == ParsedInput::BOOLEAN || substack2It->second.inputType == ParsedInput::BLOCK) &&
-            !substack2It->second.blockId.empty()) {
-
-            std::vector<Block *> subBlockChain;
-            subBlockChain = getBlockChain(substack2It->second.blockId, outID);
-            for (auto &block : subBlockChain) {
-                blockChain.push_back(block);
-                if (outID)
-                    *outID += block->id;
-            }
-        }
-        currentBlock = findBlock(currentBlock->next);
-    }
-    return blockChain;
-}
-
 Block *getBlockParent(const Block *block) {
     Block *parentBlock;
     const Block *currentBlock = block;
@@ -1115,13 +1493,13 @@ Value Scratch::getInputValue(Block &block, const std::string &inputName, Sprite
         return input.literalValue;
 
     case ParsedInput::VARIABLE:
-        return BlockExecutor::getVariableValue(input.variableId, sprite);
+        return BlockExecutor::getVariableValue(input.variable, sprite);
 
     case ParsedInput::BLOCK:
-        return executor.getBlockValue(*findBlock(input.blockId), sprite);
+        return executor.getBlockValue(input.block ? *input.block : *findBlock(input.blockId), sprite);
 
     case ParsedInput::BOOLEAN:
-        return executor.getBlockValue(*findBlock(input.blockId), sprite);
+        return executor.getBlockValue(input.block ? *input.block : *findBlock(input.blockId), sprite);
     }
     return Value();
 }
@@ -3,6 +3,7 @@
 #include "sprite.hpp"
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 #include <time.hpp>
 #include <unordered_map>
 #include <vector>
@@ -14,12 +15,13 @@ enum ProjectType {
 };
 
 class BlockExecutor;
+class CollisionMask;
 extern BlockExecutor executor;
 
 extern ProjectType projectType;
 
 extern std::vector<Sprite *> sprites;
-extern std::vector<Sprite> spritePool;
+extern Sprite *stageSprite;
 extern std::vector<std::string> broadcastQueue;
 extern std::unordered_map<std::string, Block *> blockLookup;
 extern bool toExit;
@@ -41,6 +43,12 @@ class Scratch {
     static int projectHeight;
     static int FPS;
     static bool turbo;
+    // share of each frame turbo mode keeps running ticks for, the rest is left for rendering
+    static float turboFrameBudget;
+    // ticks run between the last two renders
+    static int ticksPerFrame;
+    // milliseconds a script running without screen refresh may run before it has to wait a frame, or 0 for no limit
+    static int warpTimeLimit;
     static bool fencing;
     static bool hqpen;
     static bool miscellaneousLimits;
@@ -54,16 +62,24 @@ class Scratch {
 };
 
 /**
- * Gets the Sprite's box collision points.
+ * Gets the Sprite's box collision points. They're cached in `Sprite::collisionBox`,
+ * and only recomputed when the Sprite moved, turned, resized, or changed costume or rotation style.
  * @param sprite
  * @return Each point stored in a `std::pair`, where `[0]` is X, `[1]` is Y.
  */
-std::vector<std::pair<double, double>> getCollisionPoints(Sprite *currentSprite);
+const CollisionPoints &getCollisionPoints(Sprite *currentSprite);
 
-bool isColliding(std::string collisionType, Sprite *currentSprite, Sprite *targetSprite = nullptr, std::string targetName = "");
+/**
+ * Gets the collision mask of the Sprite's current costume.
+ * @param sprite
+ * @return The mask, or `nullptr` if the costume isn't loaded.
+ */
+const CollisionMask *getCostumeMask(Sprite *sprite);
+
+bool isColliding(const std::string &collisionType, Sprite *currentSprite, Sprite *targetSprite = nullptr, const std::string &targetName = "");
 
-bool isSeparated(const std::vector<std::pair<double, double>> &poly1,
-                 const std::vector<std::pair<double, double>> &poly2,
+bool isSeparated(const CollisionPoints &poly1,
+                 const CollisionPoints &poly2,
                  double axisX, double axisY);
 
 /**
@@ -72,6 +88,14 @@ bool isSeparated(const std::vector<std::pair<double, double>> &poly1,
  */
 void loadSprites(const nlohmann::json &json);
 
+/**
+ * Loads every Sprite straight from the text of a project.json file, without parsing the whole file into json first.
+ * Gives the same Sprites as `loadSprites()` while only keeping one block, costume etc. parsed at a time.
+ * @param json The text of the file to load
+ * @return `false` if the file couldn't be parsed or isn't a valid project.
+ */
+bool streamSprites(std::string_view json);
+
 /**
  * Frees every Sprite from memory.
  */
@@ -85,28 +109,28 @@ void cleanupSprites();
 Block *getBlockParent(const Block *block);
 
 /**
- * Initializes a Pool of `Sprite` variables to be used by Clones.
- * @param poolSize Amount of clones to initialize.
+ * Sets up the Pool of `Sprite` variables to be used by Clones.
+ * Nothing is allocated yet; the Pool grows in chunks as Clones are created.
+ * @param poolSize Most clones that can exist at once.
  */
 void initializeSpritePool(int poolSize);
 
 /**
- * Gets an available sprite from the `Sprite Pool`.
+ * Gets an available sprite from the `Sprite Pool`, growing it if every allocated one is in use.
  * @return A `Sprite*` if there is any, `nullptr` otherwise.
  */
 Sprite *getAvailableSprite();
 
+/**
+ * Gives a deleted Clone back to the `Sprite Pool`, so the next Clone can reuse it.
+ * Its variables, lists and running scripts are cleared right away, instead of staying in the Pool until then.
+ * @param sprite A Clone from `getAvailableSprite()`, already removed from `sprites`
+ */
+void releaseSprite(Sprite *sprite);
+
 /**
  * Finds a block from the `blockLookup`.
  * @param blockId ID of the block you need
  * @return A `Block*` if it's found, `nullptr` otherwise.
  */
 Block *findBlock(std::string blockId);
-
-/**
- * Gets a Chain of Blocks with a specified `blockId`.
- * @param blockId ID of the block you want the chain for.
- * @param outId a `std::string*` for if you want to get the ID of the chain. Can leave empty.
- * @return An `std::vector` of every `Block*` in the chain.
- */
-std::vector<Block *> getBlockChain(std::string blockId, std::string *outID = nullptr);
@@ -0,0 +1,140 @@
+#include "layers.hpp"
+#include "interpret.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+// room left between neighbouring labels whenever they're handed out again
+constexpr int64_t labelGap = 1 << 12;
+
+Sprite *front = nullptr;
+Sprite *back = nullptr;
+size_t count = 0;
+bool outOfOrder = false;
+uint64_t changes = 0;
+
+bool contains(Sprite *sprite) {
+    return sprite == front || sprite->layerAbove != nullptr;
+}
+
+// spreads the labels evenly around 0, leaving as much room as possible at both ends
+void relabel() {
+    const int64_t gap = std::max<int64_t>(1, std::min<int64_t>(labelGap, INT_MAX / (static_cast<int64_t>(count) + 1)));
+    int64_t label = -gap * (static_cast<int64_t>(count) / 2);
+    for (Sprite *sprite = back; sprite != nullptr; sprite = sprite->layerAbove, label += gap) {
+        sprite->layer = static_cast<int>(label);
+    }
+}
+
+// puts a Sprite between `above` and `below`, either of which may be nullptr at the front or back
+void link(Sprite *sprite, Sprite *above, Sprite *below) {
+    sprite->layerAbove = above;
+    sprite->layerBelow = below;
+    (above != nullptr ? above->layerBelow : front) = sprite;
+    (below != nullptr ? below->layerAbove : back) = sprite;
+    count++;
+    outOfOrder = true;
+    changes++;
+
+    // label it halfway between its neighbours, or relabel everything if there's no room left
+    const int64_t high = above != nullptr ? above->layer : (below != nullptr ? below->layer + 2 * labelGap : labelGap);
+    const int64_t low = below != nullptr ? below->layer : high - 2 * labelGap;
+    if (high - low < 2 || high > INT_MAX || low < INT_MIN) {
+        relabel();
+        return;
+    }
+    sprite->layer = static_cast<int>(low + (high - low) / 2);
+}
+
+void unlink(Sprite *sprite) {
+    (sprite->layerAbove != nullptr ? sprite->layerAbove->layerBelow : front) = sprite->layerBelow;
+    (sprite->layerBelow != nullptr ? sprite->layerBelow->layerAbove : back) = sprite->layerAbove;
+    sprite->layerAbove = nullptr;
+    sprite->layerBelow = nullptr;
+    count--;
+}
+
+} // namespace
+
+void Layers::clear() {
+    front = nullptr;
+    back = nullptr;
+    count = 0;
+    outOfOrder = false;
+    changes++;
+}
+
+void Layers::addToFront(Sprite *sprite) {
+    link(sprite, nullptr, front);
+}
+
+void Layers::addBehind(Sprite *sprite, Sprite *other) {
+    if (other == nullptr || !contains(other)) {
+        link(sprite, back, nullptr);
+        return;
+    }
+    link(sprite, other, other->layerBelow);
+}
+
+void Layers::remove(Sprite *sprite) {
+    if (contains(sprite)) unlink(sprite);
+}
+
+void Layers::goToFront(Sprite *sprite) {
+    if (sprite == front || !contains(sprite)) return;
+    unlink(sprite);
+    link(sprite, nullptr, front);
+}
+
+void Layers::goToBack(Sprite *sprite) {
+    if (sprite == back || !contains(sprite)) return;
+    unlink(sprite);
+    link(sprite, back, nullptr);
+}
+
+void Layers::goForward(Sprite *sprite, int layers) {
+    if (layers == 0 || !contains(sprite)) return;
+    // going past every other Sprite is common enough ("go backward 999 layers") to not walk there
+    if (static_cast<size_t>(std::abs(static_cast<int64_t>(layers))) >= count) {
+        if (layers > 0) goToFront(sprite);
+        else goToBack(sprite);
+        return;
+    }
+
+    Sprite *target = sprite;
+    if (layers > 0) {
+        for (int i = 0; i < layers && target->layerAbove != nullptr; i++) {
+            target = target->layerAbove;
+        }
+        if (target == sprite) return;
+        unlink(sprite);
+        link(sprite, target->layerAbove, target);
+    } else {
+        for (int i = 0; i > layers && target->layerBelow != nullptr; i--) {
+            target = target->layerBelow;
+        }
+        if (target == sprite) return;
+        unlink(sprite);
+        link(sprite, target, target->layerBelow);
+    }
+}
+
+uint64_t Layers::version() {
+    return changes;
+}
+
+void Layers::updateSprites() {
+    if (!outOfOrder) return;
+    outOfOrder = false;
+
+    sprites.resize(count + (stageSprite != nullptr ? 1 : 0));
+    size_t index = 0;
+    for (Sprite *sprite = front; sprite != nullptr; sprite = sprite->layerBelow) {
+        sprites[index++] = sprite;
+    }
+    if (stageSprite != nullptr) sprites[index] = stageSprite;
+}
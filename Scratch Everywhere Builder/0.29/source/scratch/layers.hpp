@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class Sprite;
+
+/**
+ * Front to back order of every Sprite except the Stage, like Scratch's sprite layer.
+ * It's a list linked through `Sprite::layerAbove` and `Sprite::layerBelow`, so moving a Sprite is O(1)
+ * (or O(n) for going forward or backward n layers). `Sprite::layer` is kept as a label of the Sprite's
+ * place in that list: the Sprite with the larger `layer` is in front.
+ * Moving Sprites only marks `sprites` out of order; `updateSprites()` rewrites it from the list in one pass.
+ */
+class Layers {
+  public:
+    /**
+     * Forgets every Sprite.
+     */
+    static void clear();
+
+    /**
+     * Adds a Sprite in front of every other one.
+     * @param sprite A Sprite that isn't in the list yet
+     */
+    static void addToFront(Sprite *sprite);
+
+    /**
+     * Adds a Sprite directly behind another one, like a new Clone behind the Sprite it was cloned from.
+     * @param sprite A Sprite that isn't in the list yet. Its old links are ignored
+     * @param other The Sprite to go behind. If it isn't in the list (like the Stage), `sprite` goes to the back
+     */
+    static void addBehind(Sprite *sprite, Sprite *other);
+
+    /**
+     * Takes a Sprite out of the list. `sprites` stays in order.
+     * @param sprite
+     */
+    static void remove(Sprite *sprite);
+
+    /**
+     * Moves a Sprite in front of every other one.
+     * @param sprite
+     */
+    static void goToFront(Sprite *sprite);
+
+    /**
+     * Moves a Sprite behind every other one, but still in front of the Stage.
+     * @param sprite
+     */
+    static void goToBack(Sprite *sprite);
+
+    /**
+     * Moves a Sprite forward past `layers` other Sprites, stopping at the front or back.
+     * @param sprite
+     * @param layers Layers to go forward. Negative goes backward
+     */
+    static void goForward(Sprite *sprite, int layers);
+
+    /**
+     * Counts every time a Sprite was added or moved, so lists kept in layer order can tell when they need sorting again.
+     * @return A number that changes whenever any Sprite's `layer` might have.
+     */
+    static uint64_t version();
+
+    /**
+     * Rewrites `sprites` in layer order (front first, then the Stage) if any Sprite moved since the last call.
+     */
+    static void updateSprites();
+};
@@ -0,0 +1,46 @@
+#include "mappedFile.hpp"
+#ifdef SE_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+#ifdef SE_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat fileStat;
+    // an empty file can't be mapped
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *address = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file open on its own
+    ::close(fd);
+    if (address == MAP_FAILED) return false;
+
+    mapped = static_cast<const char *>(address);
+    size = static_cast<size_t>(fileStat.st_size);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef SE_HAS_MMAP
+    if (mapped != nullptr) munmap(const_cast<char *>(mapped), size);
+#endif
+    mapped = nullptr;
+    size = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define SE_HAS_MMAP
+#endif
+
+/**
+ * A file mapped read-only into memory, so it can be read like a buffer without copying it.
+ * The pages are backed by the file, so they're shared with the OS's file cache and only read in when they're touched.
+ * Only works where mmap is available; elsewhere `open()` always fails and the file has to be read normally.
+ */
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /**
+     * Maps a file, unmapping whatever was mapped before.
+     * @param path The file to map
+     * @return `true` if the file was mapped.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Unmaps the file, if one is mapped.
+     */
+    void close();
+
+    /**
+     * @return The mapped file's contents, or an empty view if nothing is mapped.
+     */
+    std::string_view data() const { return std::string_view(mapped, size); }
+
+  private:
+    const char *mapped = nullptr;
+    size_t size = 0;
+};
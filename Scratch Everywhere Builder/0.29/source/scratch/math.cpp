@@ -1,11 +1,14 @@
 #include "math.hpp"
 #include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <limits>
 #include <math.h>
 #include <random>
-#include <stdexcept>
 #include <string>
+#include <string_view>
 #ifdef __3DS__
 #include <citro2d.h>
 #endif
@@ -35,26 +38,28 @@ int Math::color(int r, int g, int b, int a) {
     return 0;
 }
 
-double Math::parseNumber(std::string str) {
+bool Math::parseNumber(std::string_view str, double &result) {
+    result = 0;
+
     // Scratch has whitespace trimming
-    while (std::isspace(str[0]) && !str.empty()) {
-        str.erase(0, 1);
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+        str.remove_prefix(1);
     }
-    while (std::isspace(str[str.length() - 1]) && !str.empty()) {
-        str.erase(str.length() - 1);
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back()))) {
+        str.remove_suffix(1);
     }
 
     if (str == "Infinity") {
-        return std::numeric_limits<double>::infinity();
+        result = std::numeric_limits<double>::infinity();
+        return true;
     } else if (str == "-Infinity") {
-        return -std::numeric_limits<double>::infinity();
+        result = -std::numeric_limits<double>::infinity();
+        return true;
     }
 
-    uint8_t base = 0;
-    std::string validcharacters = "0123456789-eE.";
-    if (str[0] == '0') {
-        base = 0;
-
+    int base = 0;
+    std::string_view validcharacters = "0123456789-eE.";
+    if (str.size() > 1 && str[0] == '0') {
         switch (str[1]) {
         case 'x':
             base = 16;
@@ -70,53 +75,71 @@ double Math::parseNumber(std::string str) {
             break;
         }
         if (base != 0) {
-            str = str.substr(2, str.length() - 2);
+            str.remove_prefix(2);
         }
     }
 
-    for (int i = 0; i < str.length(); i++) {
-        if (validcharacters.find(str[i]) == std::string::npos) {
-            throw std::invalid_argument("");
+    for (size_t i = 0; i < str.length(); i++) {
+        if (validcharacters.find(str[i]) == std::string_view::npos) {
+            return false;
         }
         if (str[i] == 'e' && i == str.length() - 1) {
             // implementation differece, "1e" doesn't work in Scratch but works
-            // with std::stod()
-            throw std::invalid_argument("");
+            // with strtod()
+            return false;
         }
-        if (str[i] == 'e' && str.find('.', i + 1) != std::string::npos) {
+        if (str[i] == 'e' && str.find('.', i + 1) != std::string_view::npos) {
             // implementation differece, decimal point after e doesn't work in
-            // Scratch but works with std::stod()
-            throw std::invalid_argument("");
+            // Scratch but works with strtod()
+            return false;
         }
     }
 
+    // strtod() and strtol() need a null terminated string. Numbers are short, so copy to the stack
+    char shortBuffer[64];
+    std::string longBuffer;
+    const char *text;
+    if (str.size() < sizeof(shortBuffer)) {
+        std::memcpy(shortBuffer, str.data(), str.size());
+        shortBuffer[str.size()] = '\0';
+        text = shortBuffer;
+    } else {
+        longBuffer.assign(str);
+        text = longBuffer.c_str();
+    }
+
+    char *end = nullptr;
+    errno = 0;
     double conversion;
-    std::size_t pos;
-    try {
-        if (base == 0) {
-            conversion = std::stod(str, &pos);
-        } else {
-            conversion = std::stoi(str, &pos, base);
-        }
-    } catch (const std::out_of_range &e) {
-        if (str[0] == '-') {
-            return -std::numeric_limits<double>::infinity();
-        } else {
-            return std::numeric_limits<double>::infinity();
-        }
-    } catch (const std::invalid_argument &e) {
-        return 0;
+    if (base == 0) {
+        conversion = std::strtod(text, &end);
+    } else {
+        const long longConversion = std::strtol(text, &end, base);
+        if (longConversion > std::numeric_limits<int>::max() || longConversion < std::numeric_limits<int>::min()) errno = ERANGE;
+        conversion = static_cast<double>(longConversion);
     }
-    return conversion;
-}
 
-bool Math::isNumber(const std::string &str) {
-    try {
-        parseNumber(str);
+    // a string like "-" or "." only has valid characters, but isn't a number. Scratch treats it as 0
+    if (end == text) return true;
+
+    if (errno == ERANGE) {
+        result = str[0] == '-' ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
         return true;
-    } catch (...) {
-        return false;
     }
+
+    result = conversion;
+    return true;
+}
+
+double Math::parseNumber(std::string_view str) {
+    double result;
+    parseNumber(str, result);
+    return result;
+}
+
+bool Math::isNumber(std::string_view str) {
+    double result;
+    return parseNumber(str, result);
 }
 
 double Math::degreesToRadians(double degrees) {
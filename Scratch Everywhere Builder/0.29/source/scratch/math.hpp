@@ -1,14 +1,18 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 namespace Math {
 
-bool isNumber(const std::string &str);
-double parseNumber(std::string str);
+// Converts a string to a number the way Scratch does. Returns false (and sets `result` to 0) if `str` isn't a number.
+bool parseNumber(std::string_view str, double &result);
+// Converts a string to a number the way Scratch does, or returns 0 if `str` isn't a number.
+double parseNumber(std::string_view str);
+bool isNumber(std::string_view str);
 
 int color(int r, int g, int b, int a);
 
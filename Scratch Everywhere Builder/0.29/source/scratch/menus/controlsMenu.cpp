@@ -23,9 +23,9 @@ void ControlsMenu::init() {
     std::vector<std::string> controls;
 
     for (auto &sprite : sprites) {
-        for (auto &[id, block] : sprite->blocks) {
+        for (auto &[id, block] : sprite->data->blocks) {
             std::string buttonCheck;
-            if (block.opcode == "sensing_keypressed") {
+            if (block.opcodeId == Opcode::SENSING_KEYPRESSED) {
 
                 // stolen code from sensing.cpp
 
@@ -39,7 +39,7 @@ void ControlsMenu::init() {
                     buttonCheck = Scratch::getInputValue(block, "KEY_OPTION", sprite).asString();
                 }
 
-            } else if (block.opcode == "event_whenkeypressed") {
+            } else if (block.opcodeId == Opcode::EVENT_WHENKEYPRESSED) {
                 buttonCheck = Scratch::getFieldValue(block, "KEY_OPTION");
                 ;
             } else continue;
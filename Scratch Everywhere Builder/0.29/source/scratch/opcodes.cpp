@@ -0,0 +1,28 @@
+#include "opcodes.hpp"
+#include <unordered_map>
+
+namespace Opcodes {
+
+Opcode fromString(const std::string &opcode) {
+    static const std::unordered_map<std::string, Opcode> lookup = {
+#define X(name, string) {string, Opcode::name},
+        SCRATCH_OPCODES(X)
+#undef X
+    };
+
+    auto it = lookup.find(opcode);
+    if (it != lookup.end()) return it->second;
+    return Opcode::UNKNOWN;
+}
+
+const char *toString(Opcode opcode) {
+    static const char *names[] = {
+        "",
+#define X(name, string) string,
+        SCRATCH_OPCODES(X)
+#undef X
+    };
+    return names[static_cast<size_t>(opcode)];
+}
+
+} // namespace Opcodes
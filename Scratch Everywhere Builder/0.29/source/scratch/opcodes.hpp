@@ -0,0 +1,196 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Every opcode the interpreter knows about, as `X(ENUM_NAME, "scratch_opcode")`.
+ * Blocks with an opcode that isn't in this list get `Opcode::UNKNOWN`.
+ */
+#define SCRATCH_OPCODES(X) \
+    /* motion */ \
+    X(MOTION_MOVESTEPS, "motion_movesteps") \
+    X(MOTION_GOTOXY, "motion_gotoxy") \
+    X(MOTION_GOTO, "motion_goto") \
+    X(MOTION_CHANGEXBY, "motion_changexby") \
+    X(MOTION_CHANGEYBY, "motion_changeyby") \
+    X(MOTION_SETX, "motion_setx") \
+    X(MOTION_SETY, "motion_sety") \
+    X(MOTION_GLIDESECSTOXY, "motion_glidesecstoxy") \
+    X(MOTION_GLIDETO, "motion_glideto") \
+    X(MOTION_TURNRIGHT, "motion_turnright") \
+    X(MOTION_TURNLEFT, "motion_turnleft") \
+    X(MOTION_POINTINDIRECTION, "motion_pointindirection") \
+    X(MOTION_POINTTOWARDS, "motion_pointtowards") \
+    X(MOTION_SETROTATIONSTYLE, "motion_setrotationstyle") \
+    X(MOTION_IFONEDGEBOUNCE, "motion_ifonedgebounce") \
+    X(MOTION_XPOSITION, "motion_xposition") \
+    X(MOTION_YPOSITION, "motion_yposition") \
+    X(MOTION_DIRECTION, "motion_direction") \
+    /* looks */ \
+    X(LOOKS_SHOW, "looks_show") \
+    X(LOOKS_HIDE, "looks_hide") \
+    X(LOOKS_SWITCHCOSTUMETO, "looks_switchcostumeto") \
+    X(LOOKS_NEXTCOSTUME, "looks_nextcostume") \
+    X(LOOKS_SWITCHBACKDROPTO, "looks_switchbackdropto") \
+    X(LOOKS_NEXTBACKDROP, "looks_nextbackdrop") \
+    X(LOOKS_GOFORWARDBACKWARDLAYERS, "looks_goforwardbackwardlayers") \
+    X(LOOKS_GOTOFRONTBACK, "looks_gotofrontback") \
+    X(LOOKS_SETSIZETO, "looks_setsizeto") \
+    X(LOOKS_CHANGESIZEBY, "looks_changesizeby") \
+    X(LOOKS_SETEFFECTTO, "looks_seteffectto") \
+    X(LOOKS_CHANGEEFFECTBY, "looks_changeeffectby") \
+    X(LOOKS_CLEARGRAPHICEFFECTS, "looks_cleargraphiceffects") \
+    X(LOOKS_SIZE, "looks_size") \
+    X(LOOKS_COSTUME, "looks_costume") \
+    X(LOOKS_BACKDROPS, "looks_backdrops") \
+    X(LOOKS_COSTUMENUMBERNAME, "looks_costumenumbername") \
+    X(LOOKS_BACKDROPNUMBERNAME, "looks_backdropnumbername") \
+    /* sound */ \
+    X(SOUND_PLAY, "sound_play") \
+    X(SOUND_PLAYUNTILDONE, "sound_playuntildone") \
+    X(SOUND_STOPALLSOUNDS, "sound_stopallsounds") \
+    X(SOUND_CHANGEEFFECTBY, "sound_changeeffectby") \
+    X(SOUND_SETEFFECTTO, "sound_seteffectto") \
+    X(SOUND_CLEAREFFECTS, "sound_cleareffects") \
+    X(SOUND_CHANGEVOLUMEBY, "sound_changevolumeby") \
+    X(SOUND_SETVOLUMETO, "sound_setvolumeto") \
+    X(SOUND_VOLUME, "sound_volume") \
+    /* events */ \
+    X(EVENT_WHENFLAGCLICKED, "event_whenflagclicked") \
+    X(EVENT_BROADCAST, "event_broadcast") \
+    X(EVENT_BROADCASTANDWAIT, "event_broadcastandwait") \
+    X(EVENT_WHENKEYPRESSED, "event_whenkeypressed") \
+    X(EVENT_WHENBACKDROPSWITCHESTO, "event_whenbackdropswitchesto") \
+    X(EVENT_WHENTHISSPRITECLICKED, "event_whenthisspriteclicked") \
+    X(EVENT_WHENBROADCASTRECEIVED, "event_whenbroadcastreceived") \
+    /* control */ \
+    X(CONTROL_IF, "control_if") \
+    X(CONTROL_IF_ELSE, "control_if_else") \
+    X(CONTROL_CREATE_CLONE_OF, "control_create_clone_of") \
+    X(CONTROL_DELETE_THIS_CLONE, "control_delete_this_clone") \
+    X(CONTROL_STOP, "control_stop") \
+    X(CONTROL_START_AS_CLONE, "control_start_as_clone") \
+    X(CONTROL_WAIT, "control_wait") \
+    X(CONTROL_WAIT_UNTIL, "control_wait_until") \
+    X(CONTROL_REPEAT, "control_repeat") \
+    X(CONTROL_REPEAT_UNTIL, "control_repeat_until") \
+    X(CONTROL_WHILE, "control_while") \
+    X(CONTROL_FOREVER, "control_forever") \
+    X(CONTROL_GET_COUNTER, "control_get_counter") \
+    X(CONTROL_CLEAR_COUNTER, "control_clear_counter") \
+    X(CONTROL_INCR_COUNTER, "control_incr_counter") \
+    X(CONTROL_FOR_EACH, "control_for_each") \
+    /* operators */ \
+    X(OPERATOR_ADD, "operator_add") \
+    X(OPERATOR_SUBTRACT, "operator_subtract") \
+    X(OPERATOR_MULTIPLY, "operator_multiply") \
+    X(OPERATOR_DIVIDE, "operator_divide") \
+    X(OPERATOR_RANDOM, "operator_random") \
+    X(OPERATOR_JOIN, "operator_join") \
+    X(OPERATOR_LETTER_OF, "operator_letter_of") \
+    X(OPERATOR_LENGTH, "operator_length") \
+    X(OPERATOR_MOD, "operator_mod") \
+    X(OPERATOR_ROUND, "operator_round") \
+    X(OPERATOR_MATHOP, "operator_mathop") \
+    X(OPERATOR_EQUALS, "operator_equals") \
+    X(OPERATOR_GT, "operator_gt") \
+    X(OPERATOR_LT, "operator_lt") \
+    X(OPERATOR_AND, "operator_and") \
+    X(OPERATOR_OR, "operator_or") \
+    X(OPERATOR_NOT, "operator_not") \
+    X(OPERATOR_CONTAINS, "operator_contains") \
+    /* data */ \
+    X(DATA_SETVARIABLETO, "data_setvariableto") \
+    X(DATA_CHANGEVARIABLEBY, "data_changevariableby") \
+    X(DATA_SHOWVARIABLE, "data_showvariable") \
+    X(DATA_HIDEVARIABLE, "data_hidevariable") \
+    X(DATA_SHOWLIST, "data_showlist") \
+    X(DATA_HIDELIST, "data_hidelist") \
+    X(DATA_ADDTOLIST, "data_addtolist") \
+    X(DATA_DELETEOFLIST, "data_deleteoflist") \
+    X(DATA_DELETEALLOFLIST, "data_deletealloflist") \
+    X(DATA_INSERTATLIST, "data_insertatlist") \
+    X(DATA_REPLACEITEMOFLIST, "data_replaceitemoflist") \
+    X(DATA_ITEMOFLIST, "data_itemoflist") \
+    X(DATA_ITEMNUMOFLIST, "data_itemnumoflist") \
+    X(DATA_LENGTHOFLIST, "data_lengthoflist") \
+    X(DATA_LISTCONTAINSITEM, "data_listcontainsitem") \
+    X(DATA_VARIABLE, "data_variable") \
+    X(DATA_LISTCONTENTS, "data_listcontents") \
+    /* sensing */ \
+    X(SENSING_RESETTIMER, "sensing_resettimer") \
+    X(SENSING_ASKANDWAIT, "sensing_askandwait") \
+    X(SENSING_SETDRAGMODE, "sensing_setdragmode") \
+    X(SENSING_TIMER, "sensing_timer") \
+    X(SENSING_OF, "sensing_of") \
+    X(SENSING_MOUSEX, "sensing_mousex") \
+    X(SENSING_MOUSEY, "sensing_mousey") \
+    X(SENSING_DISTANCETO, "sensing_distanceto") \
+    X(SENSING_DISTANCETOMENU, "sensing_distancetomenu") \
+    X(SENSING_DAYSSINCE2000, "sensing_dayssince2000") \
+    X(SENSING_CURRENT, "sensing_current") \
+    X(SENSING_ANSWER, "sensing_answer") \
+    X(SENSING_KEYPRESSED, "sensing_keypressed") \
+    X(SENSING_KEYOPTIONS, "sensing_keyoptions") \
+    X(SENSING_TOUCHINGOBJECT, "sensing_touchingobject") \
+    X(SENSING_TOUCHINGOBJECTMENU, "sensing_touchingobjectmenu") \
+    X(SENSING_TOUCHINGCOLOR, "sensing_touchingcolor") \
+    X(SENSING_COLORISTOUCHINGCOLOR, "sensing_coloristouchingcolor") \
+    X(SENSING_MOUSEDOWN, "sensing_mousedown") \
+    X(SENSING_USERNAME, "sensing_username") \
+    /* procedures / arguments */ \
+    X(PROCEDURES_CALL, "procedures_call") \
+    X(PROCEDURES_DEFINITION, "procedures_definition") \
+    X(ARGUMENT_REPORTER_STRING_NUMBER, "argument_reporter_string_number") \
+    X(ARGUMENT_REPORTER_BOOLEAN, "argument_reporter_boolean") \
+    X(PROCEDURES_PROTOTYPE, "procedures_prototype") \
+    /* pen extension */ \
+    X(PEN_PENDOWN, "pen_penDown") \
+    X(PEN_PENUP, "pen_penUp") \
+    X(PEN_CLEAR, "pen_clear") \
+    X(PEN_SETPENCOLORPARAMTO, "pen_setPenColorParamTo") \
+    X(PEN_CHANGEPENCOLORPARAMBY, "pen_changePenColorParamBy") \
+    X(PEN_STAMP, "pen_stamp") \
+    X(PEN_SETPENCOLORTOCOLOR, "pen_setPenColorToColor") \
+    X(PEN_SETPENSIZETO, "pen_setPenSizeTo") \
+    X(PEN_CHANGEPENSIZEBY, "pen_changePenSizeBy") \
+    /* other */ \
+    X(MATRIX, "matrix")
+
+enum class Opcode : uint16_t {
+    UNKNOWN = 0,
+#define X(name, string) name,
+    SCRATCH_OPCODES(X)
+#undef X
+    COUNT
+};
+
+/**
+ * A lookup table indexed directly by `Opcode`.
+ */
+template <typename T>
+struct OpcodeTable {
+    T entries[static_cast<size_t>(Opcode::COUNT)] = {};
+
+    T &operator[](Opcode opcode) { return entries[static_cast<size_t>(opcode)]; }
+    const T &operator[](Opcode opcode) const { return entries[static_cast<size_t>(opcode)]; }
+};
+
+namespace Opcodes {
+
+/**
+ * Gets the `Opcode` of a Scratch opcode string (eg; "motion_movesteps").
+ * @param opcode Name of the block
+ * @return The matching `Opcode`, or `Opcode::UNKNOWN` if there is none.
+ */
+Opcode fromString(const std::string &opcode);
+
+/**
+ * Gets the Scratch opcode string of an `Opcode`.
+ * @param opcode
+ * @return The name of the block, or an empty string for `Opcode::UNKNOWN`.
+ */
+const char *toString(Opcode opcode);
+
+} // namespace Opcodes
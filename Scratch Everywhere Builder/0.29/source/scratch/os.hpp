@@ -105,6 +105,22 @@ class MemoryTracker {
         return ptr;
     }
 
+    // Tracking for memory that was allocated some other way, like a std::vector
+    static void track(size_t size) {
+        if (size == 0) return;
+        totalAllocated += size;
+        allocationCount++;
+
+        if (totalAllocated > peakUsage) {
+            peakUsage = totalAllocated;
+        }
+    }
+    static void untrack(size_t size) {
+        if (size == 0) return;
+        totalAllocated -= size;
+        allocationCount--;
+    }
+
     static void allocateVRAM(size_t size) {
         totalVRAMAllocated += size;
     }
@@ -0,0 +1,163 @@
+#include "profiler.hpp"
+#ifdef ENABLE_PROFILER
+#include "os.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+std::vector<uint64_t> Profiler::childTime[static_cast<size_t>(Profiler::Category::COUNT)];
+
+namespace {
+
+OpcodeTable<ProfileEntry> opcodeEntries;
+// live entries, by the `SpriteData` (or `CustomBlock`) they belong to, so they can be found without building a name
+std::unordered_map<const SpriteData *, std::vector<ProfileEntry>> scriptEntries;
+std::unordered_map<const CustomBlock *, ProfileEntry> customBlockEntries;
+// entries of Sprites that have since been deleted, by name
+std::map<std::string, ProfileEntry> forgottenScripts;
+std::map<std::string, ProfileEntry> forgottenCustomBlocks;
+uint64_t warpStalls = 0;
+uint64_t warpStallMs = 0;
+
+std::string scriptName(Sprite *sprite, int32_t scriptIndex) {
+    std::string name = sprite->name + ": ";
+    for (const auto &[id, block] : sprite->data->blocks) {
+        if (!block.topLevel || block.scriptIndex != scriptIndex) continue;
+        if (block.opcodeId == Opcode::PROCEDURES_DEFINITION) {
+            name += "define";
+            for (const auto &[prototypeId, prototype] : sprite->data->blocks) {
+                if (prototype.opcodeId == Opcode::PROCEDURES_PROTOTYPE && prototype.parent == id) name += " " + prototype.customBlockId;
+            }
+        } else {
+            name += block.opcode;
+            auto broadcast = block.parsedFields->find("BROADCAST_OPTION");
+            if (broadcast != block.parsedFields->end()) name += " " + broadcast->second.value;
+        }
+        break;
+    }
+    return name + " #" + std::to_string(scriptIndex);
+}
+
+void merge(std::map<std::string, ProfileEntry> &into, const ProfileEntry &entry) {
+    if (entry.calls == 0) return;
+    ProfileEntry &merged = into[entry.name];
+    merged.name = entry.name;
+    merged.calls += entry.calls;
+    merged.inclusiveNs += entry.inclusiveNs;
+    merged.exclusiveNs += entry.exclusiveNs;
+}
+
+nlohmann::json resultsToJson(const std::vector<ProfileEntry> &results) {
+    nlohmann::json json = nlohmann::json::array();
+    for (const ProfileEntry &entry : results) {
+        json.push_back({{"name", entry.name},
+                        {"calls", entry.calls},
+                        {"inclusiveMs", entry.inclusiveNs / 1e6},
+                        {"exclusiveMs", entry.exclusiveNs / 1e6}});
+    }
+    return json;
+}
+
+} // namespace
+
+ProfileEntry &Profiler::opcode(Opcode opcode) {
+    return opcodeEntries[opcode];
+}
+
+ProfileEntry &Profiler::script(Sprite *sprite, int32_t scriptIndex) {
+    std::vector<ProfileEntry> &entries = scriptEntries[sprite->data.get()];
+    // sized once, since open `ProfileScope`s hold references into it
+    if (entries.empty()) entries.resize(std::max<size_t>(sprite->data->scriptStateCounts.size(), scriptIndex + 1));
+    ProfileEntry &entry = entries[scriptIndex];
+    if (entry.name.empty()) entry.name = scriptName(sprite, scriptIndex);
+    return entry;
+}
+
+ProfileEntry &Profiler::customBlock(Sprite *sprite, const CustomBlock &customBlock) {
+    ProfileEntry &entry = customBlockEntries[&customBlock];
+    if (entry.name.empty()) entry.name = sprite->name + ": " + customBlock.name;
+    return entry;
+}
+
+void Profiler::warpStall(int ms) {
+    warpStalls++;
+    warpStallMs += static_cast<uint64_t>(ms);
+}
+
+void Profiler::forgetSprites() {
+    for (const auto &[data, entries] : scriptEntries) {
+        for (const ProfileEntry &entry : entries) {
+            merge(forgottenScripts, entry);
+        }
+    }
+    for (const auto &[customBlock, entry] : customBlockEntries) {
+        merge(forgottenCustomBlocks, entry);
+    }
+    scriptEntries.clear();
+    customBlockEntries.clear();
+}
+
+std::vector<ProfileEntry> Profiler::getResults(Category category) {
+    std::vector<ProfileEntry> results;
+    if (category == Category::OPCODE) {
+        for (size_t i = 1; i < static_cast<size_t>(Opcode::COUNT); i++) {
+            ProfileEntry entry = opcodeEntries.entries[i];
+            if (entry.calls == 0) continue;
+            entry.name = Opcodes::toString(static_cast<Opcode>(i));
+            results.push_back(entry);
+        }
+    } else {
+        std::map<std::string, ProfileEntry> merged = category == Category::SCRIPT ? forgottenScripts : forgottenCustomBlocks;
+        if (category == Category::SCRIPT) {
+            for (const auto &[data, entries] : scriptEntries) {
+                for (const ProfileEntry &entry : entries) {
+                    merge(merged, entry);
+                }
+            }
+        } else {
+            for (const auto &[customBlock, entry] : customBlockEntries) {
+                merge(merged, entry);
+            }
+        }
+        for (const auto &[name, entry] : merged) {
+            results.push_back(entry);
+        }
+    }
+
+    std::sort(results.begin(), results.end(), [](const ProfileEntry &a, const ProfileEntry &b) {
+        return a.inclusiveNs > b.inclusiveNs;
+    });
+    return results;
+}
+
+void Profiler::reset() {
+    opcodeEntries = OpcodeTable<ProfileEntry>();
+    scriptEntries.clear();
+    customBlockEntries.clear();
+    forgottenScripts.clear();
+    forgottenCustomBlocks.clear();
+    warpStalls = 0;
+    warpStallMs = 0;
+}
+
+nlohmann::json Profiler::toJson() {
+    return {{"opcodes", resultsToJson(getResults(Category::OPCODE))},
+            {"scripts", resultsToJson(getResults(Category::SCRIPT))},
+            {"customBlocks", resultsToJson(getResults(Category::CUSTOM_BLOCK))},
+            {"warpStalls", {{"count", warpStalls}, {"totalMs", warpStallMs}}}};
+}
+
+bool Profiler::dumpJson(const std::string &path) {
+    std::ofstream file(path);
+    if (!file) {
+        Log::logWarning("Failed to write profile to " + path);
+        return false;
+    }
+    file << toJson().dump(4) << std::endl;
+    Log::log("Wrote profile to " + path);
+    return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+#include "opcodes.hpp"
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+class Sprite;
+struct CustomBlock;
+
+/**
+ * Time spent in one opcode, script or custom block.
+ * Inclusive time counts everything that ran inside it, exclusive time leaves out nested entries of the same kind
+ * (so a script's exclusive time doesn't include the custom blocks it calls, but does include every block in it).
+ */
+struct ProfileEntry {
+    std::string name;
+    uint64_t calls = 0; // for scripts, only counts runs started from the top block, not loops resuming on later frames
+    uint64_t inclusiveNs = 0;
+    uint64_t exclusiveNs = 0;
+    uint32_t active = 0; // how many times this entry is currently on the stack, so recursion isn't counted twice
+};
+
+/**
+ * Per-opcode, per-script and per-custom block execution profiler.
+ * Only compiled in when building with `SE_PROFILER` (`ENABLE_PROFILER`), so it costs nothing otherwise.
+ * Results are kept across projects, and are written to `profile.json` when the app exits.
+ */
+class Profiler {
+  public:
+    enum class Category : uint8_t {
+        OPCODE,
+        SCRIPT,
+        CUSTOM_BLOCK,
+        COUNT
+    };
+
+    static ProfileEntry &opcode(Opcode opcode);
+
+    /**
+     * Gets the entry of a top level script. Clones share their original's entries.
+     * @param sprite The Sprite running the script
+     * @param scriptIndex `Block::scriptIndex` of the script
+     */
+    static ProfileEntry &script(Sprite *sprite, int32_t scriptIndex);
+
+    static ProfileEntry &customBlock(Sprite *sprite, const CustomBlock &customBlock);
+
+    /**
+     * Records a script running without screen refresh that ran out of time and had to wait for a frame.
+     * @param ms How long it ran (and held up the frame) before that
+     */
+    static void warpStall(int ms);
+
+    /**
+     * Moves the entries of every loaded Sprite into entries keyed by name.
+     * Must be called before Sprites are deleted, since entries are looked up by `SpriteData` pointer.
+     */
+    static void forgetSprites();
+
+    /**
+     * Gets every entry in a category that has been called at least once, sorted by inclusive time.
+     * @param category
+     * @return Copies of the entries.
+     */
+    static std::vector<ProfileEntry> getResults(Category category);
+
+    static void reset();
+
+    /**
+     * Every result as `{"opcodes": [...], "scripts": [...], "customBlocks": [...], "warpStalls": {...}}`,
+     * with each entry's name, calls, and inclusive/exclusive time in milliseconds,
+     * and how many times and for how long scripts without screen refresh ran out of time.
+     */
+    static nlohmann::json toJson();
+
+    /**
+     * Writes `toJson()` to a file.
+     * @param path Where to write the JSON
+     * @return `true` if the file was written.
+     */
+    static bool dumpJson(const std::string &path);
+
+  private:
+    friend class ProfileScope;
+    // time spent in nested scopes of each category, one element per open scope
+    static std::vector<uint64_t> childTime[static_cast<size_t>(Category::COUNT)];
+};
+
+/**
+ * Times everything until it goes out of scope, and adds it to a `ProfileEntry`.
+ */
+class ProfileScope {
+  public:
+    /**
+     * @param entry The entry to add the time to
+     * @param category
+     * @param countCall Whether this counts as a call, `false` when continuing something that was already counted
+     */
+    ProfileScope(ProfileEntry &entry, Profiler::Category category, bool countCall = true) : entry(entry), stack(Profiler::childTime[static_cast<size_t>(category)]), countCall(countCall) {
+        entry.active++;
+        stack.push_back(0);
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() {
+        const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        const uint64_t nested = stack.back();
+        stack.pop_back();
+        if (!stack.empty()) stack.back() += elapsed;
+
+        if (countCall) entry.calls++;
+        entry.exclusiveNs += elapsed > nested ? elapsed - nested : 0;
+        if (--entry.active == 0) entry.inclusiveNs += elapsed;
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+  private:
+    ProfileEntry &entry;
+    std::vector<uint64_t> &stack;
+    std::chrono::steady_clock::time_point start;
+    bool countCall;
+};
@@ -5,6 +5,9 @@
 #include "text.hpp"
 #include <chrono>
 #include <vector>
+#ifdef SDL_BUILD
+#include "framePacer.hpp"
+#endif
 
 class Render {
   public:
@@ -287,6 +290,26 @@ class Render {
      * Returns whether or not enough time has passed to advance a frame.
      * @return True if we should go to the next frame, False otherwise.
      */
+#ifdef SDL_BUILD
+    static bool checkFramerate();
+
+    /**
+     * Sleeps until the next frame is due, for when there's nothing to do before then.
+     */
+    static void waitForFrame();
+
+    /**
+     * Gets how long until the next frame is due, so turbo mode can stop running ticks in time for it.
+     * @return Milliseconds left, or 0 if it's already due.
+     */
+    static double timeUntilFrame();
+
+    /**
+     * Gets how evenly project frames have been paced since the app started.
+     * @return A copy of the frame pacer's counters.
+     */
+    static FramePacer::Stats getFramePacingStats();
+#else
     static bool checkFramerate() {
         if (Scratch::turbo) return true;
         static Timer frameTimer;
@@ -294,6 +317,15 @@ class Render {
         return frameTimer.hasElapsedAndRestart(frameDuration);
     }
 
+    static void waitForFrame() {
+    }
+
+    // turbo mode renders after every call to `runTicks()` here, so the whole frame is left
+    static double timeUntilFrame() {
+        return Scratch::FPS > 0 ? 1000.0 / Scratch::FPS : 0;
+    }
+#endif
+
     enum RenderModes {
         TOP_SCREEN_ONLY,
         BOTTOM_SCREEN_ONLY,
@@ -0,0 +1,219 @@
+#include "spatialHash.hpp"
+#include "interpret.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+OpcodeTable<bool> SpatialHash::movingOpcodes = [] {
+    OpcodeTable<bool> table;
+    for (Opcode opcode : {Opcode::MOTION_MOVESTEPS, Opcode::MOTION_GOTOXY, Opcode::MOTION_GOTO, Opcode::MOTION_CHANGEXBY, Opcode::MOTION_CHANGEYBY,
+                          Opcode::MOTION_SETX, Opcode::MOTION_SETY, Opcode::MOTION_GLIDESECSTOXY, Opcode::MOTION_GLIDETO, Opcode::MOTION_TURNRIGHT,
+                          Opcode::MOTION_TURNLEFT, Opcode::MOTION_POINTINDIRECTION, Opcode::MOTION_POINTTOWARDS, Opcode::MOTION_SETROTATIONSTYLE,
+                          Opcode::MOTION_IFONEDGEBOUNCE, Opcode::LOOKS_SHOW, Opcode::LOOKS_HIDE, Opcode::LOOKS_SWITCHCOSTUMETO, Opcode::LOOKS_NEXTCOSTUME,
+                          Opcode::LOOKS_SETSIZETO, Opcode::LOOKS_CHANGESIZEBY, Opcode::PEN_STAMP}) {
+        table[opcode] = true;
+    }
+    return table;
+}();
+
+namespace {
+
+// cells covered by a Sprite's bounding box, inclusive
+struct CellRange {
+    int32_t minX, minY, maxX, maxY;
+
+    bool operator==(const CellRange &other) const {
+        return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+    }
+
+    bool overlaps(const CellRange &other) const {
+        return minX <= other.maxX && maxX >= other.minX && minY <= other.maxY && maxY >= other.minY;
+    }
+};
+
+struct Entry {
+    Sprite *sprite;
+    CellRange cells;
+    bool inGrid;
+    uint32_t queryStamp; // last query that returned this Sprite
+};
+
+// in Scratch units, about the size of a typical costume
+constexpr float cellSize = 64.0f;
+// Sprites covering more cells than this are kept in `oversized` instead
+constexpr int64_t maxCells = 64;
+// keeps cell coordinates of Sprites that are very far away (or NaN) from overflowing
+constexpr float maxCellCoordinate = 1 << 20;
+
+std::vector<Entry> entries;
+std::unordered_map<Sprite *, uint32_t> entryIndices;
+std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+std::vector<uint32_t> oversized;
+std::vector<Sprite *> moved;
+std::vector<Sprite *> results;
+uint32_t queryStamp = 0;
+bool stale = true;
+
+int32_t toCell(double coordinate) {
+    const double cell = std::floor(coordinate / cellSize);
+    if (!(cell > -maxCellCoordinate)) return static_cast<int32_t>(-maxCellCoordinate);
+    if (!(cell < maxCellCoordinate)) return static_cast<int32_t>(maxCellCoordinate);
+    return static_cast<int32_t>(cell);
+}
+
+uint64_t cellKey(int32_t x, int32_t y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+bool isOversized(const CellRange &range) {
+    return (static_cast<int64_t>(range.maxX) - range.minX + 1) * (static_cast<int64_t>(range.maxY) - range.minY + 1) > maxCells;
+}
+
+// reads the Sprite's cached collision box, so this is cheap for Sprites that didn't actually move
+CellRange getCells(Sprite *sprite) {
+    const CollisionPoints &points = getCollisionPoints(sprite);
+    double minX = points[0].first, maxX = points[0].first;
+    double minY = points[0].second, maxY = points[0].second;
+    for (const auto &[x, y] : points) {
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    return {toCell(minX), toCell(minY), toCell(maxX), toCell(maxY)};
+}
+
+bool belongsInGrid(Sprite *sprite) {
+    return sprite->visible && !sprite->isStage && !sprite->isDeleted;
+}
+
+void insert(uint32_t index) {
+    Entry &entry = entries[index];
+    entry.inGrid = true;
+    if (isOversized(entry.cells)) {
+        oversized.push_back(index);
+        return;
+    }
+    for (int32_t x = entry.cells.minX; x <= entry.cells.maxX; x++) {
+        for (int32_t y = entry.cells.minY; y <= entry.cells.maxY; y++) {
+            cells[cellKey(x, y)].push_back(index);
+        }
+    }
+}
+
+void remove(uint32_t index) {
+    Entry &entry = entries[index];
+    if (!entry.inGrid) return;
+    entry.inGrid = false;
+
+    auto eraseFrom = [index](std::vector<uint32_t> &indices) {
+        auto it = std::find(indices.begin(), indices.end(), index);
+        if (it == indices.end()) return;
+        *it = indices.back();
+        indices.pop_back();
+    };
+    if (isOversized(entry.cells)) {
+        eraseFrom(oversized);
+        return;
+    }
+    for (int32_t x = entry.cells.minX; x <= entry.cells.maxX; x++) {
+        for (int32_t y = entry.cells.minY; y <= entry.cells.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell != cells.end()) eraseFrom(cell->second);
+        }
+    }
+}
+
+void update(Sprite *sprite) {
+    const bool inGrid = belongsInGrid(sprite);
+    const CellRange range = inGrid ? getCells(sprite) : CellRange{0, 0, 0, 0};
+
+    auto found = entryIndices.find(sprite);
+    if (found == entryIndices.end()) {
+        const uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back({sprite, range, false, queryStamp});
+        entryIndices[sprite] = index;
+        if (inGrid) insert(index);
+        return;
+    }
+
+    Entry &entry = entries[found->second];
+    if (entry.inGrid == inGrid && (!inGrid || entry.cells == range)) return;
+    remove(found->second);
+    entry.cells = range;
+    if (inGrid) insert(found->second);
+}
+
+void rebuild() {
+    entries.clear();
+    entryIndices.clear();
+    oversized.clear();
+    // keep the cells' memory around, unless Sprites have wandered over far more cells than they cover now
+    if (cells.size() > 4 * sprites.size() + 256) cells.clear();
+    for (auto &[key, indices] : cells) {
+        indices.clear();
+    }
+
+    for (Sprite *sprite : sprites) {
+        update(sprite);
+    }
+    moved.clear();
+    stale = false;
+}
+
+} // namespace
+
+void SpatialHash::invalidate() {
+    stale = true;
+    moved.clear();
+}
+
+void SpatialHash::markMoved(Sprite *sprite) {
+    if (stale || (!moved.empty() && moved.back() == sprite)) return;
+    // rebuilding is cheaper than going through a list this long
+    if (moved.size() > entries.size()) {
+        invalidate();
+        return;
+    }
+    moved.push_back(sprite);
+}
+
+const std::vector<Sprite *> &SpatialHash::query(Sprite *sprite) {
+    if (stale) rebuild();
+    for (Sprite *movedSprite : moved) {
+        update(movedSprite);
+    }
+    moved.clear();
+
+    results.clear();
+    queryStamp++;
+    auto add = [](uint32_t index) {
+        Entry &entry = entries[index];
+        if (entry.queryStamp == queryStamp) return;
+        entry.queryStamp = queryStamp;
+        results.push_back(entry.sprite);
+    };
+
+    const CellRange range = getCells(sprite);
+    if (isOversized(range)) {
+        for (uint32_t index = 0; index < entries.size(); index++) {
+            if (entries[index].inGrid && entries[index].cells.overlaps(range)) add(index);
+        }
+        return results;
+    }
+
+    for (int32_t x = range.minX; x <= range.maxX; x++) {
+        for (int32_t y = range.minY; y <= range.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) continue;
+            for (uint32_t index : cell->second) {
+                add(index);
+            }
+        }
+    }
+    for (uint32_t index : oversized) {
+        if (entries[index].cells.overlaps(range)) add(index);
+    }
+    return results;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "opcodes.hpp"
+#include <vector>
+
+class Sprite;
+
+/**
+ * Uniform grid over the bounding boxes of every visible Sprite, so collision checks
+ * only have to look at Sprites near the one asking instead of every Sprite in the project.
+ * It's rebuilt from `sprites` before the first query of every tick, then kept up to date
+ * by re-inserting Sprites that ran a block that can move them (see `movesSprite()`).
+ */
+class SpatialHash {
+  public:
+    /**
+     * Makes the next query rebuild the grid from scratch.
+     * Called at the start of every tick, and whenever Sprites are added or removed outside of blocks.
+     */
+    static void invalidate();
+
+    /**
+     * Re-checks a Sprite's bounds before the next query. Does nothing if the grid will be rebuilt anyway.
+     * @param sprite A Sprite that may have moved, resized, turned, changed costume, shown or hidden, or was just created
+     */
+    static void markMoved(Sprite *sprite);
+
+    /**
+     * Whether running a block can change the bounds of the Sprite running it.
+     * @param opcode
+     */
+    static bool movesSprite(Opcode opcode) {
+        return movingOpcodes[opcode];
+    }
+
+    /**
+     * Gets every visible Sprite whose bounding box might overlap a Sprite's bounding box.
+     * The result includes `sprite` itself if it's visible, and is only valid until the next query.
+     * @param sprite The Sprite to check around
+     * @return The Sprites near `sprite`, each one once.
+     */
+    static const std::vector<Sprite *> &query(Sprite *sprite);
+
+  private:
+    static OpcodeTable<bool> movingOpcodes;
+};
@@ -1,6 +1,8 @@
 #pragma once
+#include "opcodes.hpp"
 #include "os.hpp"
 #include "value.hpp"
+#include <array>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
@@ -20,6 +22,24 @@ struct RenderInfo {
     bool forceUpdate = false;
 };
 
+// corners of a Sprite's collision box, as `{x, y}`
+using CollisionPoints = std::array<std::pair<double, double>, 4>;
+
+/**
+ * A Sprite's collision box, along with everything it was computed from,
+ * so it's only recomputed once one of those changes (see `getCollisionPoints()`).
+ */
+struct CollisionBox {
+    CollisionPoints points;
+
+    float oldX, oldY;
+    float oldSize, oldRotation;
+    int oldRotationStyle;
+    int oldCostumeID = -1;
+    int oldWidth, oldHeight;
+    int oldRotationCenterX, oldRotationCenterY;
+};
+
 struct Variable {
     std::string id;
     std::string name;
@@ -29,6 +49,24 @@ struct Variable {
     Value value;
 };
 
+/**
+ * A variable or list reference resolved by the Compiler, see `BlockExecutor::resolveVariable()`.
+ * `slot` indexes `Sprite::variables` (or `Sprite::lists`) of either the running Sprite or the Stage.
+ */
+struct VariableRef {
+    enum Scope : uint8_t {
+        NONE,   // the variable doesn't exist
+        SPRITE, // "for this sprite only", each Clone has its own copy
+        STAGE   // "for all sprites"
+    };
+
+    Scope scope = NONE;
+    bool isList = false;
+    uint32_t slot = 0;
+};
+
+struct Block;
+
 struct ParsedField {
     std::string value;
     std::string id;
@@ -45,24 +83,40 @@ struct ParsedInput {
     InputType inputType;
     Value literalValue;
     std::string variableId;
+    VariableRef variable; // `variableId` resolved by the Compiler
     std::string blockId;
+    Block *block = nullptr; // `blockId` resolved by the Compiler
 };
 
 struct Block {
     std::string id;
     std::string customBlockId;
     std::string opcode;
+    Opcode opcodeId = Opcode::UNKNOWN;
     std::string next;
     Block *nextBlock;
     std::string parent;
-    std::string blockChainID;
     std::shared_ptr<std::map<std::string, ParsedInput>> parsedInputs;
     std::shared_ptr<std::map<std::string, ParsedField>> parsedFields;
     bool shadow;
     bool topLevel;
     std::string topLevelParentBlock;
+    int32_t pc = -1;          // index of this block in its Sprite's `bytecode`, -1 if not compiled
+    int32_t scriptIndex = -1; // index of the script (and `ScriptThread`) this block is in, -1 if it isn't in one
+    int32_t stateIndex = -1;  // index of this block's `BlockState` in its `ScriptThread`, -1 if it doesn't need one
+    VariableRef variable;     // the block's `VARIABLE` or `LIST` field, resolved by the Compiler
+
+    Block() {
+        parsedFields = std::make_shared<std::map<std::string, ParsedField>>();
+        parsedInputs = std::make_shared<std::map<std::string, ParsedInput>>();
+    }
+};
 
-    /* variables that some blocks need*/
+/**
+ * Runtime variables that some blocks need. Blocks are shared between a Sprite and its Clones,
+ * so these are stored in the `ScriptThread` running them instead, see `BlockExecutor::getBlockState()`.
+ */
+struct BlockState {
     int repeatTimes = -1;
     bool isRepeating = false;
     double waitDuration;
@@ -72,11 +126,14 @@ struct Block {
     bool customBlockExecuted = false;
     Block *customBlockPtr = nullptr;
     std::vector<std::pair<Block *, Sprite *>> broadcastsRun;
+};
 
-    Block() {
-        parsedFields = std::make_shared<std::map<std::string, ParsedField>>();
-        parsedInputs = std::make_shared<std::map<std::string, ParsedInput>>();
-    }
+struct Instruction {
+    Opcode opcode;     // `block->opcodeId`
+    Block *block;      // the block this instruction runs
+    int32_t next;      // next instruction in the same stack, -1 at the end
+    int32_t substack;  // first instruction of SUBSTACK, -1 if empty
+    int32_t substack2; // first instruction of SUBSTACK2, -1 if empty
 };
 
 struct CustomBlock {
@@ -87,7 +144,6 @@ struct CustomBlock {
     std::vector<std::string> argumentIds;
     std::vector<std::string> argumentNames;
     std::vector<std::string> argumentDefaults;
-    std::unordered_map<std::string, Value> argumentValues;
     bool runWithoutScreenRefresh;
 };
 
@@ -133,15 +189,28 @@ struct Broadcast {
     std::string name;
 };
 
-struct BlockChain {
-    std::vector<Block *> blockChain;
-    std::vector<std::string> blocksToRepeat;
+/**
+ * A script running inside a Sprite (or Clone). Holds everything that changes while the script runs,
+ * so the Blocks themselves stay read-only.
+ */
+struct ScriptThread {
+    // Instructions of the blocks currently repeating (loops, waits, custom blocks...), innermost last.
+    // The last one is where the script picks up next frame.
+    std::vector<int32_t> repeatStack;
+
+    // Whether the script was running without screen refresh when it ran out of time (see `Scratch::warpTimeLimit`),
+    // so it should keep doing that once its caller picks it up again.
+    bool warpYielded = false;
+
+    // Loop counters and timers of the script's blocks, indexed by `Block::stateIndex`.
+    std::vector<BlockState> states;
 };
 
 struct Monitor {
     std::string id;
     std::string mode;
     std::string opcode;
+    Opcode opcodeId = Opcode::UNKNOWN;
     std::unordered_map<std::string, std::string> parameters;
     std::string spriteName;
     Value value;
@@ -153,6 +222,24 @@ struct Monitor {
     bool isDiscrete;
 };
 
+/**
+ * Scripts and assets of a Sprite. These never change after loading,
+ * so Clones share them with the Sprite they were cloned from instead of copying them.
+ */
+struct SpriteData {
+    std::unordered_map<std::string, Block> blocks;
+    std::map<std::string, Sound> sounds;
+    std::vector<Costume> costumes;
+    std::unordered_map<std::string, Comment> comments;
+    std::unordered_map<std::string, Broadcast> broadcasts;
+    std::unordered_map<std::string, CustomBlock> customBlocks;
+    std::vector<Instruction> bytecode;
+    std::vector<size_t> scriptStateCounts; // number of `BlockState`s each script needs
+    std::vector<Block *> hats;             // top level event blocks, see `Compiler::isHat()`
+    std::unordered_map<std::string, uint32_t> variableSlots; // variable ID -> index in `Sprite::variables`
+    std::unordered_map<std::string, uint32_t> listSlots;     // list ID -> index in `Sprite::lists`
+};
+
 class Sprite {
   public:
     std::string name;
@@ -163,6 +250,7 @@ class Sprite {
     bool isClone;
     bool toDelete;
     bool isDeleted = false;
+    Sprite *nextFree = nullptr; // next deleted Clone in the `Sprite Pool`
     bool shouldDoSpriteClick = false;
     int currentCostume;
     float volume;
@@ -172,7 +260,9 @@ class Sprite {
     int rotationCenterY;
     float size;
     float rotation;
-    int layer;
+    int layer; // larger is in front, see `Layers`
+    Sprite *layerAbove = nullptr;
+    Sprite *layerBelow = nullptr;
     RenderInfo renderInfo;
 
     float ghostEffect;
@@ -186,7 +276,7 @@ class Sprite {
     };
 
     RotationStyle rotationStyle;
-    std::vector<std::pair<double, double>> collisionPoints;
+    CollisionBox collisionBox;
     int spriteWidth;
     int spriteHeight;
 
@@ -197,26 +287,22 @@ class Sprite {
         double transparency = 0;
     } penData;
 
-    std::unordered_map<std::string, Variable> variables;
-    std::unordered_map<std::string, Block> blocks;
-    std::unordered_map<std::string, List> lists;
-    std::map<std::string, Sound> sounds;
-    std::vector<Costume> costumes;
-    std::unordered_map<std::string, Comment> comments;
-    std::unordered_map<std::string, Broadcast> broadcasts;
-    std::unordered_map<std::string, CustomBlock> customBlocks;
-    std::unordered_map<std::string, BlockChain> blockChains;
+    // shared with Clones. Only loaded Sprites make one (see `newLoadedSprite()`), so empty Clone slots in the Pool stay small
+    std::shared_ptr<SpriteData> data;
+
+    // indexed by `VariableRef::slot`, see `data->variableSlots` and `data->listSlots`
+    std::vector<Variable> variables;
+    std::vector<List> lists;
+    // arguments of the custom blocks this Sprite is running. Never copied to Clones
+    std::unordered_map<std::string, std::unordered_map<std::string, Value>> customBlockArguments;
+
+    // running scripts, indexed by `Block::scriptIndex`. Never copied to Clones
+    std::vector<ScriptThread> threads;
 
     ~Sprite() {
         variables.clear();
-        blocks.clear();
         lists.clear();
-        sounds.clear();
-        costumes.clear();
-        comments.clear();
-        broadcasts.clear();
-        customBlocks.clear();
-        blockChains.clear();
-        collisionPoints.clear();
+        threads.clear();
+        customBlockArguments.clear();
     }
 };
@@ -0,0 +1,112 @@
+#include "trace.hpp"
+#ifdef ENABLE_TRACE
+#include "os.hpp"
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+std::atomic<Trace::ThreadBuffer *> Trace::buffers{nullptr};
+
+namespace {
+
+const std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+std::atomic<uint32_t> nextThreadId{1};
+
+uint64_t sinceStart(std::chrono::steady_clock::time_point time) {
+    if (time < traceStart) return 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - traceStart).count();
+}
+
+// gives the buffer back once its thread exits, so the next thread that starts can reuse it instead of allocating another one
+template <typename Buffer>
+struct BufferOwner {
+    Buffer *buffer = nullptr;
+    ~BufferOwner() {
+        if (buffer != nullptr) buffer->inUse.store(false, std::memory_order_release);
+    }
+};
+
+} // namespace
+
+Trace::ThreadBuffer *Trace::getThreadBuffer() {
+    static thread_local BufferOwner<ThreadBuffer> owner;
+    if (owner.buffer != nullptr) return owner.buffer;
+
+    for (ThreadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        bool inUse = false;
+        if (buffer->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+            std::lock_guard lock(buffer->nameMutex);
+            buffer->name = "Thread " + std::to_string(buffer->id);
+            owner.buffer = buffer;
+            return buffer;
+        }
+    }
+
+    // named before it's published, so nothing else can see it yet
+    ThreadBuffer *buffer = new ThreadBuffer();
+    buffer->id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    buffer->name = "Thread " + std::to_string(buffer->id);
+    buffer->next = buffers.load(std::memory_order_relaxed);
+    while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    owner.buffer = buffer;
+    return buffer;
+}
+
+void Trace::setThreadName(const std::string &name) {
+    ThreadBuffer *buffer = getThreadBuffer();
+    std::lock_guard lock(buffer->nameMutex);
+    buffer->name = name;
+}
+
+void Trace::record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    ThreadBuffer *buffer = getThreadBuffer();
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % bufferSize] = {name, sinceStart(start), sinceStart(end) - sinceStart(start)};
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::dumpJson(const std::string &path) {
+    nlohmann::json events = nlohmann::json::array();
+    std::vector<TraceEvent> copied;
+    for (ThreadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        std::string name;
+        {
+            std::lock_guard lock(buffer->nameMutex);
+            name = buffer->name;
+        }
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buffer->id}, {"args", {{"name", name}}}});
+
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t first = written > bufferSize ? written - bufferSize : 0;
+        copied.assign(bufferSize, {});
+        for (uint64_t i = first; i < written; i++) {
+            copied[i % bufferSize] = buffer->events[i % bufferSize];
+        }
+
+        // anything the thread may have overwritten while copying (including the slot it might be writing right now) is skipped
+        const uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+        const uint64_t valid = writtenAfter + 1 > bufferSize ? writtenAfter + 1 - bufferSize : 0;
+        for (uint64_t i = std::max(first, valid); i < written; i++) {
+            const TraceEvent &event = copied[i % bufferSize];
+            events.push_back({{"name", event.name},
+                              {"ph", "X"},
+                              {"pid", 1},
+                              {"tid", buffer->id},
+                              {"ts", event.startNs / 1000.0},
+                              {"dur", event.durationNs / 1000.0}});
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file) {
+        Log::logWarning("Failed to write trace to " + path);
+        return false;
+    }
+    file << nlohmann::json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump() << std::endl;
+    Log::log("Wrote trace to " + path);
+    return true;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * One finished span, as recorded by `TraceSpan`.
+ */
+struct TraceEvent {
+    const char *name; // must outlive the trace, so string literals only
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+/**
+ * Records timed spans into a Chrome/Perfetto trace, to find which phase of which frame took too long.
+ * Only compiled in when building with `SE_TRACE` (`ENABLE_TRACE`). Use `TRACE_SPAN("name")` to time the rest of a scope,
+ * which compiles to nothing otherwise.
+ * Every thread records into its own fixed-size ring buffer without locking, so only the most recent events of each thread are kept.
+ * Once a thread exits, its buffer (and its row in the trace) is reused by the next thread that records something.
+ */
+class Trace {
+  public:
+    /**
+     * Names the calling thread in the trace. Threads that aren't named show up as "Thread <id>".
+     * @param name
+     */
+    static void setThreadName(const std::string &name);
+
+    /**
+     * Adds a finished span to the calling thread's buffer.
+     * @param name Name of the span. Must be a string literal (or otherwise outlive the trace).
+     * @param start When the span started
+     * @param end When the span ended
+     */
+    static void record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /**
+     * Writes every recorded event in the Chrome trace event format, which can be opened in Perfetto or chrome://tracing.
+     * Can be called while other threads are still recording; events they overwrite during the dump are left out.
+     * @param path Where to write the JSON
+     * @return `true` if the file was written.
+     */
+    static bool dumpJson(const std::string &path);
+
+    // events kept per thread, older ones get overwritten. At 24 bytes each, consoles with little memory keep fewer
+#if defined(__NDS__)
+    static constexpr size_t bufferSize = 1 << 10;
+#elif defined(__3DS__) || defined(__PSP__) || defined(__OGC__)
+    static constexpr size_t bufferSize = 1 << 12;
+#else
+    static constexpr size_t bufferSize = 1 << 16;
+#endif
+
+  private:
+    struct ThreadBuffer {
+        uint32_t id;
+        // the owning thread can rename it while another one dumps the trace, so it's only touched under `nameMutex`
+        std::mutex nameMutex;
+        std::string name;
+        std::atomic<uint64_t> written{0};
+        std::atomic<bool> inUse{true}; // whether a running thread records into it
+        TraceEvent events[bufferSize];
+        ThreadBuffer *next = nullptr;
+    };
+
+    static ThreadBuffer *getThreadBuffer();
+    // every thread's buffer, newest first. Buffers are only ever added, so it can be read without locking
+    static std::atomic<ThreadBuffer *> buffers;
+};
+
+/**
+ * Times everything until it goes out of scope, and records it as a span. Use `TRACE_SPAN` instead of this directly.
+ */
+class TraceSpan {
+  public:
+    explicit TraceSpan(const char *name) : name(name), start(std::chrono::steady_clock::now()) {}
+
+    ~TraceSpan() {
+        Trace::record(name, start, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+  private:
+    const char *name;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef ENABLE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) ((void)0)
+#endif
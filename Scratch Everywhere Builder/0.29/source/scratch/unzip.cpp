@@ -1,6 +1,9 @@
 #include "unzip.hpp"
 #include "image.hpp"
 #include "menus/loading.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #ifdef __3DS__
 #include <3ds.h>
@@ -10,7 +13,6 @@
 
 #if defined(__PC__) || defined(__PSP__)
 #include <cmrc/cmrc.hpp>
-#include <sstream>
 
 CMRC_DECLARE(romfs);
 #endif
@@ -21,11 +23,10 @@ volatile bool Unzip::threadFinished = false;
 std::string Unzip::filePath = "";
 mz_zip_archive Unzip::zipArchive;
 std::vector<char> Unzip::zipBuffer;
+std::string_view Unzip::projectData;
+MappedFile Unzip::mappedProject;
+std::unordered_map<std::string, Unzip::ZipEntry> Unzip::zipEntries;
 bool Unzip::UnpackedInSD = false;
-void *Unzip::trackedBufferPtr = nullptr;
-size_t Unzip::trackedBufferSize = 0;
-void *Unzip::trackedJsonPtr = nullptr;
-size_t Unzip::trackedJsonSize = 0;
 
 int Unzip::openFile(std::istream *&file) {
     Log::log("Unzipping Scratch project...");
@@ -42,28 +43,37 @@ int Unzip::openFile(std::istream *&file) {
     const auto &fs = cmrc::romfs::get_filesystem();
 #endif
 
+    // projects in romfs on PC and PSP (which is built into the executable) and .sb3 files that can be mapped
+    // are read in place instead of copied into a stream
+    projectData = {};
+    mappedProject.close();
+
     // Unzipped Project in romfs:/
+    projectType = UNZIPPED;
 #if defined(__PC__) || defined(__PSP__)
     if (fs.exists(unzippedPath)) {
         const auto &romfsFile = fs.open(unzippedPath);
-        const std::string_view content(romfsFile.begin(), romfsFile.size());
-        file = new std::istringstream(std::string(content));
+        projectData = std::string_view(romfsFile.begin(), romfsFile.size());
+        return 1;
     }
 #else
     file = new std::ifstream(unzippedPath, std::ios::binary | std::ios::ate);
-#endif
-    projectType = UNZIPPED;
     if (file != nullptr && *file) return 1;
+#endif
     // .sb3 Project in romfs:/
     Log::logWarning("No unzipped project, trying embedded.");
     projectType = EMBEDDED;
 #if defined(__PC__) || defined(__PSP__)
     if (fs.exists(embeddedFilename)) {
         const auto &romfsFile = fs.open(embeddedFilename);
-        const std::string_view content(romfsFile.begin(), romfsFile.size());
-        file = new std::istringstream(std::string(content));
+        projectData = std::string_view(romfsFile.begin(), romfsFile.size());
+        return 1;
     }
 #else
+    if (mappedProject.open(embeddedFilename)) {
+        projectData = mappedProject.data();
+        return 1;
+    }
     file = new std::ifstream(embeddedFilename, std::ios::binary | std::ios::ate);
 #endif
     if (file != nullptr && *file) return 1;
@@ -79,6 +89,10 @@ int Unzip::openFile(std::istream *&file) {
     // check if normal Project
     if (filePath.size() >= 4 && filePath.substr(filePath.size() - 4, filePath.size()) == ".sb3") {
         Log::log("Normal .sb3 project in SD card ");
+        if (mappedProject.open(filePath)) {
+            projectData = mappedProject.data();
+            return 1;
+        }
         file = new std::ifstream(filePath, std::ios::binary | std::ios::ate);
         if (!(*file)) {
             Log::logError("Couldnt find file. jinkies.");
@@ -103,26 +117,77 @@ int Unzip::openFile(std::istream *&file) {
     return 1;
 }
 
+void Unzip::indexZip() {
+    zipEntries.clear();
+    const mz_uint fileCount = mz_zip_reader_get_num_files(&zipArchive);
+    zipEntries.reserve(fileCount);
+    for (mz_uint i = 0; i < fileCount; i++) {
+        mz_zip_archive_file_stat fileStat;
+        if (!mz_zip_reader_file_stat(&zipArchive, i, &fileStat) || fileStat.m_is_directory) continue;
+
+        std::string name = fileStat.m_filename;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        // if two files only differ by case, keep the first like a search would
+        zipEntries.emplace(std::move(name), ZipEntry{static_cast<int>(i), static_cast<size_t>(fileStat.m_uncomp_size)});
+    }
+}
+
+void Unzip::closeArchive() {
+    mz_zip_reader_end(&zipArchive);
+    memset(&zipArchive, 0, sizeof(zipArchive));
+    zipEntries.clear();
+    MemoryTracker::untrack(zipBuffer.size());
+    zipBuffer.clear();
+    zipBuffer.shrink_to_fit();
+    mappedProject.close();
+    projectData = {};
+}
+
+int Unzip::findFile(mz_zip_archive *zip, const std::string &name, size_t *size) {
+    if (zip == &zipArchive && !zipEntries.empty()) {
+        std::string key = name;
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        auto entry = zipEntries.find(key);
+        if (entry == zipEntries.end()) return -1;
+        if (size != nullptr) *size = entry->second.size;
+        return entry->second.index;
+    }
+
+    const int index = mz_zip_reader_locate_file(zip, name.c_str(), nullptr, 0);
+    if (index >= 0 && size != nullptr) {
+        mz_zip_archive_file_stat fileStat;
+        if (!mz_zip_reader_file_stat(zip, index, &fileStat)) return -1;
+        *size = static_cast<size_t>(fileStat.m_uncomp_size);
+    }
+    return index;
+}
+
 int projectLoaderThread(void *data) {
+#ifdef ENABLE_TRACE
+    Trace::setThreadName("Project loader");
+#endif
     Unzip::openScratchProject(NULL);
     return 0;
 }
 
 void loadInitialImages() {
+    TRACE_SPAN("loadInitialImages");
     Unzip::loadingState = "Loading images";
     int sprIndex = 1;
     if (projectType == UNZIPPED) {
         for (auto &currentSprite : sprites) {
             if (!currentSprite->visible || currentSprite->ghostEffect == 100) continue;
             Unzip::loadingState = "Loading image " + std::to_string(sprIndex) + " / " + std::to_string(sprites.size());
-            Image::loadImageFromFile(currentSprite->costumes[currentSprite->currentCostume].fullName, currentSprite);
+            TRACE_SPAN("Image::loadImageFromFile");
+            Image::loadImageFromFile(currentSprite->data->costumes[currentSprite->currentCostume].fullName, currentSprite);
             sprIndex++;
         }
     } else {
         for (auto &currentSprite : sprites) {
             if (!currentSprite->visible || currentSprite->ghostEffect == 100) continue;
             Unzip::loadingState = "Loading image " + std::to_string(sprIndex) + " / " + std::to_string(sprites.size());
-            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->costumes[currentSprite->currentCostume].fullName, currentSprite);
+            TRACE_SPAN("Image::loadImageFromSB3");
+            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->data->costumes[currentSprite->currentCostume].fullName, currentSprite);
             sprIndex++;
         }
     }
@@ -133,9 +198,7 @@ bool Unzip::load() {
     Unzip::threadFinished = false;
     Unzip::projectOpened = 0;
 
-#ifdef ENABLE_LOADSCREEN
-
-#ifdef __3DS__ // create 3DS thread for loading screen
+#if defined(ENABLE_LOADSCREEN) && defined(__3DS__) // create 3DS thread for loading screen
     s32 mainPrio = 0;
     svcGetThreadPriority(&mainPrio, CUR_THREAD_HANDLE);
 
@@ -167,7 +230,7 @@ bool Unzip::load() {
     loading.cleanup();
     osSetSpeedupEnable(false);
 
-#elif defined(SDL_BUILD) // create SDL2 thread for loading screen
+#elif defined(ENABLE_LOADSCREEN) && defined(SDL_BUILD) // create SDL2 thread for loading screen
 
     SDL_Thread *thread = SDL_CreateThreadWithStackSize(projectLoaderThread, "LoadingScreen", 0x15000, nullptr);
 
@@ -185,10 +248,9 @@ bool Unzip::load() {
 
     if (Unzip::projectOpened != 1)
         return false;
-#endif
 #else
 
-    // non-threaded loading
+    // non-threaded loading, also used by platforms without a loading screen like headless
     Unzip::openScratchProject(NULL);
     if (Unzip::projectOpened != 1)
         return false;
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "interpret.hpp"
+#include "mappedFile.hpp"
 #include "miniz.h"
 #include "os.hpp"
+#include "trace.hpp"
 #include <filesystem>
 #include <fstream>
 #include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #ifdef __NDS__
 #include <cstring>
 #include <dirent.h>
@@ -27,17 +32,50 @@ class Unzip {
     static bool UnpackedInSD;
     static mz_zip_archive zipArchive;
     static std::vector<char> zipBuffer;
-    static void *trackedBufferPtr;
-    static size_t trackedBufferSize;
-    static void *trackedJsonPtr;
-    static size_t trackedJsonSize;
+    // the project's bytes when they're already in memory, in which case `openFile()` doesn't open a stream
+    static std::string_view projectData;
+    // the project's .sb3, where it can be mapped into memory instead of read into `zipBuffer`
+    static MappedFile mappedProject;
+
+    struct ZipEntry {
+        int index;
+        size_t size; // uncompressed, in bytes
+    };
+    // every file in `zipArchive` by lowercased name, built once when it's opened so assets can be found without scanning it
+    static std::unordered_map<std::string, ZipEntry> zipEntries;
+
+    /**
+     * Builds `zipEntries` from `zipArchive`.
+     */
+    static void indexZip();
+
+    /**
+     * Finds a file in a zip archive, ignoring case like `mz_zip_reader_locate_file()`.
+     * Files in the project's archive are looked up in `zipEntries`, other archives are searched.
+     * @param zip The archive to look in
+     * @param name The file's name, like a costume's `md5ext`
+     * @param size If not `nullptr`, set to the file's uncompressed size when it's found
+     * @return The file's index in the archive, or -1 if it isn't there.
+     */
+    static int findFile(mz_zip_archive *zip, const std::string &name, size_t *size = nullptr);
+
+    /**
+     * Closes the project's archive and frees or unmaps its bytes, along with their memory tracking.
+     * Safe to call when nothing is open.
+     */
+    static void closeArchive();
 
     static void openScratchProject(void *arg) {
+        TRACE_SPAN("Unzip::openScratchProject");
         loadingState = "Opening Scratch project";
         Unzip::UnpackedInSD = false;
         std::istream *file = nullptr;
 
-        int isFileOpen = openFile(file);
+        int isFileOpen;
+        {
+            TRACE_SPAN("Unzip::openFile");
+            isFileOpen = openFile(file);
+        }
         if (isFileOpen == 0) {
             Log::logError("Failed to open Scratch project.");
             Unzip::projectOpened = -1;
@@ -50,16 +88,43 @@ class Unzip {
             return;
         }
         loadingState = "Unzipping Scratch project";
-        nlohmann::json project_json = unzipProject(file);
+        std::string buffer;
+        std::string_view project_json;
+        {
+            TRACE_SPAN("Unzip::unzipProject");
+            project_json = unzipProject(file, buffer);
+        }
         if (project_json.empty()) {
             Log::logError("Project.json is empty.");
+            closeArchive();
             Unzip::projectOpened = -2;
             Unzip::threadFinished = true;
             delete file;
             return;
         }
         loadingState = "Loading Sprites";
-        loadSprites(project_json);
+        bool loaded;
+        {
+            TRACE_SPAN("streamSprites");
+            // only count project.json if it had to be read into memory
+            MemoryTracker::track(buffer.size());
+            loaded = streamSprites(project_json);
+            MemoryTracker::untrack(buffer.size());
+        }
+        if (!loaded) {
+            Log::logError("Failed to load project.json.");
+            closeArchive();
+            Unzip::projectOpened = -2;
+            Unzip::threadFinished = true;
+            delete file;
+            return;
+        }
+#ifdef ENABLE_CLOUDVARS
+        // only copied when it's read in place from romfs
+        projectJSON = buffer.empty() ? std::string(project_json) : std::move(buffer);
+        // it's kept until the project is cleaned up, so it counts until then too
+        MemoryTracker::track(projectJSON.size());
+#endif
         Unzip::projectOpened = 1;
         Unzip::threadFinished = true;
         delete file;
@@ -186,82 +251,67 @@ class Unzip {
         return splash;
     }
 
-    static nlohmann::json unzipProject(std::istream *file) {
-        nlohmann::json project_json;
-
+    /**
+     * Finds the text of the project's project.json, extracting it from the .sb3 if the project is zipped.
+     * The .sb3 is opened in place if it's already in memory or mapped, and otherwise read into `zipBuffer`.
+     * @param file The opened project, or `nullptr` if it's in `projectData`
+     * @param buffer Where project.json is read to, if it isn't already in memory
+     * @return The text of project.json, or an empty view if it couldn't be read.
+     */
+    static std::string_view unzipProject(std::istream *file, std::string &buffer) {
         if (projectType != UNZIPPED) {
-            // read the file
-            Log::log("Reading SB3...");
-            std::streamsize size = file->tellg();
-            file->seekg(0, std::ios::beg);
-            zipBuffer.resize(size);
-            if (!file->read(zipBuffer.data(), size)) {
-                return project_json;
+            std::string_view zipData = projectData;
+            if (zipData.empty()) {
+                // read the file
+                Log::log("Reading SB3...");
+                std::streamsize size = file->tellg();
+                file->seekg(0, std::ios::beg);
+                zipBuffer.resize(size);
+                MemoryTracker::track(zipBuffer.size());
+                if (!file->read(zipBuffer.data(), size)) {
+                    return {};
+                }
+                zipData = std::string_view(zipBuffer.data(), zipBuffer.size());
             }
 
-            // Use RAW allocation function and store both pointer and size
-            trackedBufferSize = zipBuffer.size();
-            trackedBufferPtr = MemoryTracker::allocate(trackedBufferSize);
-
             // open ZIP file
             Log::log("Opening SB3 file...");
             memset(&zipArchive, 0, sizeof(zipArchive));
-            if (!mz_zip_reader_init_mem(&zipArchive, zipBuffer.data(), zipBuffer.size(), 0)) {
-                return project_json;
+            if (!mz_zip_reader_init_mem(&zipArchive, zipData.data(), zipData.size(), 0)) {
+                return {};
             }
+            indexZip();
 
-            // extract project.json
+            // extract project.json straight into the buffer that gets parsed
             Log::log("Extracting project.json...");
-            int file_index = mz_zip_reader_locate_file(&zipArchive, "project.json", NULL, 0);
+            size_t json_size;
+            int file_index = findFile(&zipArchive, "project.json", &json_size);
             if (file_index < 0) {
-                return project_json;
+                return {};
             }
 
-            size_t json_size;
-            const char *json_data = static_cast<const char *>(mz_zip_reader_extract_to_heap(&zipArchive, file_index, &json_size, 0));
-
-#ifdef ENABLE_CLOUDVARS
-            projectJSON = std::string(json_data, json_size);
-#endif
-
-            // Parse JSON file
-            Log::log("Parsing project.json...");
-            // Use RAW allocation and store pointer + size
-            trackedJsonSize = json_size;
-            trackedJsonPtr = MemoryTracker::allocate(trackedJsonSize);
-
-            project_json = nlohmann::json::parse(std::string(json_data, json_size));
-            mz_free((void *)json_data);
-
-            // FIXED: Use RAW deallocate function
-            if (trackedJsonPtr) {
-                MemoryTracker::deallocate(trackedJsonPtr, trackedJsonSize);
-                trackedJsonPtr = nullptr;
-                trackedJsonSize = 0;
+            buffer.resize(json_size);
+            if (!mz_zip_reader_extract_to_mem(&zipArchive, file_index, buffer.data(), buffer.size(), 0)) {
+                buffer.clear();
             }
+            return buffer;
+        }
 
-        } else {
-            file->clear();
-            file->seekg(0, std::ios::beg);
-
-            // get file size
-            file->seekg(0, std::ios::end);
-            std::streamsize size = file->tellg();
-            file->seekg(0, std::ios::beg);
+        if (!projectData.empty()) return projectData;
 
-            // put file into string
-            std::string json_content;
-            json_content.reserve(size);
-            json_content.assign(std::istreambuf_iterator<char>(*file),
-                                std::istreambuf_iterator<char>());
+        file->clear();
+        file->seekg(0, std::ios::beg);
 
-#ifdef ENABLE_CLOUDVARS
-            projectJSON = json_content;
-#endif
+        // get file size
+        file->seekg(0, std::ios::end);
+        std::streamsize size = file->tellg();
+        file->seekg(0, std::ios::beg);
 
-            project_json = nlohmann::json::parse(json_content);
-        }
-        return project_json;
+        // put file into string
+        buffer.reserve(size);
+        buffer.assign(std::istreambuf_iterator<char>(*file),
+                      std::istreambuf_iterator<char>());
+        return buffer;
     }
 
     static int openFile(std::istream *&file);
@@ -320,13 +370,17 @@ class Unzip {
         }
     }
 
-    static nlohmann::json getSetting(const std::string &settingName) {
+    /**
+     * Reads the project's settings file (`filePath` + ".json") once.
+     * @return The file's "settings" object, or an empty object if there isn't one.
+     */
+    static nlohmann::json getSettings() {
         std::string folderPath = filePath + ".json";
 
         std::ifstream file(folderPath);
         if (!file.good()) {
             Log::logWarning("Project settings file not found: " + folderPath);
-            return nlohmann::json();
+            return nlohmann::json::object();
         }
 
         nlohmann::json json;
@@ -335,17 +389,14 @@ class Unzip {
         } catch (const nlohmann::json::parse_error &e) {
             Log::logError("Failed to parse JSON file: " + std::string(e.what()));
             file.close();
-            return nlohmann::json();
+            return nlohmann::json::object();
         }
         file.close();
 
-        if (!json.contains("settings")) {
-            return nlohmann::json();
-        }
-        if (!json["settings"].contains(settingName)) {
-            return nlohmann::json();
+        if (!json.is_object() || !json.contains("settings") || !json["settings"].is_object()) {
+            return nlohmann::json::object();
         }
 
-        return json["settings"][settingName];
+        return json["settings"];
     }
 };
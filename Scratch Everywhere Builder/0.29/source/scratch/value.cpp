@@ -3,25 +3,208 @@
 #include "os.hpp"
 #include <regex>
 
-Value::Value(int val) : value(val) {}
+namespace {
+int compareIgnoreCase(std::string_view a, std::string_view b) {
+    const size_t length = std::min(a.size(), b.size());
+    for (size_t i = 0; i < length; i++) {
+        const unsigned char charA = static_cast<unsigned char>(::tolower(static_cast<unsigned char>(a[i])));
+        const unsigned char charB = static_cast<unsigned char>(::tolower(static_cast<unsigned char>(b[i])));
+        if (charA != charB) return charA < charB ? -1 : 1;
+    }
+    if (a.size() == b.size()) return 0;
+    return a.size() < b.size() ? -1 : 1;
+}
+} // namespace
+
+std::unordered_map<std::string_view, Value::StringData *> &Value::internedStrings() {
+    static std::unordered_map<std::string_view, StringData *> strings;
+    return strings;
+}
+
+Value::Value(int val) : type(Type::INTEGER) {
+    store(val);
+}
+
+Value::Value(double val) : type(Type::DOUBLE) {
+    store(val);
+}
+
+Value::Value(std::string val) {
+    setString(std::move(val));
+}
+
+Value::Value(std::string_view val) {
+    setString(val);
+}
+
+Value::Value(const char *val) {
+    setString(std::string_view(val));
+}
 
-Value::Value(double val) : value(val) {}
+Value::Value(bool val) : type(Type::BOOLEAN) {
+    store(val);
+}
+
+Value::Value(Color val) : type(Type::COLOR) {
+    store(val);
+}
+
+Value::Value(const Value &other) : stringInfo(other.stringInfo), type(other.type) {
+    std::memcpy(storage, other.storage, SMALL_STRING_CAPACITY);
+    retain();
+}
+
+Value::Value(Value &&other) noexcept : stringInfo(other.stringInfo), type(other.type) {
+    std::memcpy(storage, other.storage, SMALL_STRING_CAPACITY);
+    other.stringInfo = 0;
+    other.type = Type::STRING;
+}
 
-Value::Value(std::string val) : value(std::move(val)) {}
+Value &Value::operator=(const Value &other) {
+    if (this == &other) return *this;
+    release();
+    std::memcpy(storage, other.storage, SMALL_STRING_CAPACITY);
+    stringInfo = other.stringInfo;
+    type = other.type;
+    retain();
+    return *this;
+}
+
+Value &Value::operator=(Value &&other) noexcept {
+    if (this == &other) return *this;
+    release();
+    std::memcpy(storage, other.storage, SMALL_STRING_CAPACITY);
+    stringInfo = other.stringInfo;
+    type = other.type;
+    other.stringInfo = 0;
+    other.type = Type::STRING;
+    return *this;
+}
 
-Value::Value(bool val) : value(val) {}
+Value::~Value() {
+    release();
+}
+
+void Value::setString(std::string_view val) {
+    type = Type::STRING;
+    if (val.size() <= SMALL_STRING_CAPACITY) {
+        std::memcpy(storage, val.data(), val.size());
+        stringInfo = static_cast<uint8_t>(val.size());
+        return;
+    }
+    setString(std::string(val));
+}
+
+void Value::setString(std::string &&val) {
+    type = Type::STRING;
+    if (val.size() <= SMALL_STRING_CAPACITY) {
+        std::memcpy(storage, val.data(), val.size());
+        stringInfo = static_cast<uint8_t>(val.size());
+        return;
+    }
+    store(new StringData{1, false, std::move(val)});
+    stringInfo = HEAP_STRING;
+}
+
+void Value::retain() {
+    if (isHeapString()) load<StringData *>()->refCount++;
+}
+
+void Value::release() {
+    if (!isHeapString()) return;
+    StringData *data = load<StringData *>();
+    if (--data->refCount != 0) return;
+    if (data->interned) internedStrings().erase(data->text);
+    delete data;
+}
+
+bool Value::parseString(double &result) const {
+    if (isHeapString()) {
+        StringData *data = load<StringData *>();
+        if (data->numeric == NumericState::UNKNOWN)
+            data->numeric = Math::parseNumber(data->text, data->number) ? NumericState::NUMBER : NumericState::NOT_NUMBER;
+        result = data->number;
+        return data->numeric == NumericState::NUMBER;
+    }
+
+    const NumericState state = static_cast<NumericState>(stringInfo >> NUMERIC_SHIFT);
+    const size_t size = stringInfo & SIZE_MASK;
+    if (state == NumericState::NOT_NUMBER) {
+        result = 0;
+        return false;
+    }
+    if (state == NumericState::NUMBER) {
+        std::memcpy(&result, storage + NUMBER_CACHE_OFFSET, sizeof(double));
+        return true;
+    }
+
+    const bool isNumber = Math::parseNumber(std::string_view(storage, size), result);
+    if (!isNumber) {
+        stringInfo |= static_cast<uint8_t>(NumericState::NOT_NUMBER) << NUMERIC_SHIFT;
+    } else if (size <= NUMBER_CACHE_OFFSET) {
+        std::memcpy(storage + NUMBER_CACHE_OFFSET, &result, sizeof(double));
+        stringInfo |= static_cast<uint8_t>(NumericState::NUMBER) << NUMERIC_SHIFT;
+    } else {
+        // the number would overlap the characters, so keep both in a StringData instead (like "12345.67" in a list)
+        StringData *data = new StringData{1, false, std::string(storage, size), NumericState::NUMBER, result};
+        std::memcpy(storage, &data, sizeof(StringData *));
+        stringInfo = HEAP_STRING;
+    }
+    return isNumber;
+}
+
+Value Value::intern(std::string_view val) {
+    if (val.size() <= SMALL_STRING_CAPACITY) {
+        Value result(val);
+        result.isNumeric();
+        return result;
+    }
+
+    Value result;
+    auto &strings = internedStrings();
+    auto it = strings.find(val);
+    StringData *data;
+    if (it != strings.end()) {
+        data = it->second;
+        data->refCount++;
+    } else {
+        data = new StringData{1, true, std::string(val)};
+        strings[data->text] = data;
+    }
+    result.store(data);
+    result.stringInfo = HEAP_STRING;
+    return result;
+}
+
+Value Value::concat(const Value &a, const Value &b) {
+    std::string bufferA;
+    std::string bufferB;
+    const std::string_view stringA = a.isString() ? a.stringView() : std::string_view(bufferA = a.asString());
+    const std::string_view stringB = b.isString() ? b.stringView() : std::string_view(bufferB = b.asString());
+
+    Value result;
+    if (stringA.size() + stringB.size() <= SMALL_STRING_CAPACITY) {
+        std::memcpy(result.storage, stringA.data(), stringA.size());
+        std::memcpy(result.storage + stringA.size(), stringB.data(), stringB.size());
+        result.stringInfo = static_cast<uint8_t>(stringA.size() + stringB.size());
+        return result;
+    }
+    std::string joined;
+    joined.reserve(stringA.size() + stringB.size());
+    joined.append(stringA);
+    joined.append(stringB);
+    result.setString(std::move(joined));
+    return result;
+}
 
 double Value::asDouble() const {
     if (isDouble()) {
         if (isNaN()) return 0.0;
-        return std::get<double>(value);
+        return load<double>();
     } else if (isString()) {
-        auto &strValue = std::get<std::string>(value);
-        try {
-            return Math::parseNumber(strValue);
-        } catch (...) {
-            return 0.0;
-        }
+        double number;
+        parseString(number);
+        return number;
     } else if (isColor() || isInteger() || isBoolean()) {
         return static_cast<double>(asInt());
     }
@@ -31,12 +214,12 @@ double Value::asDouble() const {
 
 int Value::asInt() const {
     if (isInteger()) {
-        return std::get<int>(value);
+        return load<int>();
     } else if (isDouble()) {
-        auto doubleValue = std::get<double>(value);
+        auto doubleValue = load<double>();
         return static_cast<int>(std::round(doubleValue));
     } else if (isString()) {
-        auto &strValue = std::get<std::string>(value);
+        const std::string_view strValue = stringView();
 
         if (strValue == "Infinity") {
             return std::numeric_limits<int>::infinity();
@@ -46,13 +229,14 @@ int Value::asInt() const {
             return -std::numeric_limits<int>::infinity();
         }
 
-        if (Math::isNumber(strValue)) {
-            return static_cast<int>(std::round(Math::parseNumber(strValue)));
+        double number;
+        if (parseString(number)) {
+            return static_cast<int>(std::round(number));
         }
     } else if (isBoolean()) {
-        return std::get<bool>(value) ? 1 : 0;
+        return load<bool>() ? 1 : 0;
     } else if (isColor()) {
-        const ColorRGB rgb = CSB2RGB(std::get<Color>(value));
+        const ColorRGB rgb = CSB2RGB(load<Color>());
         return rgb.r * 0x10000 + rgb.g * 0x100 + rgb.b;
     }
 
@@ -61,20 +245,20 @@ int Value::asInt() const {
 
 std::string Value::asString() const {
     if (isInteger()) {
-        return std::to_string(std::get<int>(value));
+        return std::to_string(load<int>());
     } else if (isDouble()) {
-        double doubleValue = std::get<double>(value);
+        double doubleValue = load<double>();
         // handle whole numbers too, because scratch i guess
         if (std::isnan(doubleValue)) return "NaN";
         if (std::isinf(doubleValue)) return std::signbit(doubleValue) ? "-Infinity" : "Infinity";
         if (std::floor(doubleValue) == doubleValue) return std::to_string(static_cast<int>(doubleValue));
         return std::to_string(doubleValue);
     } else if (isString()) {
-        return std::get<std::string>(value);
+        return std::string(stringView());
     } else if (isBoolean()) {
-        return std::get<bool>(value) ? "true" : "false";
+        return load<bool>() ? "true" : "false";
     } else if (isColor()) {
-        const ColorRGB rgb = CSB2RGB(std::get<Color>(value));
+        const ColorRGB rgb = CSB2RGB(load<Color>());
         const char hex_chars[] = "0123456789abcdef";
         const unsigned char r = static_cast<unsigned char>(rgb.r);
         const unsigned char g = static_cast<unsigned char>(rgb.g);
@@ -94,19 +278,20 @@ std::string Value::asString() const {
 
 bool Value::asBoolean() const {
     if (isBoolean()) {
-        return std::get<bool>(value);
+        return load<bool>();
     }
     if (isInteger()) {
-        return std::get<int>(value) != 0;
+        return load<int>() != 0;
     }
     if (isDouble()) {
-        return std::get<double>(value) != 0.0 && !isNaN();
+        return load<double>() != 0.0 && !isNaN();
     }
     if (isString()) {
-        return std::get<std::string>(value) != "" && std::get<std::string>(value) != "0" && std::get<std::string>(value) != "false";
+        const std::string_view strValue = stringView();
+        return strValue != "" && strValue != "0" && strValue != "false";
     }
     if (isColor()) {
-        const ColorRGB rgb = CSB2RGB(std::get<Color>(value));
+        const ColorRGB rgb = CSB2RGB(load<Color>());
         return rgb.r != 0 || rgb.g != 0 || rgb.b != 0;
     }
     return false;
@@ -114,16 +299,16 @@ bool Value::asBoolean() const {
 
 Color Value::asColor() const {
     if (isInteger()) {
-        const int &intValue = std::get<int>(value);
+        const int &intValue = load<int>();
         return RGB2CSB({static_cast<float>(intValue / 0x10000), static_cast<float>((intValue / 0x100) % 0x100), static_cast<float>(intValue % 0x100)});
     }
     if (isDouble()) {
-        const double &doubleValue = std::get<double>(value);
+        const double &doubleValue = load<double>();
         return RGB2CSB({static_cast<float>(doubleValue / 0x10000), static_cast<float>(static_cast<int>(doubleValue / 0x100) % 0x100), static_cast<float>(static_cast<int>(doubleValue) % 0x100)});
     }
-    if (isColor()) return std::get<Color>(value);
+    if (isColor()) return load<Color>();
     if (isString()) {
-        const std::string &stringValue = std::get<std::string>(value);
+        const std::string stringValue = asString();
         if (!std::regex_match(stringValue, std::regex("^#[\\dA-Fa-f]{6}$"))) return {0, 0, 0};
         const int intValue = std::stoi(stringValue.substr(1), 0, 16);
         return RGB2CSB({static_cast<float>(intValue / 0x10000), static_cast<float>((intValue / 0x100) % 0x100), static_cast<float>(intValue % 0x100)});
@@ -182,11 +367,12 @@ bool Value::operator==(const Value &other) const {
         return asDouble() == other.asDouble();
     }
 
-    std::string string1 = asString();
-    std::string string2 = other.asString();
-    std::transform(string1.begin(), string1.end(), string1.begin(), ::tolower);
-    std::transform(string2.begin(), string2.end(), string2.begin(), ::tolower);
-    return string1 == string2;
+    // compare the strings without copying them if they already are strings
+    std::string buffer1;
+    std::string buffer2;
+    const std::string_view string1 = isString() ? stringView() : std::string_view(buffer1 = asString());
+    const std::string_view string2 = other.isString() ? other.stringView() : std::string_view(buffer2 = other.asString());
+    return compareIgnoreCase(string1, string2) == 0;
 }
 
 bool Value::operator<(const Value &other) const {
@@ -194,11 +380,12 @@ bool Value::operator<(const Value &other) const {
         return asDouble() < other.asDouble();
     }
 
-    std::string string1 = asString();
-    std::string string2 = other.asString();
-    std::transform(string1.begin(), string1.end(), string1.begin(), ::tolower);
-    std::transform(string2.begin(), string2.end(), string2.begin(), ::tolower);
-    return string1 < string2;
+    // compare the strings without copying them if they already are strings
+    std::string buffer1;
+    std::string buffer2;
+    const std::string_view string1 = isString() ? stringView() : std::string_view(buffer1 = asString());
+    const std::string_view string2 = other.isString() ? other.stringView() : std::string_view(buffer2 = other.asString());
+    return compareIgnoreCase(string1, string2) < 0;
 }
 
 bool Value::operator>(const Value &other) const {
@@ -206,11 +393,12 @@ bool Value::operator>(const Value &other) const {
         return asDouble() > other.asDouble();
     }
 
-    std::string string1 = asString();
-    std::string string2 = other.asString();
-    std::transform(string1.begin(), string1.end(), string1.begin(), ::tolower);
-    std::transform(string2.begin(), string2.end(), string2.begin(), ::tolower);
-    return string1 > string2;
+    // compare the strings without copying them if they already are strings
+    std::string buffer1;
+    std::string buffer2;
+    const std::string_view string1 = isString() ? stringView() : std::string_view(buffer1 = asString());
+    const std::string_view string2 = other.isString() ? other.stringView() : std::string_view(buffer2 = other.asString());
+    return compareIgnoreCase(string1, string2) > 0;
 }
 
 bool Value::isScratchInt() {
@@ -230,7 +418,12 @@ bool Value::isScratchInt() {
 Value Value::fromJson(const nlohmann::json &jsonVal) {
     if (jsonVal.is_number_integer()) return Value(jsonVal.get<int>());
     if (jsonVal.is_number_float()) return Value(jsonVal.get<double>());
-    if (jsonVal.is_string()) return Value(jsonVal.get<std::string>());
+    if (jsonVal.is_string()) {
+        // parse strings now, so lists of numbers loaded from the project don't have to be parsed when they're used
+        Value val(std::string_view(jsonVal.get_ref<const std::string &>()));
+        val.isNumeric();
+        return val;
+    }
     if (jsonVal.is_boolean()) return Value(jsonVal.get<bool>());
     if (jsonVal.is_array()) {
         if (jsonVal.size() > 1) return fromJson(jsonVal[1]);
@@ -1,53 +1,148 @@
 #pragma once
 #include "color.hpp"
 #include "math.hpp"
+#include <cstdint>
+#include <cstring>
 #include <nlohmann/json.hpp>
 #include <string>
-
-#include <variant>
-
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * A Scratch value (number, string, boolean or color) packed into 16 bytes.
+ * Strings up to `SMALL_STRING_CAPACITY` characters are stored inline, so most Values never allocate.
+ * Inline strings with no room left for their parsed number are moved into a `StringData` the first time they're parsed as one.
+ * Longer strings are reference counted and shared between copies, and can be interned with `Value::intern()`
+ * so every Value with the same text uses the same allocation.
+ */
 class Value {
+  public:
+    enum class Type : uint8_t {
+        INTEGER,
+        DOUBLE,
+        STRING,
+        BOOLEAN,
+        COLOR
+    };
+
   private:
-    std::variant<int, double, std::string, bool, Color> value;
+    static constexpr size_t SMALL_STRING_CAPACITY = 14;
+    static constexpr uint8_t SIZE_MASK = 0x0F;
+    static constexpr uint8_t HEAP_STRING = 0x0F;
+    static constexpr uint8_t NUMERIC_SHIFT = 4;
+    // short inline strings keep their parsed number after the characters
+    static constexpr size_t NUMBER_CACHE_OFFSET = SMALL_STRING_CAPACITY - sizeof(double);
+
+    // whether a string has been parsed as a number yet, and what the result was
+    enum class NumericState : uint8_t {
+        UNKNOWN,
+        NUMBER,
+        NOT_NUMBER
+    };
+
+    struct StringData {
+        uint32_t refCount;
+        bool interned;
+        std::string text;
+        NumericState numeric = NumericState::UNKNOWN;
+        double number = 0; // cached `Math::parseNumber()` of `text`
+    };
+
+    // an int, double, bool, Color, `StringData*` or the characters of a short string
+    alignas(8) mutable char storage[SMALL_STRING_CAPACITY];
+    // low bits: length of an inline string, or `HEAP_STRING` if `storage` holds a `StringData*`.
+    // high bits: the `NumericState` of an inline string, cached by `parseString()`.
+    // If the string is a number, it's no longer than `NUMBER_CACHE_OFFSET` and the number is cached at the end of `storage`.
+    mutable uint8_t stringInfo = 0;
+    Type type = Type::STRING;
+
+    template <typename T>
+    inline T load() const {
+        T val;
+        std::memcpy(&val, storage, sizeof(T));
+        return val;
+    }
+    template <typename T>
+    inline void store(const T &val) {
+        std::memcpy(storage, &val, sizeof(T));
+    }
+    inline bool isHeapString() const {
+        return type == Type::STRING && (stringInfo & SIZE_MASK) == HEAP_STRING;
+    }
+
+    /**
+     * Parses a string Value as a number, caching the result so the string is only parsed once.
+     * A number too long to cache inline moves the string into a `StringData`, which copies made after this share.
+     * @param result Set to the number, or 0 if the string isn't a number.
+     * @return `true` if the string is a number.
+     */
+    bool parseString(double &result) const;
+
+    // interned strings by their text. Entries are removed when the last Value using them is destroyed
+    static std::unordered_map<std::string_view, StringData *> &internedStrings();
+
+    void setString(std::string_view val);
+    void setString(std::string &&val);
+    void retain();
+    void release();
 
   public:
     // constructors
-    Value() : value(std::string()) {}
+    Value() {}
 
     explicit Value(int val);
     explicit Value(double val);
     explicit Value(std::string val);
+    explicit Value(std::string_view val);
+    explicit Value(const char *val);
     explicit Value(bool val);
     explicit Value(Color val);
 
+    Value(const Value &other);
+    Value(Value &&other) noexcept;
+    Value &operator=(const Value &other);
+    Value &operator=(Value &&other) noexcept;
+    ~Value();
+
     // type checks
     inline bool isInteger() const {
-        return std::holds_alternative<int>(value);
+        return type == Type::INTEGER;
     }
     inline bool isDouble() const {
-        return std::holds_alternative<double>(value);
+        return type == Type::DOUBLE;
     }
     inline bool isString() const {
-        return std::holds_alternative<std::string>(value);
+        return type == Type::STRING;
     }
     inline bool isBoolean() const {
-        return std::holds_alternative<bool>(value);
+        return type == Type::BOOLEAN;
     }
     inline bool isColor() const {
-        return std::holds_alternative<Color>(value);
+        return type == Type::COLOR;
     }
     inline bool isNumeric() const {
         if (isInteger() || isDouble() || isBoolean()) {
             return true;
         } else if (isString()) {
-            auto &strValue = std::get<std::string>(value);
-            return Math::isNumber(strValue);
+            double number;
+            return parseString(number);
         }
 
         return false;
     }
     inline bool isNaN() const {
-        return isDouble() && std::isnan(std::get<double>(value));
+        return isDouble() && std::isnan(load<double>());
+    }
+
+    /**
+     * Gets the characters of a string Value without copying them.
+     * Only valid while the Value is alive and unchanged (including being parsed as a number), and if `isString()` is true.
+     * @return A view of the string, or an empty view if the Value isn't a string.
+     */
+    inline std::string_view stringView() const {
+        if (type != Type::STRING) return std::string_view();
+        if ((stringInfo & SIZE_MASK) == HEAP_STRING) return load<StringData *>()->text;
+        return std::string_view(storage, stringInfo & SIZE_MASK);
     }
 
     double asDouble() const;
@@ -79,5 +174,25 @@ class Value {
     // Used exclusively by the random block
     bool isScratchInt();
 
+    /**
+     * Joins the string forms of two Values, like Scratch's `join` block.
+     * Doesn't allocate if the result fits inline.
+     * @param a The first Value
+     * @param b The second Value
+     * @return A string Value with `a` followed by `b`.
+     */
+    static Value concat(const Value &a, const Value &b);
+
+    /**
+     * Creates a string Value that shares its allocation with every other interned Value with the same text.
+     * Used for literals in blocks, which are copied every time they're evaluated.
+     * Short strings aren't interned, but they're parsed as a number up front so every copy has it cached.
+     * @param val The text
+     * @return A string Value.
+     */
+    static Value intern(std::string_view val);
+
     static Value fromJson(const nlohmann::json &jsonVal);
 };
+
+static_assert(sizeof(Value) == 16, "Value should stay 16 bytes");
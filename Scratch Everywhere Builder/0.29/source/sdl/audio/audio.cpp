@@ -4,6 +4,9 @@
 #include "interpret.hpp"
 #include "miniz.h"
 #include "sprite.hpp"
+#include "trace.hpp"
+#include "unzip.hpp"
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #ifdef __3DS__
@@ -54,6 +57,7 @@ bool SoundPlayer::init() {
 }
 
 void SoundPlayer::startSoundLoaderThread(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed, const bool &fromProject) {
+    TRACE_SPAN("SoundPlayer::startSoundLoaderThread");
 #ifdef ENABLE_AUDIO
     if (!init()) return;
 
@@ -91,124 +95,104 @@ bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const st
 
     // Log::log("Loading sound: '" + soundId + "'");
 
-    int file_count = (int)mz_zip_reader_get_num_files(zip);
-    if (file_count <= 0) {
-        Log::logWarning("Error: No files found in zip archive");
-        return false;
-    }
-
-    for (int i = 0; i < file_count; i++) {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(zip, i, &file_stat)) continue;
-
-        std::string zipFileName = file_stat.m_filename;
-
-        bool isAudio = false;
-        std::string extension = "";
+    std::string lowerId = soundId;
+    std::transform(lowerId.begin(), lowerId.end(), lowerId.begin(), ::tolower);
+    const auto hasExtension = [&lowerId](const std::string &extension) {
+        return lowerId.size() >= extension.size() && lowerId.compare(lowerId.size() - extension.size(), extension.size(), extension) == 0;
+    };
+    const bool isAudio = hasExtension(".mp3") || hasExtension(".mpga") || hasExtension(".wav") || hasExtension(".ogg") || hasExtension(".oga");
+
+    const int file_index = isAudio ? Unzip::findFile(zip, soundId) : -1;
+    if (file_index >= 0) {
+        const std::string &zipFileName = soundId;
+
+        size_t file_size;
+        // Log::log("Extracting sound from sb3...");
+        void *file_data = mz_zip_reader_extract_to_heap(zip, file_index, &file_size, 0);
+        if (!file_data || file_size == 0) {
+            Log::logWarning("Failed to extract: " + zipFileName);
+            return false;
+        }
 
-        if (zipFileName.size() >= 4) {
-            std::string ext4 = zipFileName.substr(zipFileName.size() - 4);
-            std::transform(ext4.begin(), ext4.end(), ext4.begin(), ::tolower);
+        Mix_Music *music = nullptr;
+        Mix_Chunk *chunk = nullptr;
 
-            if (ext4 == ".mp3" || ext4 == ".mpga" || ext4 == ".wav" || ext4 == ".ogg" || ext4 == ".oga") {
-                isAudio = true;
-                extension = ext4;
+        if (!streamed) {
+            SDL_RWops *rw = SDL_RWFromMem(file_data, (int)file_size);
+            if (!rw) {
+                Log::logWarning("Failed to create RWops for: " + zipFileName);
+                mz_free(file_data);
+                return false;
             }
-        }
+            // Log::log("Converting sound into SDL sound...");
+            chunk = Mix_LoadWAV_RW(rw, 0);
 
-        if (isAudio) {
-            if (zipFileName != soundId) {
-                continue;
+            if (!chunk) {
+                Log::logWarning("Failed to load audio from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
+                mz_free(file_data);
+                return false;
             }
-
-            size_t file_size;
-            // Log::log("Extracting sound from sb3...");
-            void *file_data = mz_zip_reader_extract_to_heap(zip, i, &file_size, 0);
-            if (!file_data || file_size == 0) {
-                Log::logWarning("Failed to extract: " + zipFileName);
+        } else {
+            std::string tempDir = OS::getScratchFolderLocation() + "/cache";
+            std::string tempFile = tempDir + "/temp_" + soundId;
+
+            // make cache directory
+            try {
+                std::filesystem::create_directories(tempDir);
+            } catch (const std::exception &e) {
+                Log::logWarning(std::string("Failed to create temp directory: ") + e.what());
+                mz_free(file_data);
                 return false;
             }
 
-            Mix_Music *music = nullptr;
-            Mix_Chunk *chunk = nullptr;
-
-            if (!streamed) {
-                SDL_RWops *rw = SDL_RWFromMem(file_data, (int)file_size);
-                if (!rw) {
-                    Log::logWarning("Failed to create RWops for: " + zipFileName);
-                    mz_free(file_data);
-                    return false;
-                }
-                // Log::log("Converting sound into SDL sound...");
-                chunk = Mix_LoadWAV_RW(rw, 0);
-
-                if (!chunk) {
-                    Log::logWarning("Failed to load audio from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
-                    mz_free(file_data);
-                    return false;
-                }
-            } else {
-                std::string tempDir = OS::getScratchFolderLocation() + "/cache";
-                std::string tempFile = tempDir + "/temp_" + soundId;
-
-                // make cache directory
-                try {
-                    std::filesystem::create_directories(tempDir);
-                } catch (const std::exception &e) {
-                    Log::logWarning(std::string("Failed to create temp directory: ") + e.what());
-                    mz_free(file_data);
-                    return false;
-                }
-
-                FILE *fp = fopen(tempFile.c_str(), "wb");
-                if (!fp) {
-                    Log::logWarning("Failed to create temp file for streaming");
-                    mz_free(file_data);
-                    return false;
-                }
-
-                fwrite(file_data, 1, file_size, fp);
-                fclose(fp);
+            FILE *fp = fopen(tempFile.c_str(), "wb");
+            if (!fp) {
+                Log::logWarning("Failed to create temp file for streaming");
                 mz_free(file_data);
+                return false;
+            }
 
-                music = Mix_LoadMUS(tempFile.c_str());
+            fwrite(file_data, 1, file_size, fp);
+            fclose(fp);
+            mz_free(file_data);
 
-                // Clean up temp file
-                remove(tempFile.c_str());
+            music = Mix_LoadMUS(tempFile.c_str());
 
-                if (!music) {
-                    Log::logWarning("Failed to load music from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
-                    return false;
-                }
+            // Clean up temp file
+            remove(tempFile.c_str());
+
+            if (!music) {
+                Log::logWarning("Failed to load music from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
+                return false;
             }
+        }
 
-            // Log::log("Creating SDL sound object...");
+        // Log::log("Creating SDL sound object...");
 
-            // Create SDL_Audio object
-            auto it = SDL_Sounds.find(soundId);
-            if (it == SDL_Sounds.end()) {
-                std::unique_ptr<SDL_Audio> audio;
-                audio = std::make_unique<SDL_Audio>();
-                SDL_Sounds[soundId] = std::move(audio);
-            }
+        // Create SDL_Audio object
+        auto it = SDL_Sounds.find(soundId);
+        if (it == SDL_Sounds.end()) {
+            std::unique_ptr<SDL_Audio> audio;
+            audio = std::make_unique<SDL_Audio>();
+            SDL_Sounds[soundId] = std::move(audio);
+        }
 
-            if (!streamed) {
-                SDL_Sounds[soundId]->audioChunk = chunk;
-            } else {
-                SDL_Sounds[soundId]->music = music;
-                SDL_Sounds[soundId]->isStreaming = true;
-            }
-            SDL_Sounds[soundId]->audioId = soundId;
-
-            Log::log("Successfully loaded audio!");
-            // Log::log("memory usage: " + std::to_string(MemoryTracker::getCurrentUsage() / 1024) + " KB");
-            SDL_Sounds[soundId]->isLoaded = true;
-            SDL_Sounds[soundId]->channelId = SDL_Sounds.size();
-            SDL_Sounds[soundId]->file_size = file_size;
-            playSound(soundId);
-            setSoundVolume(soundId, sprite->volume);
-            return true;
+        if (!streamed) {
+            SDL_Sounds[soundId]->audioChunk = chunk;
+        } else {
+            SDL_Sounds[soundId]->music = music;
+            SDL_Sounds[soundId]->isStreaming = true;
         }
+        SDL_Sounds[soundId]->audioId = soundId;
+
+        Log::log("Successfully loaded audio!");
+        // Log::log("memory usage: " + std::to_string(MemoryTracker::getCurrentUsage() / 1024) + " KB");
+        SDL_Sounds[soundId]->isLoaded = true;
+        SDL_Sounds[soundId]->channelId = SDL_Sounds.size();
+        SDL_Sounds[soundId]->file_size = file_size;
+        playSound(soundId);
+        setSoundVolume(soundId, sprite->volume);
+        return true;
     }
 #endif
     Log::logWarning("Audio not found: " + soundId);
@@ -476,6 +460,7 @@ void SoundPlayer::freeAudio(const std::string &soundId) {
 }
 
 void SoundPlayer::flushAudio() {
+    TRACE_SPAN("SoundPlayer::flushAudio");
 #ifdef ENABLE_AUDIO
     if (SDL_Sounds.empty()) return;
     for (auto &[id, audio] : SDL_Sounds) {
@@ -0,0 +1,57 @@
+#include "framePacer.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+
+namespace {
+
+// the last part of every wait is spun instead of slept, since SDL_Delay() can oversleep by about this much
+constexpr uint64_t spinMs = 2;
+
+} // namespace
+
+bool FramePacer::isFrameDue(int fps) {
+    const uint64_t now = SDL_GetPerformanceCounter();
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t period = std::max<uint64_t>(1, frequency / std::max(fps, 1));
+
+    if (nextFrame == 0) {
+        nextFrame = now + period;
+        stats.frames++;
+        return true;
+    }
+    if (now < nextFrame) return false;
+
+    const uint64_t late = now - nextFrame;
+    const uint64_t missed = late / period;
+    const double jitterMs = (late - missed * period) * 1000.0 / frequency;
+    stats.frames++;
+    stats.droppedFrames += missed;
+    stats.totalJitterMs += jitterMs;
+    stats.maxJitterMs = std::max(stats.maxJitterMs, jitterMs);
+    nextFrame += (missed + 1) * period;
+    return true;
+}
+
+double FramePacer::timeUntilFrame() const {
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if (nextFrame == 0 || now >= nextFrame) return 0;
+    return (nextFrame - now) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void FramePacer::waitForFrame(bool precise) {
+    if (nextFrame == 0) return;
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if (now >= nextFrame) return;
+
+    if (!precise) {
+        // round up, so this never wakes up before the frame is due
+        SDL_Delay(static_cast<Uint32>(((nextFrame - now) * 1000 + frequency - 1) / frequency));
+        return;
+    }
+
+    const uint64_t spin = frequency * spinMs / 1000;
+    if (nextFrame - now > spin) SDL_Delay(static_cast<Uint32>((nextFrame - now - spin) * 1000 / frequency));
+    while (SDL_GetPerformanceCounter() < nextFrame) {
+    }
+}
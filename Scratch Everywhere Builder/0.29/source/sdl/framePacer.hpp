@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Keeps frames evenly spaced at a framerate.
+ * Each frame is scheduled from when the last one was due rather than from when it actually started,
+ * so the framerate doesn't drift, and waiting sleeps for most of the time left before spinning for the rest,
+ * since sleeps can wake up a millisecond or more late.
+ * Frames that would start a whole frame or more late are skipped instead of caught up on, and counted as dropped.
+ */
+class FramePacer {
+  public:
+    struct Stats {
+        // frames that were run, and ones that were skipped because it was already time for the next one
+        uint64_t frames = 0;
+        uint64_t droppedFrames = 0;
+        // how long after their scheduled time frames started, in milliseconds
+        double totalJitterMs = 0;
+        double maxJitterMs = 0;
+    };
+
+    Stats stats;
+
+    /**
+     * Checks whether the next frame is due, and if it is, schedules the one after it.
+     * @param fps Frames per second to keep to
+     * @return `true` if a frame should be run now.
+     */
+    bool isFrameDue(int fps);
+
+    /**
+     * Sleeps until the next frame is due. Doesn't schedule it, so `isFrameDue()` should be called after.
+     * @param precise Whether to spin through the last couple of milliseconds instead of sleeping the whole way,
+     * for when waking up a little late matters more than keeping the CPU busy.
+     */
+    void waitForFrame(bool precise = true);
+
+    /**
+     * Gets how long until the next frame is due.
+     * @return Milliseconds left, or 0 if it's already due (or no frame has been scheduled yet).
+     */
+    double timeUntilFrame() const;
+
+  private:
+    // in `SDL_GetPerformanceCounter()` ticks, or 0 before the first frame
+    uint64_t nextFrame = 0;
+};
@@ -3,12 +3,14 @@
 #include "miniz.h"
 #include "os.hpp"
 #include "render.hpp"
+#include "trace.hpp"
 #include "unzip.hpp"
 #include <algorithm>
 #include <cctype>
 #include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 std::unordered_map<std::string, SDL_Image *> images;
@@ -20,6 +22,20 @@ static std::vector<std::string> toDelete;
 CMRC_DECLARE(romfs);
 #endif
 
+// reads the alpha of a decoded costume, before its pixels only live in the texture
+static CollisionMask createCollisionMask(SDL_Surface *surface, bool isSVG) {
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (converted == NULL) {
+        Log::logWarning(std::string("Error converting image surface: ") + SDL_GetError());
+        return CollisionMask();
+    }
+    SDL_LockSurface(converted);
+    CollisionMask mask(static_cast<const uint8_t *>(converted->pixels), converted->w, converted->h, converted->pitch, isSVG ? 1 : 2);
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return mask;
+}
+
 Image::Image(std::string filePath) {
     if (!loadImageFromFile(filePath, nullptr, false)) return;
     std::string imgId = filePath.substr(0, filePath.find_last_of('.'));
@@ -147,7 +163,7 @@ bool Image::loadImageFromFile(std::string filePath, Sprite *sprite, bool fromScr
     if (Unzip::UnpackedInSD) finalPath = Unzip::filePath + filePath;
     // SDL_Image *image = new SDL_Image(finalPath);
     SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
-    new (image) SDL_Image(finalPath);
+    new (image) SDL_Image(finalPath, fromScratchProject);
 
     // Track texture memory
     if (image->spriteTexture) {
@@ -177,7 +193,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
     // Log::log("Loading single image: " + costumeId);
 
     // Find the file in the zip
-    int file_index = mz_zip_reader_locate_file(zip, costumeId.c_str(), nullptr, 0);
+    int file_index = Unzip::findFile(zip, costumeId);
     if (file_index < 0) {
         Log::logWarning("Image file not found in zip: " + costumeId);
         return;
@@ -206,6 +222,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
         Log::logWarning("File is not a supported image format: " + costumeId);
         return;
     }
+    const bool isSVG = costumeId.size() >= 4 && (costumeId.substr(costumeId.size() - 4) == ".svg" || costumeId.substr(costumeId.size() - 4) == ".SVG");
 
     // Extract file data
     size_t file_size;
@@ -252,6 +269,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
         SDL_FreeSurface(surface);
         return;
     }
+    CollisionMask collisionMask = createCollisionMask(surface, isSVG);
     SDL_FreeSurface(surface);
 
     // Build SDL_Image object
@@ -261,6 +279,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
     SDL_QueryTexture(texture, nullptr, nullptr, &image->width, &image->height);
     image->renderRect = {0, 0, image->width, image->height};
     image->textureRect = {0, 0, image->width, image->height};
+    image->collisionMask = std::move(collisionMask);
 
     // calculate VRAM usage
     Uint32 format;
@@ -281,6 +300,12 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId,
     images[imgId] = image;
 }
 
+const CollisionMask *Image::getCollisionMask(const std::string &costumeId) {
+    auto imageIt = images.find(costumeId);
+    if (imageIt == images.end() || !imageIt->second->collisionMask.isLoaded()) return nullptr;
+    return &imageIt->second->collisionMask;
+}
+
 void Image::cleanupImages() {
     for (auto &[id, image] : images) {
         if (image->memorySize > 0) {
@@ -317,6 +342,7 @@ void Image::freeImage(const std::string &costumeId) {
  * An `SDL_Image` will get freed if it goes unused for 120 frames.
  */
 void Image::FlushImages() {
+    TRACE_SPAN("Image::FlushImages");
 
     // Free images if ram usage is too high
     if (MemoryTracker::getVRAMUsage() + MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxVRAMUsage() * 0.8) {
@@ -365,7 +391,7 @@ void Image::FlushImages() {
 
 SDL_Image::SDL_Image() {}
 
-SDL_Image::SDL_Image(std::string filePath) {
+SDL_Image::SDL_Image(std::string filePath, bool withCollisionMask) {
 #if defined(__PC__) || defined(__PSP__)
     const auto &file = cmrc::romfs::get_filesystem().open(filePath);
     spriteSurface = IMG_Load_RW(SDL_RWFromConstMem(file.begin(), file.size()), 1);
@@ -395,6 +421,11 @@ SDL_Image::SDL_Image(std::string filePath) {
         Log::logWarning(std::string("Error creating texture: ") + SDL_GetError());
         return;
     }
+    if (withCollisionMask) {
+        std::string extension = filePath.size() >= 4 ? filePath.substr(filePath.size() - 4) : "";
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        collisionMask = createCollisionMask(spriteSurface, extension == ".svg");
+    }
     SDL_FreeSurface(spriteSurface);
 
     // get width and height of image
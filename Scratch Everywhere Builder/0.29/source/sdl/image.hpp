@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../scratch/collisionMask.hpp"
 #include <SDL_image.h>
 #include <string>
 #include <unordered_map>
@@ -16,6 +17,7 @@ class SDL_Image {
     int width;
     int height;
     float rotation = 0.0f;
+    CollisionMask collisionMask;
 #ifdef GAMECUBE
     int maxFreeTime = 2;
 #else
@@ -42,8 +44,9 @@ class SDL_Image {
     /**
      * A Simple Image object using SDL.
      * @param filePath
+     * @param withCollisionMask Whether to build `collisionMask` from the decoded pixels, for costumes.
      */
-    SDL_Image(std::string filePath);
+    SDL_Image(std::string filePath, bool withCollisionMask = false);
 
     ~SDL_Image();
 };
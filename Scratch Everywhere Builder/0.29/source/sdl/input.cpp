@@ -249,7 +249,7 @@ void Input::getInput() {
         keyHeldFrames++;
         inputButtons.push_back("any");
         if (keyHeldFrames == 1 || keyHeldFrames > 13)
-            BlockExecutor::runAllBlocksByOpcode("event_whenkeypressed");
+            BlockExecutor::runKeyHats(inputButtons);
     } else keyHeldFrames = 0;
 
     // TODO: Add way to disable touch input (currently overrides mouse input.)
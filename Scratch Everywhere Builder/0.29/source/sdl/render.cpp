@@ -2,6 +2,7 @@
 #include "../scratch/image.hpp"
 #include "audio.hpp"
 #include "blocks/pen.hpp"
+#include "framePacer.hpp"
 #include "image.hpp"
 #include "interpret.hpp"
 #include "math.hpp"
@@ -82,6 +83,29 @@ SDL_GameController *controller;
 bool touchActive = false;
 SDL_Point touchPosition;
 
+namespace {
+
+// menus used to wait a fixed 16 ms after every frame, so they're kept at about that rate
+constexpr int menuFPS = 60;
+FramePacer menuPacer;
+FramePacer projectPacer;
+// the framerate vsync was last set up for
+int vsyncFPS = 0;
+
+// Whether presenting should wait for the display to refresh. The pacer already keeps frames evenly spaced,
+// so this is only needed to stop tearing, and only works when every frame lines up with a refresh.
+// Displays that don't say how fast they refresh keep vsync, since tearing is worse than a slightly uneven framerate.
+bool shouldUseVSync(int fps) {
+    SDL_DisplayMode mode;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &mode) != 0 || mode.refresh_rate <= 0) return true;
+    if (fps <= 0) return false;
+    // refresh rates like 59.94 Hz get reported as 59
+    const double refreshesPerFrame = static_cast<double>(mode.refresh_rate) / fps;
+    return refreshesPerFrame >= 0.95 && std::abs(refreshesPerFrame - std::round(refreshesPerFrame)) < 0.05;
+}
+
+} // namespace
+
 bool Render::Init() {
 #ifdef __WIIU__
     WHBLogUdpInit();
@@ -203,7 +227,8 @@ postAccount:
     IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
     TTF_Init();
     window = SDL_CreateWindow("Scratch Everywhere!", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    vsyncFPS = Scratch::FPS;
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (shouldUseVSync(vsyncFPS) ? SDL_RENDERER_PRESENTVSYNC : 0));
 
     if (SDL_NumJoysticks() > 0) controller = SDL_GameControllerOpen(0);
 
@@ -341,7 +366,9 @@ void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
 
 void Render::endFrame(bool shouldFlush) {
     SDL_RenderPresent(renderer);
-    SDL_Delay(16);
+    // menus don't need to be exact, so this just sleeps instead of spinning through the end of the wait
+    menuPacer.waitForFrame(false);
+    menuPacer.isFrameDue(menuFPS);
     if (shouldFlush) Image::FlushImages();
     hasFrameBegan = false;
 }
@@ -428,16 +455,16 @@ void Render::renderSprites() {
         Sprite *currentSprite = *it;
         if (!currentSprite->visible) continue;
 
-        auto imgFind = images.find(currentSprite->costumes[currentSprite->currentCostume].id);
+        auto imgFind = images.find(currentSprite->data->costumes[currentSprite->currentCostume].id);
         if (imgFind != images.end()) {
             SDL_Image *image = imgFind->second;
             image->freeTimer = image->maxFreeTime;
-            currentSprite->rotationCenterX = currentSprite->costumes[currentSprite->currentCostume].rotationCenterX;
-            currentSprite->rotationCenterY = currentSprite->costumes[currentSprite->currentCostume].rotationCenterY;
+            currentSprite->rotationCenterX = currentSprite->data->costumes[currentSprite->currentCostume].rotationCenterX;
+            currentSprite->rotationCenterY = currentSprite->data->costumes[currentSprite->currentCostume].rotationCenterY;
             currentSprite->spriteWidth = image->textureRect.w >> 1;
             currentSprite->spriteHeight = image->textureRect.h >> 1;
             SDL_RendererFlip flip = SDL_FLIP_NONE;
-            const bool isSVG = currentSprite->costumes[currentSprite->currentCostume].isSVG;
+            const bool isSVG = currentSprite->data->costumes[currentSprite->currentCostume].isSVG;
             calculateRenderPosition(currentSprite, isSVG);
             image->renderRect.x = currentSprite->renderInfo.renderX;
             image->renderRect.y = currentSprite->renderInfo.renderY;
@@ -532,6 +559,32 @@ void Render::renderPenLayer() {
     SDL_RenderCopy(renderer, penTexture, NULL, &renderRect);
 }
 
+bool Render::checkFramerate() {
+    // turbo mode runs ticks as fast as it can, but frames are still only presented at the project's framerate
+    if (!projectPacer.isFrameDue(Scratch::FPS)) return false;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // projects can set their own framerate, which might not line up with the display anymore
+    if (Scratch::FPS != vsyncFPS) {
+        vsyncFPS = Scratch::FPS;
+        SDL_RenderSetVSync(renderer, shouldUseVSync(vsyncFPS) ? 1 : 0);
+    }
+#endif
+    return true;
+}
+
+FramePacer::Stats Render::getFramePacingStats() {
+    return projectPacer.stats;
+}
+
+double Render::timeUntilFrame() {
+    return projectPacer.timeUntilFrame();
+}
+
+void Render::waitForFrame() {
+    projectPacer.waitForFrame();
+}
+
 bool Render::appShouldRun() {
     if (toExit) return false;
     SDL_Event event;